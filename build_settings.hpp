@@ -31,4 +31,63 @@
 # endif
 
 
+/* [ HEADER_ONLY ]
+ *   Compile the allocators into every file that includes EMMA.hpp.
+ *
+ *   If enabled, EMMA.hpp also includes the implementation of every allocator,
+ *   so there is no library to build or link against. Every function can then
+ *   be inlined into the caller, which matters most for the small & hot ones,
+ *   like allocating from a pool or freeing into a free list.
+ *
+ *   If disabled, the allocators are built into libEMMA.a as usual.
+ *
+ *   The option has to be the same in every file of a project.
+ *
+ *   0 = OFF, 1 = ON. */
+# ifndef EMMA_HEADER_ONLY
+#  define EMMA_HEADER_ONLY 0
+# endif
+
+
+/* [ ENABLE_STATS ]
+ *   Count what the allocators are doing, see get_stats() & Stats.hpp.
+ *
+ *   If enabled, allocating & freeing also update a few counters:
+ *   allocations, frees, failures, merges & the bytes in use.
+ *
+ *   If disabled, none of the counters exist, and allocating & freeing compile
+ *   to exactly the same code as if this option didn't exist.
+ *   get_stats() still measures the free blocks, only the counters are 0.
+ *
+ *   The option has to be the same in every file of a project.
+ *
+ *   0 = OFF, 1 = ON. */
+# ifndef EMMA_ENABLE_STATS
+#  define EMMA_ENABLE_STATS 0
+# endif
+
+
+
+/* [ COMPACT_FREELIST ]
+ *   Smaller headers & tree nodes for the FreeList, for small memories.
+ *
+ *   If enabled, the size in each block's header & the links between tree
+ *   nodes are stored in 32 bits instead of 64. The color of a node is kept
+ *   in the lowest bit of it's parent link.
+ *
+ *   That makes a header 4 bytes instead of 8 & a node 20 instead of 48,
+ *   so FreeList::MIN_BLOCK_SIZE goes from 64 to 28 bytes. Every allocation
+ *   takes at least that much, so far more small allocations fit.
+ *   A FreeList can then only use up to 2 GiB of memory, the rest is left unused.
+ *
+ *   If disabled, headers are a std::size_t & nodes are made of normal pointers.
+ *
+ *   The option has to be the same in every file of a project.
+ *
+ *   0 = OFF, 1 = ON. */
+# ifndef EMMA_COMPACT_FREELIST
+#  define EMMA_COMPACT_FREELIST 0
+# endif
+
+
 #endif
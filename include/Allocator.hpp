@@ -0,0 +1,171 @@
+
+/* [ STATIC ALLOCATOR FRONT-END HEADER FILE ]
+ *
+ *   This is NOT derived from the base allocator class.
+ *
+ *   Wraps one of the allocators (the policy) & gives it the same interface as
+ *   BaseAllocator, but every call goes straight to the policy's own function.
+ *   Nothing is dispatched through the vtable, so the compiler knows exactly
+ *   which function is called & can inline it. Especially so with
+ *   EMMA_HEADER_ONLY, where the implementations are in the headers too.
+ *
+ *   The price is that an Allocator<FreeList> can't be passed around as a
+ *   BaseAllocator&. get_policy() gives access to the allocator itself,
+ *   for anything it has in addition to the common interface.
+ *
+ *   emma::Allocator<emma::allocators::FreeList> EMMA(memory, size);
+ *   MyClass* ptr = EMMA.allocate_class<MyClass>(42); */
+
+#ifndef ALLOCATOR_HPP
+# define ALLOCATOR_HPP
+
+# include <EMMA.hpp>
+# include <Arena.hpp>
+# include <new>
+# include <memory>
+# include <utility>
+# include <type_traits>
+# include <cstddef>
+# include <stdint.h>
+
+namespace emma
+{
+	template <class Policy>
+	class Allocator
+	{
+		// A policy that can still be derived from can't be called without the vtable
+		static_assert(std::is_base_of<emma::BaseAllocator, Policy>::value,
+			"The policy has to be one of the allocators");
+		static_assert(std::is_final<Policy>::value,
+			"The policy has to be final");
+
+		// Arena registers destructors in it's own class functions
+		static constexpr bool IS_ARENA = std::is_same<Policy, emma::allocators::Arena>::value;
+
+		public:
+			// Arguments are given to the policy's constructor
+			template <typename... Args>
+			explicit Allocator(Args&&... A) : m_policy(std::forward<Args>(A)...) {}
+			~Allocator() {}
+
+			Allocator(const Allocator&) = delete;
+			Allocator& operator=(const Allocator&) = delete;
+
+			template <class T, typename... Args>
+			T*	allocate_class(Args&&... A)
+			{
+				if constexpr (IS_ARENA)
+					return m_policy.template allocate_class<T>(std::forward<Args>(A)...);
+
+				void* ptr = allocate_raw_ptr(sizeof(T), alignof(T));
+
+				if (ptr != NULL)
+					new(ptr) T(std::forward<Args>(A)...);
+
+				return ( static_cast<T*>(ptr) );
+			}
+
+			template <class T>
+			void	free_class(T* ptr_to_class)
+			{
+				if constexpr (IS_ARENA)
+					return m_policy.free_class(ptr_to_class);
+
+				if (ptr_to_class == NULL)
+					return;
+				std::destroy_at(ptr_to_class);
+				free_raw_ptr(static_cast<void*>(ptr_to_class));
+			}
+
+			// Same layout as BaseAllocator's, so either one can free them
+			template <class T, typename... Args>
+			T*	allocate_array(std::size_t count, Args&&... A)
+			{
+				if constexpr (IS_ARENA)
+					return m_policy.template allocate_array<T>(count, std::forward<Args>(A)...);
+
+				std::size_t offset = emma::BaseAllocator::array_offset<T>();
+				if (count == 0 || count > (SIZE_MAX - offset) / sizeof(T))
+					return NULL;
+
+				void* ptr = allocate_raw_ptr(offset + count * sizeof(T), emma::BaseAllocator::array_alignment<T>());
+				if (ptr == NULL)
+					return NULL;
+				return emma::BaseAllocator::construct_array<T>(ptr, count, A...);
+			}
+
+			template <class T>
+			void	free_array(T* array)
+			{
+				if constexpr (IS_ARENA)
+					return m_policy.free_array(array);
+
+				if (array == NULL)
+					return;
+				std::destroy_n(array, emma::BaseAllocator::array_count(array));
+				free_raw_ptr(static_cast<void*>(\
+					reinterpret_cast<uint8_t*>(array) - emma::BaseAllocator::array_offset<T>()));
+			}
+
+			// The qualified calls are what keep these out of the vtable
+			void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+			{
+				return m_policy.Policy::allocate_raw_ptr(data_size, alignment);
+			}
+
+			void*	allocate_raw_ptr(std::size_t data_size)
+			{
+				return allocate_raw_ptr(data_size, emma::BaseAllocator::get_natural_alignment(data_size));
+			}
+
+			void	free_raw_ptr(void *data)
+			{
+				m_policy.Policy::free_raw_ptr(data);
+			}
+
+			void*	reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment)
+			{
+				return m_policy.Policy::reallocate_raw_ptr(ptr, new_size, alignment);
+			}
+
+			// Data at ptr can't need more alignment than ptr has, so that's kept
+			void*	reallocate_raw_ptr(void* ptr, std::size_t new_size)
+			{
+				std::size_t alignment = emma::BaseAllocator::get_natural_alignment(new_size);
+				std::size_t ptr_alignment = static_cast<std::size_t>(\
+					reinterpret_cast<uintptr_t>(ptr) & (~reinterpret_cast<uintptr_t>(ptr) + 1));
+				if (ptr != NULL && ptr_alignment < alignment)
+					alignment = ptr_alignment;
+				return reallocate_raw_ptr(ptr, new_size, alignment);
+			}
+
+			std::size_t	usable_size(void* ptr)
+			{
+				return m_policy.Policy::usable_size(ptr);
+			}
+
+			std::size_t	allocate_bulk(std::size_t data_size, std::size_t count,
+						void** out_ptrs, std::size_t alignment)
+			{
+				return m_policy.Policy::allocate_bulk(data_size, count, out_ptrs, alignment);
+			}
+
+			void	free_bulk(void** ptrs, std::size_t count)
+			{
+				m_policy.Policy::free_bulk(ptrs, count);
+			}
+
+			emma::Stats	get_stats() const
+			{
+				return m_policy.Policy::get_stats();
+			}
+
+			Policy&			get_policy() { return m_policy; }
+			const Policy&	get_policy() const { return m_policy; }
+
+		private:
+			Policy	m_policy;
+	};
+};
+
+#endif
@@ -0,0 +1,172 @@
+
+/* [ ARENA ALLOCATOR HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   Implements a monotonic (bump pointer) arena.
+ *   Memory is never freed one allocation at a time, reset() frees all of it.
+ *   More detailed overview of the algorithm can be found inside the .cpp file */
+
+#ifndef ARENA_HPP
+# define ARENA_HPP
+
+# include <EMMA.hpp>
+# include <stdint.h>
+# include <type_traits>
+# include <memory>
+# include <new>
+
+namespace emma
+{
+	namespace allocators
+	{
+		class Arena final : public emma::BaseAllocator
+		{
+			public:
+				Arena(void* memory_location, std::size_t memory_maxsize);
+				~Arena();
+
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+				void	free_raw_ptr(void *data) override;
+
+				using emma::BaseAllocator::reallocate_raw_ptr;
+				void*		reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment) override;
+				std::size_t	usable_size(void* ptr) override;
+
+				// Destroys registered classes in reverse order, frees everything
+				void	reset();
+
+				// Same as BaseAllocator's, except that classes with a destructor
+				// are registered, so that reset() will destroy them.
+				// Also goes for allocate/free_class_bulk() & allocate/free_array().
+				// These have to be called through an Arena, not a BaseAllocator.
+				template <class T, typename... Args>
+				T* allocate_class(Args&&... A)
+				{
+					if (std::is_trivially_destructible<T>::value)
+					{
+						void* ptr = allocate_raw_ptr(sizeof(T), alignof(T));
+						if (ptr != NULL)
+							new(ptr) T(std::forward<Args>(A)...);
+						return ( static_cast<T*>(ptr) );
+					}
+
+					DestructorEntry* entry = allocate_with_entry(sizeof(T), alignof(T));
+					if (entry == NULL)
+						return NULL;
+
+					T* ptr = new(static_cast<void*>(entry + 1)) T(std::forward<Args>(A)...);
+
+					// Only registered once the constructor has succeeded
+					entry->destroy = &destroy_object<T>;
+					entry->prev = this->m_destructors;
+					this->m_destructors = entry;
+					return ptr;
+				}
+
+				template <class T>
+				void	free_class(T* ptr_to_class)
+				{
+					if (ptr_to_class == NULL)
+						return;
+					std::destroy_at(ptr_to_class);
+
+					// Keep reset() from destroying it a second time
+					if (!std::is_trivially_destructible<T>::value)
+						(reinterpret_cast<DestructorEntry*>(ptr_to_class) - 1)->destroy = NULL;
+				}
+
+				// Allocating is just a bump, so there is nothing to share between them
+				template <class T, typename... Args>
+				std::size_t	allocate_class_bulk(std::size_t count, T** out_classes, Args&&... A)
+				{
+					std::size_t allocated = 0;
+					while (allocated < count)
+					{
+						T* ptr = allocate_class<T>(A...);
+						if (ptr == NULL)
+							break;
+						out_classes[allocated++] = ptr;
+					}
+					return allocated;
+				}
+
+				template <class T>
+				void	free_class_bulk(T** classes, std::size_t count)
+				{
+					for (std::size_t i = 0; i < count; ++i)
+						free_class(classes[i]);
+				}
+
+				// The whole array gets one entry, which destroys every element
+				template <class T, typename... Args>
+				T*	allocate_array(std::size_t count, Args&&... A)
+				{
+					if (std::is_trivially_destructible<T>::value)
+						return emma::BaseAllocator::allocate_array<T>(count, std::forward<Args>(A)...);
+					if (count == 0 || count > (SIZE_MAX - array_offset<T>()) / sizeof(T))
+						return NULL;
+
+					DestructorEntry* entry = allocate_with_entry(\
+						array_offset<T>() + count * sizeof(T), array_alignment<T>());
+					if (entry == NULL)
+						return NULL;
+
+					T* array = construct_array<T>(static_cast<void*>(entry + 1), count, A...);
+					entry->destroy = &destroy_array<T>;
+					entry->prev = this->m_destructors;
+					this->m_destructors = entry;
+					return array;
+				}
+
+				template <class T>
+				void	free_array(T* array)
+				{
+					if (array == NULL)
+						return;
+					std::destroy_n(array, array_count(array));
+
+					if (!std::is_trivially_destructible<T>::value)
+					{
+						uint8_t* ptr = reinterpret_cast<uint8_t*>(array) - array_offset<T>();
+						(reinterpret_cast<DestructorEntry*>(ptr) - 1)->destroy = NULL;
+					}
+				}
+
+			private:
+				// Placed right in front of every class which has a destructor
+				class DestructorEntry
+				{
+					public:
+						DestructorEntry() : destroy(NULL), prev(NULL) {}
+						~DestructorEntry() {}
+
+						void				(*destroy)(void* object);
+						DestructorEntry*	prev;
+				};
+
+				uint8_t*	m_top; // Next free byte
+				uint8_t*	m_last; // Newest allocation, NULL if unknown
+				uint8_t*	m_end; // End of memory available
+				DestructorEntry*	m_destructors; // Most recently registered
+
+				template <class T>
+				static void	destroy_object(void* object)
+				{
+					std::destroy_at(static_cast<T*>(object));
+				}
+
+				template <class T>
+				static void	destroy_array(void* ptr)
+				{
+					T* array = reinterpret_cast<T*>(static_cast<uint8_t*>(ptr) + array_offset<T>());
+					std::destroy_n(array, array_count(array));
+				}
+
+				DestructorEntry*	allocate_with_entry(std::size_t data_size, std::size_t alignment);
+		};
+	};
+};
+
+#endif
@@ -5,7 +5,8 @@
  *   Allocators belonging to a specific algorithm will inherit this class.
  *
  *   They will override the functions that allocate/free raw pointers.
- *   free/allocate_class() works as an interface/wrapper for said functions.
+ *   free/allocate_class() & free/allocate_array() work as an interface/wrapper
+ *   for said functions.
  */
 
 #ifndef BASEALLOCATOR_HPP
@@ -13,11 +14,21 @@
 
 # include <EMMA.hpp>
 # include <new>
+# include <memory>
+# include <utility>
+# include <type_traits>
+# include <cstddef>
+# include <cstring>
+# include <stdint.h>
 
 namespace emma
 {
 	class BaseAllocator
 	{
+		// Uses the array layout & alignment helpers, without being an allocator
+		template <class Policy>
+		friend class Allocator;
+
 		public:
 			BaseAllocator(void* memory_location, std::size_t memory_maxsize) :
 			m_memory_location(memory_location), m_memory_maxsize(memory_maxsize) {}
@@ -25,12 +36,12 @@ namespace emma
 			virtual ~BaseAllocator() {}
 
 			template <class T, typename... Args>
-			T* allocate_class(Args... A)
+			T* allocate_class(Args&&... A)
 			{
-				void* ptr = allocate_raw_ptr(sizeof(T));
+				void* ptr = allocate_raw_ptr(sizeof(T), alignof(T));
 
 				if (ptr != NULL)
-					new(ptr) T(A...);
+					new(ptr) T(std::forward<Args>(A)...);
 
 				return ( static_cast<T*>(ptr) );
 			}
@@ -44,14 +55,264 @@ namespace emma
 				free_raw_ptr(static_cast<void*>(ptr_to_class));
 			}
 
+			// Goes through allocate/free_bulk() a chunk at a time.
+			// Returns how many classes were made, always at the start of the array.
+			template <class T, typename... Args>
+			std::size_t	allocate_class_bulk(std::size_t count, T** out_classes, Args&&... A)
+			{
+				void*		chunk[BULK_CHUNK_SIZE];
+				std::size_t	allocated = 0;
+
+				while (allocated < count)
+				{
+					std::size_t wanted = count - allocated;
+					wanted = wanted < BULK_CHUNK_SIZE ? wanted : BULK_CHUNK_SIZE;
+					std::size_t made = allocate_bulk(sizeof(T), wanted, chunk, alignof(T));
+
+					for (std::size_t i = 0; i < made; ++i)
+						out_classes[allocated++] = new(chunk[i]) T(A...);
+					if (made < wanted)
+						break;
+				}
+				return allocated;
+			}
+
+			template <class T>
+			void	free_class_bulk(T** classes, std::size_t count)
+			{
+				void*		chunk[BULK_CHUNK_SIZE];
+				std::size_t	chunk_count = 0;
+
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					if (classes[i] == NULL)
+						continue;
+					std::destroy_at(classes[i]);
+					chunk[chunk_count++] = static_cast<void*>(classes[i]);
+					if (chunk_count == BULK_CHUNK_SIZE)
+					{
+						free_bulk(chunk, chunk_count);
+						chunk_count = 0;
+					}
+				}
+				free_bulk(chunk, chunk_count);
+			}
+
+			// One allocation for all of the elements, with the count in front.
+			// The arguments are given to every element, so they can't be moved.
+			template <class T, typename... Args>
+			T*	allocate_array(std::size_t count, Args&&... A)
+			{
+				if (count == 0 || count > (SIZE_MAX - array_offset<T>()) / sizeof(T))
+					return NULL;
+
+				void* ptr = allocate_raw_ptr(array_offset<T>() + count * sizeof(T), array_alignment<T>());
+				if (ptr == NULL)
+					return NULL;
+				return construct_array<T>(ptr, count, A...);
+			}
+
+			template <class T>
+			void	free_array(T* array)
+			{
+				if (array == NULL)
+					return;
+				std::destroy_n(array, array_count(array));
+				free_raw_ptr(static_cast<void*>(reinterpret_cast<uint8_t*>(array) - array_offset<T>()));
+			}
+
+			template <class T>
+			static std::size_t	get_array_size(const T* array)
+			{
+				return (array == NULL ? 0 : array_count(array));
+			}
+
 			// These are responsible for actually managing the memory
 			// The user may also access them directly to allocate raw pointers
-			virtual void*	allocate_raw_ptr(std::size_t data_size) = 0;
+			// Alignment must be a power of two.
+			virtual void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) = 0;
 			virtual void	free_raw_ptr(void *data) = 0;
 
+			// Aligned to the largest alignment a type of this size could need
+			void*	allocate_raw_ptr(std::size_t data_size)
+			{
+				return allocate_raw_ptr(data_size, get_natural_alignment(data_size));
+			}
+
+			// Makes 'count' allocations of the same size. Allocators override this
+			// to share the work between them. By default it's just a loop.
+			// Returns how many succeeded, they are always at the start of the array.
+			virtual std::size_t	allocate_bulk(std::size_t data_size, std::size_t count,
+								void** out_ptrs, std::size_t alignment)
+			{
+				std::size_t allocated = 0;
+				while (allocated < count)
+				{
+					void* ptr = allocate_raw_ptr(data_size, alignment);
+					if (ptr == NULL)
+						break; // Also throws an exception if they're enabled
+					out_ptrs[allocated++] = ptr;
+				}
+				return allocated;
+			}
+
+			std::size_t	allocate_bulk(std::size_t data_size, std::size_t count, void** out_ptrs)
+			{
+				return allocate_bulk(data_size, count, out_ptrs, get_natural_alignment(data_size));
+			}
+
+			// Frees every pointer in the array, NULLs are skipped.
+			// The order of the array may be changed.
+			virtual void	free_bulk(void** ptrs, std::size_t count)
+			{
+				for (std::size_t i = 0; i < count; ++i)
+					free_raw_ptr(ptrs[i]);
+			}
+
+			// Bytes which may be used at ptr, at least what was asked for.
+			// 0 if the allocator doesn't know (Arena & Stack, see their docs)
+			virtual std::size_t	usable_size(void* ptr) = 0;
+
+			// Works like C's realloc(). Allocators override this to resize in place.
+			// By default it only stays in place if the new size already fits.
+			virtual void*	reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment)
+			{
+				if (ptr == NULL || alignment_is_invalid(alignment))
+					return allocate_raw_ptr(new_size, alignment); // Invalid alignment fails here
+				if (new_size == 0)
+				{
+					free_raw_ptr(ptr);
+					return NULL;
+				}
+
+				std::size_t old_size = usable_size(ptr);
+				if (new_size <= old_size && reinterpret_cast<uintptr_t>(ptr) % alignment == 0)
+					return ptr;
+
+				void* new_ptr = allocate_raw_ptr(new_size, alignment);
+				if (new_ptr == NULL)
+					return NULL; // The old data stays where it was
+				std::memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+				free_raw_ptr(ptr);
+				return new_ptr;
+			}
+
+			// Data at ptr can't need more alignment than ptr has, so that's kept
+			void*	reallocate_raw_ptr(void* ptr, std::size_t new_size)
+			{
+				std::size_t alignment = get_natural_alignment(new_size);
+				std::size_t ptr_alignment = static_cast<std::size_t>(\
+					reinterpret_cast<uintptr_t>(ptr) & (~reinterpret_cast<uintptr_t>(ptr) + 1));
+				if (ptr != NULL && ptr_alignment < alignment)
+					alignment = ptr_alignment;
+				return reallocate_raw_ptr(ptr, new_size, alignment);
+			}
+
+			void*		get_memory_location() const { return m_memory_location; }
+			std::size_t	get_memory_maxsize() const { return m_memory_maxsize; }
+
+			// Snapshot of the counters, see Stats.hpp. Allocators that can
+			// measure their free blocks override this to add them in.
+			virtual emma::Stats	get_stats() const
+			{
+				# if EMMA_ENABLE_STATS
+				return m_stats;
+				# else
+				return emma::Stats();
+				# endif
+			}
+
 		protected:
 			void*		m_memory_location;
 			std::size_t	m_memory_maxsize;
+
+			// Only updated through EMMA_STATS(), so it's all gone when disabled
+			# if EMMA_ENABLE_STATS
+			emma::Stats	m_stats;
+
+			void	count_allocation(std::size_t bytes)
+			{
+				++m_stats.allocations;
+				++m_stats.live_allocations;
+				m_stats.bytes_in_use += bytes;
+				if (m_stats.bytes_in_use > m_stats.peak_bytes_in_use)
+					m_stats.peak_bytes_in_use = m_stats.bytes_in_use;
+			}
+
+			void	count_free(std::size_t bytes)
+			{
+				++m_stats.frees;
+				--m_stats.live_allocations;
+				m_stats.bytes_in_use -= bytes;
+			}
+
+			void	count_resize(std::size_t old_bytes, std::size_t new_bytes)
+			{
+				m_stats.bytes_in_use += new_bytes - old_bytes;
+				if (m_stats.bytes_in_use > m_stats.peak_bytes_in_use)
+					m_stats.peak_bytes_in_use = m_stats.bytes_in_use;
+			}
+			# endif
+
+			// Amount of classes allocate/free_class_bulk() pass on at once
+			static constexpr std::size_t	BULK_CHUNK_SIZE = 64;
+
+			// Arrays have their count right in front of the first element.
+			// The offset keeps the elements aligned, the count is at it's end.
+			template <class T>
+			static constexpr std::size_t	array_alignment()
+			{
+				return (alignof(T) > alignof(std::size_t) ? alignof(T) : alignof(std::size_t));
+			}
+
+			template <class T>
+			static constexpr std::size_t	array_offset()
+			{
+				return ((sizeof(std::size_t) + array_alignment<T>() - 1) / array_alignment<T>() * array_alignment<T>());
+			}
+
+			template <class T>
+			static std::size_t	array_count(const T* array)
+			{
+				return *(reinterpret_cast<const std::size_t*>(array) - 1);
+			}
+
+			// Default constructed types use the standard library's fast paths,
+			// so do trivial types which are all made from the same arguments.
+			template <class T, typename... Args>
+			static T*	construct_array(void* ptr, std::size_t count, Args&... A)
+			{
+				uint8_t* position = static_cast<uint8_t*>(ptr) + array_offset<T>();
+				new(position - sizeof(std::size_t)) std::size_t(count);
+				T* array = reinterpret_cast<T*>(position);
+
+				if constexpr (sizeof...(Args) == 0)
+					std::uninitialized_value_construct_n(array, count);
+				else if constexpr (std::is_trivially_copyable<T>::value)
+					std::uninitialized_fill_n(array, count, T(A...));
+				else
+				{
+					for (std::size_t i = 0; i < count; ++i)
+						new(array + i) T(A...);
+				}
+				return array;
+			}
+
+			// Largest alignment any type of this size could have.
+			// That is the lowest set bit of the size, at most std::max_align_t.
+			// A size of 0 has no set bit, it gets the largest so it stays valid.
+			static std::size_t	get_natural_alignment(std::size_t data_size)
+			{
+				std::size_t alignment = data_size & (~data_size + 1);
+				if (alignment == 0 || alignment > alignof(std::max_align_t))
+					return alignof(std::max_align_t);
+				return alignment;
+			}
+
+			static bool	alignment_is_invalid(std::size_t alignment)
+			{
+				return (alignment == 0 || (alignment & (alignment - 1)) != 0);
+			}
 	};
 };
 
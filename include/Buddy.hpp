@@ -0,0 +1,69 @@
+
+/* [ BUDDY ALLOCATOR HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   Implements a binary buddy system. Every block is a power of two in size,
+ *   and is split in half / merged with it's buddy as needed.
+ *   More detailed overview of the algorithm can be found inside the .cpp file */
+
+#ifndef BUDDY_HPP
+# define BUDDY_HPP
+
+# include <EMMA.hpp>
+# include <stdint.h>
+
+namespace emma
+{
+	namespace allocators
+	{
+		class Buddy final : public emma::BaseAllocator
+		{
+			public:
+				Buddy(void* memory_location, std::size_t memory_maxsize);
+				~Buddy();
+
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+				void	free_raw_ptr(void *data) override;
+
+				std::size_t	usable_size(void* ptr) override;
+
+				// Smallest block, which has to fit a free list link
+				static constexpr unsigned int MIN_ORDER = 4;
+				static constexpr std::size_t MIN_BLOCK_SIZE = 1 << MIN_ORDER;
+
+			private:
+				static constexpr unsigned int ORDER_COUNT = 64;
+
+				// Stored inside of free blocks
+				class FreeBlock
+				{
+					public:
+						FreeBlock() : next(NULL), prev(NULL) {}
+						~FreeBlock() {}
+
+						FreeBlock*	next;
+						FreeBlock*	prev;
+				};
+
+				uint8_t*	m_first_block;
+				unsigned int	m_max_order; // The whole tree is 2^max_order bytes
+
+				// One list per order, and a bit for every order with a free block
+				FreeBlock*	m_free_lists[ORDER_COUNT];
+				uint64_t	m_nonempty_orders;
+
+				// One bit per node of the tree. Stored in front of the blocks.
+				uint8_t*	m_split_bits; // Node has been split in half
+				uint8_t*	m_free_bits;  // Node is a free block in a free list
+
+				std::size_t	get_node_index(std::size_t offset, unsigned int order) const;
+				unsigned int	find_block(std::size_t& offset) const;
+				void		push_free_block(std::size_t offset, unsigned int order);
+				void		remove_free_block(std::size_t offset, unsigned int order);
+		};
+	};
+};
+
+#endif
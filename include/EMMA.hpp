@@ -14,9 +14,37 @@
 # include <exception>
 # include <stdbool.h>
 # include "../build_settings.hpp"
+
+// Functions defined in the allocators' .cpp files, inline if they are in a header
+# if EMMA_HEADER_ONLY
+#  define EMMA_INLINE inline
+# else
+#  define EMMA_INLINE
+# endif
+
+// Code which only updates the statistics, gone if they're disabled
+# if EMMA_ENABLE_STATS
+#  define EMMA_STATS(...) __VA_ARGS__
+# else
+#  define EMMA_STATS(...)
+# endif
+
+# include "Stats.hpp"
 # include "BaseAllocator.hpp"
 # include "RedBlackTree.hpp"
 # include "FreeList.hpp"
+# include "Slab.hpp"
+# include "SharedFreeList.hpp"
+# include "ThreadCache.hpp"
+# include "Pool.hpp"
+# include "Arena.hpp"
+# include "Stack.hpp"
+# include "Buddy.hpp"
+# include "TLSF.hpp"
+# include "Allocator.hpp"
+# include "MemoryResource.hpp"
+# include "StdAllocator.hpp"
+# include "TraceRecorder.hpp"
 
 namespace emma
 {
@@ -41,9 +69,13 @@ namespace emma
 	 *
 	 * This function is very useful as there are a lot of cases where we want
 	 * to throw an exception if they are enabled, but return if they aren't.
-	 * This allows one liners like: return error_return<void*>(NULL, "Oh-no!") */
+	 * This allows one liners like: return error_return<void*>(NULL, "Oh-no!")
+	 *
+	 * The message is only turned into an std::string when it's thrown,
+	 * so that nothing is allocated from the heap when exceptions are disabled.
+	 * The malloc shim relies on this, as it would otherwise call itself. */
 	template <class T>
-	T return_error(T return_value, const std::string& message)
+	T return_error(T return_value, const char* message)
 	{
 		# if EMMA_ENABLE_EXCEPTIONS
 			throw emma::ExceptionWithMessage(message);
@@ -54,5 +86,19 @@ namespace emma
 	}
 };
 
+// The implementations, compiled into every file that includes this header
+# if EMMA_HEADER_ONLY
+#  include "../src/allocators/FreeList.cpp"
+#  include "../src/allocators/RedBlackTree.cpp"
+#  include "../src/allocators/Slab.cpp"
+#  include "../src/allocators/SharedFreeList.cpp"
+#  include "../src/allocators/ThreadCache.cpp"
+#  include "../src/allocators/Pool.cpp"
+#  include "../src/allocators/Arena.cpp"
+#  include "../src/allocators/Stack.cpp"
+#  include "../src/allocators/Buddy.cpp"
+#  include "../src/allocators/TLSF.cpp"
+#  include "../src/allocators/TraceRecorder.cpp"
+# endif
 
 #endif
@@ -13,50 +13,214 @@
 # include <EMMA.hpp>
 # include <RedBlackTree.hpp>
 # include <memory>
+# include <cstdio>
+# include <limits>
+# include <stdint.h>
 
 namespace emma
 {
 	namespace allocators
 	{
-		class FreeList : public emma::BaseAllocator
+		class FreeList final : public emma::BaseAllocator
 		{
 			public:
-				FreeList(void* memory_location, std::size_t memory_maxsize);
+				// A persistent heap lives in a region that can be mapped again later,
+				// after a superblock describing it. See the constructor.
+				enum PersistentMode { CREATE_PERSISTENT, OPEN_EXISTING };
+
+				FreeList(void* memory_location, std::size_t memory_maxsize, bool deferred_coalescing = false);
+				FreeList(PersistentMode mode, void* region, std::size_t region_size);
 				~FreeList();
 
-				void*	allocate_raw_ptr(std::size_t data_size) override;
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
 				void	free_raw_ptr(void *data) override;
 
-				class Header
+				using emma::BaseAllocator::reallocate_raw_ptr;
+				void*		reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment) override;
+				std::size_t	usable_size(void* ptr) override;
+
+				using emma::BaseAllocator::allocate_bulk;
+				std::size_t	allocate_bulk(std::size_t data_size, std::size_t count,
+							void** out_ptrs, std::size_t alignment) override;
+				void		free_bulk(void** ptrs, std::size_t count) override;
+
+				emma::Stats	get_stats() const override;
+
+				// Only does anything with deferred coalescing, see the constructor
+				std::size_t	consolidate(std::size_t max_blocks = std::numeric_limits<std::size_t>::max());
+
+				static constexpr std::size_t PERSISTENT_ROOT_COUNT = 16;
+				static constexpr std::size_t PERSISTENT_ROOT_NAME_SIZE = 32; // Terminating NUL included
+				static constexpr uint64_t PERSISTENT_MAGIC = 0x454D4D4148454150; // "EMMAHEAP"
+				static constexpr uint32_t PERSISTENT_VERSION = 1;
+				// Data stays aligned up to this much, if the region is opened at the same alignment
+				static constexpr uint32_t PERSISTENT_MAX_ALIGNMENT = 4096;
+
+				class PersistentSuperblock // At the start of a persistent region, before the heap
+				{
+					public:
+						uint64_t	magic;
+						uint32_t	version;
+						uint32_t	header_size; // A heap can only be opened by a FreeList with
+						uint32_t	min_block_size; // the same sizes, see EMMA_COMPACT_FREELIST
+						uint32_t	region_alignment; // Of the region when created, up to PERSISTENT_MAX_ALIGNMENT
+						uint64_t	region_size;
+						uint64_t	root_offsets[PERSISTENT_ROOT_COUNT]; // From the region's start, 0 if unused
+						char		root_names[PERSISTENT_ROOT_COUNT][PERSISTENT_ROOT_NAME_SIZE];
+				};
+
+				static bool	has_persistent_heap(const void* region, std::size_t region_size);
+				bool		set_root(const char* name, void* ptr);
+				void*		get_root(const char* name) const;
+
+				class BlockInfo // One block of the heap, filled in by walk_heap()
 				{
 					public:
-						Header(Header* nxt, Header* prv) : next(nxt), prev(prv), node(NULL) {}
+						BlockInfo() : address(NULL), size(0), padding(0), is_free(false) {}
+						~BlockInfo() {}
+
+						void*		address; // Of the block's header. NULL to start a walk.
+						std::size_t	size; // From the header to the next block, or to the end of memory
+						std::size_t	padding; // Lost to alignment in front of the header
+						bool		is_free;
+				};
+
+				// Bucket i counts the free blocks of [2^i, 2^(i+1)) usable bytes
+				static constexpr std::size_t HISTOGRAM_SIZE = sizeof(std::size_t) * 8;
+
+				class Fragmentation // Summary of every block, made by get_fragmentation()
+				{
+					public:
+						Fragmentation() : block_count(0), free_block_count(0), used_bytes(0),
+						free_bytes(0), largest_free_block(0), header_bytes(0), padding_bytes(0),
+						external_ratio(0.0), free_size_histogram() {}
+
+						~Fragmentation() {}
+
+						std::size_t	block_count;
+						std::size_t	free_block_count;
+						std::size_t	used_bytes; // Of the used blocks, headers excluded
+						std::size_t	free_bytes; // Same for the free blocks
+						std::size_t	largest_free_block;
+						std::size_t	header_bytes;
+						std::size_t	padding_bytes;
+						double		external_ratio; // 1 - largest_free_block / free_bytes
+						std::size_t	free_size_histogram[HISTOGRAM_SIZE];
+				};
+
+				bool			walk_heap(BlockInfo& block) const;
+				Fragmentation	get_fragmentation() const;
+				void			dump_heap(std::FILE* stream, bool as_csv = false) const;
+
+				class Header // Boundary tag, the only thing in front of every block
+				{
+					public:
+						# if EMMA_COMPACT_FREELIST
+						typedef uint32_t	Tag; // Blocks of a compact FreeList are under 2 GiB
+						# else
+						typedef std::size_t	Tag;
+						# endif
+
+						// Block sizes are multiples of sizeof(Header), so the lowest bits are free
+						static constexpr Tag FREE_BIT = 1;
+						static constexpr Tag PREV_FREE_BIT = 2;
+						static constexpr Tag FLAG_BITS = FREE_BIT | PREV_FREE_BIT;
+
+						Header(std::size_t size, Tag flags) : m_tag(static_cast<Tag>(size) | flags) {}
 						~Header() {}
 
-						Header*	next;
-						Header*	prev;
-						emma::RedBlackTree::Node* node;
+						// From this header to the next one
+						std::size_t	get_size() const { return m_tag & ~FLAG_BITS; }
+						void		set_size(std::size_t size) { m_tag = static_cast<Tag>(size) | (m_tag & FLAG_BITS); }
+
+						bool	is_free() const { return (m_tag & FREE_BIT) != 0; }
+						bool	is_prev_free() const { return (m_tag & PREV_FREE_BIT) != 0; }
+						void	set_prev_free(bool prev_free) { m_tag = (m_tag & ~PREV_FREE_BIT) | (prev_free ? PREV_FREE_BIT : 0); }
 
-						std::size_t	get_size();
+						// Neighbours are found by arithmetic. The next one is
+						// m_end_of_memory if we are the last block.
+						Header*	get_next() const
+						{
+							return reinterpret_cast<Header*>(const_cast<uint8_t*>(\
+								reinterpret_cast<const uint8_t*>(this) + get_size()));
+						}
+						// Only if is_prev_free(), it's footer is right in front of us
+						Header*	get_prev() const
+						{
+							return reinterpret_cast<Header*>(const_cast<uint8_t*>(\
+								reinterpret_cast<const uint8_t*>(this) - *(reinterpret_cast<const Tag*>(this) - 1)));
+						}
+
+						// The node of a free block is always right after it's header
+						emma::RedBlackTree::Node*	get_node() const
+						{
+							if (!is_free())
+								return NULL;
+							return reinterpret_cast<emma::RedBlackTree::Node*>(const_cast<Header*>(this + 1));
+						}
+
+					private:
+						Tag	m_tag;
 				};
 
+				# if EMMA_COMPACT_FREELIST
+				// Sizes & links are 32 bits, so a compact FreeList only uses this much memory
+				static constexpr std::size_t COMPACT_MAX_SIZE = 0x7FFFFFF8;
+				# endif
+
 				// These are used just like macros, just through a namespace.
-				static constexpr std::size_t HEADER_MAX_PADDING = 2 * sizeof(Header);
-				static constexpr std::size_t NODE_MAX_PADDING = 2 * sizeof(emma::RedBlackTree::Node);
-				static constexpr std::size_t MIN_INIT_SIZE = NODE_MAX_PADDING + HEADER_MAX_PADDING;
+				// A block must be able to hold it's header, node & footer once it's free.
+				static constexpr std::size_t MIN_BLOCK_SIZE = 2 * sizeof(Header) + sizeof(emma::RedBlackTree::Node);
+				static constexpr std::size_t MIN_INIT_SIZE = MIN_BLOCK_SIZE + 2 * sizeof(Header);
+
+				// Free blocks of the smallest sizes are kept in exact size bins instead
+				// of the tree, one bin for each size from MIN_BLOCK_SIZE up to this
+				static constexpr std::size_t SMALL_BIN_COUNT = 64;
+				static constexpr std::size_t SMALL_BIN_MAX_SIZE = MIN_BLOCK_SIZE + (SMALL_BIN_COUNT - 1) * sizeof(Header);
+
+				// With deferred coalescing, at most this many freed blocks wait for reuse
+				static constexpr std::size_t QUICK_LIST_CAPACITY = 32;
 
 			private:
 				emma::RedBlackTree m_rb_tree;
-				Header*	m_end_of_memory; // Points to end of memory available
+				emma::RedBlackTree::Node*	m_small_bins[SMALL_BIN_COUNT]; // Linked through the nodes
+				uint64_t					m_small_bin_bitmap; // Bit i is set if bin i isn't empty
+
+				// Freed blocks that aren't coalesced yet, by size like the small bins.
+				// Their data is linked through it's first word.
+				bool		m_deferred_coalescing;
+				void*		m_quick_lists[SMALL_BIN_COUNT];
+				uint64_t	m_quick_list_bitmap;
+				std::size_t	m_quick_list_count;
+				Header*	m_end_of_memory; // Where the last block ends, the end of memory aligned down
+				Header*	m_first_header; // The start of memory aligned up, NULL if the constructor failed
+				PersistentSuperblock*	m_superblock; // NULL unless the heap is persistent
+
+				void	reset_free_lists(bool deferred_coalescing);
+				bool	set_memory_bounds(void* start, std::size_t size);
+				bool	heap_tags_are_valid() const;
+				void	rebuild_free_lists();
+
+				Header*		get_header_placement_from_ptr(const void* ptr) const;
+				void		release_block(void* data);
+				bool		cache_freed_block(void* data);
+				void*		take_cached_block(std::size_t data_size, std::size_t alignment);
+				std::size_t	get_unaligned_end_size() const;
 
-				Header*	get_header_placement_from_ptr(void* ptr);
-				void	align_to_natural(std::size_t data_size, void *&ptr, std::size_t &space_left);
+				void	create_new_memory_block(Header* header, std::size_t size);
+				void	insert_free_node(emma::RedBlackTree::Node* node);
+				void	remove_free_node(emma::RedBlackTree::Node* node);
+				emma::RedBlackTree::Node*	search_free_node(std::size_t size);
+				emma::RedBlackTree::Node*	search_largest_free_node();
+				Header*	take_free_block(emma::RedBlackTree::Node* free_node);
+				void*	place_data(Header*& header, std::size_t alignment);
 
-				void	create_new_memory_block(Header* prev_header,
-						Header* next_header, void* dealloc_position);
+				void	absorb_next_free_block(Header* header);
+				void	trim_block_to_size(Header* header, void* data, std::size_t data_size);
 
-				void	split_extra_memory_into_new_block(std::size_t space_left,
-						Header* current_header, void* ptr_to_extra_memory);
+				std::size_t	carve_free_block(emma::RedBlackTree::Node* free_node, std::size_t data_size,
+						std::size_t alignment, std::size_t count, void** out_ptrs);
 		};
 	};
 };
@@ -0,0 +1,70 @@
+
+/* [ MEMORY RESOURCE HEADER FILE ]
+ *
+ *   This is NOT derived from the base allocator class.
+ *
+ *   Lets any of the allocators be used as an std::pmr::memory_resource,
+ *   so that std::pmr containers (vector, string, unordered_map...) can keep
+ *   their memory inside of an EMMA heap.
+ *
+ *   The resource doesn't own the allocator, which has to outlive it & every
+ *   container using it.
+ *
+ *   emma::allocators::FreeList	heap(memory, size);
+ *   emma::MemoryResource		resource(heap);
+ *   std::pmr::vector<int>		numbers(&resource); */
+
+#ifndef MEMORYRESOURCE_HPP
+# define MEMORYRESOURCE_HPP
+
+# include <EMMA.hpp>
+# include <memory_resource>
+# include <new>
+# include <cstddef>
+
+namespace emma
+{
+	class MemoryResource : public std::pmr::memory_resource
+	{
+		public:
+			explicit MemoryResource(emma::BaseAllocator& allocator) : m_allocator(allocator) {}
+			~MemoryResource() {}
+
+			MemoryResource(const MemoryResource&) = delete;
+			MemoryResource& operator=(const MemoryResource&) = delete;
+
+			emma::BaseAllocator&	get_allocator() const { return m_allocator; }
+
+		protected:
+			// Containers can't handle NULL, so running out of memory always throws.
+			// Even if EMMA's own exceptions are disabled.
+			void*	do_allocate(std::size_t bytes, std::size_t alignment) override
+			{
+				void* ptr = m_allocator.allocate_raw_ptr(bytes == 0 ? 1 : bytes, alignment);
+				if (ptr == NULL)
+					throw std::bad_alloc();
+				return ptr;
+			}
+
+			void	do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override
+			{
+				(void) bytes;
+				(void) alignment;
+				m_allocator.free_raw_ptr(ptr);
+			}
+
+			// Memory from one can be freed by the other, if they share the allocator
+			bool	do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+			{
+				if (this == &other)
+					return true;
+				const MemoryResource* resource = dynamic_cast<const MemoryResource*>(&other);
+				return (resource != NULL && &resource->m_allocator == &m_allocator);
+			}
+
+		private:
+			emma::BaseAllocator&	m_allocator;
+	};
+};
+
+#endif
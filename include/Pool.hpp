@@ -0,0 +1,57 @@
+
+/* [ POOL ALLOCATOR HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   Implements a lock-free pool of equally sized blocks.
+ *   Any amount of threads may allocate & free from the same pool at once.
+ *   More detailed overview of the algorithm can be found inside the .cpp file */
+
+#ifndef POOL_HPP
+# define POOL_HPP
+
+# include <EMMA.hpp>
+# include <atomic>
+# include <stdint.h>
+
+namespace emma
+{
+	namespace allocators
+	{
+		class Pool final : public emma::BaseAllocator
+		{
+			public:
+				Pool(void* memory_location, std::size_t memory_maxsize, std::size_t block_size);
+				~Pool();
+
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+				void	free_raw_ptr(void *data) override;
+
+				std::size_t	usable_size(void* ptr) override;
+
+				std::size_t	get_block_size() const { return m_block_size; }
+				std::size_t	get_block_count() const { return m_block_count; }
+
+				// Blocks are never smaller than this, they have to fit the index
+				static constexpr std::size_t MIN_BLOCK_SIZE = sizeof(std::atomic<uint32_t>);
+
+			private:
+				static constexpr uint32_t NO_BLOCK = 0xFFFFFFFF;
+
+				// Head of the free stack.
+				// Lower 32 bits are the index of the first free block,
+				// upper 32 bits are a version tag which protects us from ABA.
+				std::atomic<uint64_t>	m_head;
+
+				uint8_t*	m_first_block;
+				std::size_t	m_block_size;
+				std::size_t	m_block_alignment;
+				uint32_t	m_block_count;
+
+				std::atomic<uint32_t>*	get_next_index(uint32_t block_index);
+		};
+	};
+};
+
+#endif
@@ -2,6 +2,8 @@
 /* [ RED-BLACK-TREE CLASS HEADER FILE ]
  * 
  *   This is a very typical implementation of a Red-Black binary tree.
+ *   Except that each value is only in the tree once, nodes with the same
+ *   value are chained behind it. So the tree only grows with distinct values.
  *   
  *   The functions document the logic inside themselves, however,
  *   an explanation of how red-black trees work as a whole is not provided here.
@@ -11,6 +13,7 @@
 # define REDBLACKTREE_HPP
 
 # include <EMMA.hpp>
+# include <stdint.h>
 
 namespace emma
 {
@@ -26,17 +29,93 @@ namespace emma
 						RED
 					};
 
-					Node(std::size_t value) :
-					left(NULL), right(NULL), parent(NULL), value(value), color(BLACK) {}
+					Node(std::size_t value) : value(value) { set_links(NULL, NULL, NULL, BLACK); }
 
 					~Node() {}
 
-					// Note, using getters/setters for these would be excessive.
-					Node*		left;
-					Node*		right;
-					Node*		parent;
+					// The links go through these, so that they can be compacted.
+					// See EMMA_COMPACT_FREELIST in build_settings.hpp
+					Node*	get_left() const { return get_link(m_left); }
+					Node*	get_right() const { return get_link(m_right); }
+					void	set_left(Node* node) { m_left = make_link(node); }
+					void	set_right(Node* node) { m_right = make_link(node); }
+
+					// Nodes with the same value are chained behind the one in the tree.
+					// A chained node's parent is the node before it in the chain.
+					Node*	get_same() const { return get_link(m_same); }
+					void	set_same(Node* node) { m_same = make_link(node); }
+
+					# if EMMA_COMPACT_FREELIST
+					Node*	get_parent() const { return get_link(m_parent & ~(COLOR_BIT | CHAINED_BIT)); }
+					void	set_parent(Node* node) { m_parent = make_link(node) | (m_parent & (COLOR_BIT | CHAINED_BIT)); }
+					Color	get_color() const { return (m_parent & COLOR_BIT) ? RED : BLACK; }
+					void	set_color(Color color) { m_parent = (m_parent & ~COLOR_BIT) | (color == RED ? COLOR_BIT : 0); }
+					bool	is_chained() const { return (m_parent & CHAINED_BIT) != 0; }
+					void	set_chained(bool chained) { m_parent = (m_parent & ~CHAINED_BIT) | (chained ? CHAINED_BIT : 0); }
+
+					// Blocks of a compact FreeList are under 2 GiB (signed 32-bit links)
+					uint32_t	value;
+					# else
+					Node*	get_parent() const { return m_parent; }
+					void	set_parent(Node* node) { m_parent = node; }
+					Color	get_color() const { return m_color; }
+					void	set_color(Color color) { m_color = color; }
+					bool	is_chained() const { return m_chained; }
+					void	set_chained(bool chained) { m_chained = chained; }
+
 					std::size_t	value;
-					enum Color	color;
+					# endif
+
+				private:
+					# if EMMA_COMPACT_FREELIST
+					// Links are the distance in bytes from this node, 0 for NULL.
+					// Nodes are at least 4 byte aligned, so the parent's lowest bits
+					// are free to hold the color & whether the node is chained.
+					static constexpr int32_t COLOR_BIT = 1;
+					static constexpr int32_t CHAINED_BIT = 2;
+
+					int32_t	m_left;
+					int32_t	m_right;
+					int32_t	m_parent;
+					int32_t	m_same;
+
+					Node*	get_link(int32_t link) const
+					{
+						if (link == 0)
+							return NULL;
+						return reinterpret_cast<Node*>(const_cast<uint8_t*>(\
+							reinterpret_cast<const uint8_t*>(this) + link));
+					}
+					int32_t	make_link(Node* node) const
+					{
+						if (node == NULL)
+							return 0;
+						return static_cast<int32_t>(reinterpret_cast<uint8_t*>(node) - reinterpret_cast<const uint8_t*>(this));
+					}
+					# else
+					Node*	m_left;
+					Node*	m_right;
+					Node*	m_parent;
+					Node*	m_same;
+					Color	m_color;
+					bool	m_chained;
+
+					Node*	get_link(Node* link) const { return link; }
+					Node*	make_link(Node* node) const { return node; }
+					# endif
+
+					void	set_links(Node* left, Node* right, Node* parent, Color color)
+					{
+						# if EMMA_COMPACT_FREELIST
+						m_parent = 0;
+						# endif
+						set_left(left);
+						set_right(right);
+						set_parent(parent);
+						set_color(color);
+						set_same(NULL);
+						set_chained(false);
+					}
 			};
 
 			RedBlackTree();
@@ -45,6 +124,10 @@ namespace emma
 			void	insert_node(Node* new_node);
 			void	remove_node(Node* node_to_delete);
 			Node*	search_best_fit(const std::size_t size);
+			Node*	search_largest();
+
+			void	measure(std::size_t& node_count, std::size_t& value_sum,
+					std::size_t& largest_value, std::size_t& height) const;
 
 		private:
 			Node*	m_root;
@@ -54,8 +137,11 @@ namespace emma
 			void	rotate_node_right(Node* target);
 			void	transplant_node(Node* dest_node, Node* src_node);
 			void	fix_insert_node_violations(Node* target);
-			void	fix_remove_node_violations(Node* target);
+			void	fix_remove_node_violations(Node* target, Node* target_parent);
 			Node*	get_smallest_in_subtree(Node* target);
+			void	replace_with_chained_node(Node* target);
+			static void	measure_subtree(const Node* target, std::size_t depth, std::size_t& node_count,
+						std::size_t& value_sum, std::size_t& height);
 	};
 };
 
@@ -0,0 +1,49 @@
+
+/* [ SHARED FREE LIST ALLOCATOR HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   A FreeList protected by a mutex, so that multiple threads can share it.
+ *   Meant to be used as the backend of ThreadCache's, which is why it also
+ *   allocates/frees in batches, taking the lock only once per batch. */
+
+#ifndef SHAREDFREELIST_HPP
+# define SHAREDFREELIST_HPP
+
+# include <EMMA.hpp>
+# include <FreeList.hpp>
+# include <mutex>
+
+namespace emma
+{
+	namespace allocators
+	{
+		class SharedFreeList final : public emma::BaseAllocator
+		{
+			public:
+				SharedFreeList(void* memory_location, std::size_t memory_maxsize);
+				~SharedFreeList();
+
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+				void	free_raw_ptr(void *data) override;
+
+				using emma::BaseAllocator::reallocate_raw_ptr;
+				void*		reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment) override;
+				std::size_t	usable_size(void* ptr) override;
+
+				using emma::BaseAllocator::allocate_bulk;
+				std::size_t	allocate_bulk(std::size_t data_size, std::size_t count,
+							void** out_ptrs, std::size_t alignment) override;
+				void		free_bulk(void** ptrs, std::size_t count) override;
+
+				emma::Stats	get_stats() const override;
+
+			private:
+				emma::allocators::FreeList	m_free_list;
+				mutable std::mutex	m_mutex;
+		};
+	};
+};
+
+#endif
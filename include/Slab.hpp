@@ -0,0 +1,73 @@
+
+/* [ SLAB ALLOCATOR HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   Implements a segregated size class front-end on top of a FreeList.
+ *   Small allocations are served in O(1) from fixed size slabs, while large
+ *   allocations & the slabs themselves are managed by the FreeList.
+ *   More detailed overview of the algorithm can be found inside the .cpp file */
+
+#ifndef SLAB_HPP
+# define SLAB_HPP
+
+# include <EMMA.hpp>
+# include <FreeList.hpp>
+# include <stdint.h>
+
+namespace emma
+{
+	namespace allocators
+	{
+		class Slab final : public emma::BaseAllocator
+		{
+			public:
+				Slab(void* memory_location, std::size_t memory_maxsize);
+				~Slab();
+
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+				void	free_raw_ptr(void *data) override;
+
+				using emma::BaseAllocator::reallocate_raw_ptr;
+				void*		reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment) override;
+				std::size_t	usable_size(void* ptr) override;
+
+				// Size classes are powers of two, from MIN to MAX_CLASS_SIZE.
+				// Anything larger than MAX_CLASS_SIZE goes to the FreeList.
+				static constexpr std::size_t MIN_CLASS_SIZE = 8;
+				static constexpr std::size_t MAX_CLASS_SIZE = 128;
+				static constexpr std::size_t CLASS_COUNT = 5;
+
+				// Slabs are naturally aligned, so a slab never shares a page.
+				static constexpr std::size_t SLAB_SHIFT = 10;
+				static constexpr std::size_t SLAB_SIZE = std::size_t(1) << SLAB_SHIFT;
+
+			private:
+				// Stored inside free objects. Only exists while they are free.
+				class FreeObject
+				{
+					public:
+						FreeObject(FreeObject* nxt) : next(nxt) {}
+						~FreeObject() {}
+
+						FreeObject*	next;
+				};
+
+				emma::allocators::FreeList	m_backend;
+				FreeObject*	m_free_objects[CLASS_COUNT];
+
+				// One entry per SLAB_SIZE page in our memory.
+				// 0 means the page isn't a slab, otherwise it is class index + 1
+				uint8_t*	m_slab_map;
+				uintptr_t	m_first_page;
+				std::size_t	m_page_count;
+
+				std::size_t	get_class_index(std::size_t data_size);
+				std::size_t	get_slab_class(void* ptr);
+				bool		refill_class(std::size_t class_index);
+		};
+	};
+};
+
+#endif
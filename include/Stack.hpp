@@ -0,0 +1,67 @@
+
+/* [ STACK ALLOCATOR HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   Implements a LIFO stack. Allocations must be freed in the reverse order,
+ *   or all at once by going back to a marker.
+ *   More detailed overview of the algorithm can be found inside the .cpp file */
+
+#ifndef STACK_HPP
+# define STACK_HPP
+
+# include <EMMA.hpp>
+# include <stdint.h>
+
+namespace emma
+{
+	namespace allocators
+	{
+		class Stack final : public emma::BaseAllocator
+		{
+			public:
+				Stack(void* memory_location, std::size_t memory_maxsize);
+				~Stack();
+
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+				void	free_raw_ptr(void *data) override;
+
+				using emma::BaseAllocator::reallocate_raw_ptr;
+				void*		reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment) override;
+				std::size_t	usable_size(void* ptr) override;
+
+				// Amount of bytes in use, which is all a marker is
+				typedef std::size_t	Marker;
+
+				Marker	get_marker() const;
+				void	free_to_marker(Marker marker);
+
+				// Frees everything allocated during it's lifetime when destroyed
+				class Scope
+				{
+					public:
+						Scope(Stack& stack) : m_stack(stack), m_marker(stack.get_marker()) {}
+						~Scope() { m_stack.free_to_marker(m_marker); }
+
+						Scope(const Scope&) = delete;
+						Scope& operator=(const Scope&) = delete;
+
+					private:
+						Stack&	m_stack;
+						Marker	m_marker;
+				};
+
+			private:
+				// Stored right in front of every allocation.
+				// Distance from the start of the data back to the previous top.
+				typedef uint32_t	BackOffset;
+
+				uint8_t*	m_top; // Next free byte
+				uint8_t*	m_last; // Newest allocation, NULL if unknown
+				uint8_t*	m_end; // End of memory available
+		};
+	};
+};
+
+#endif
@@ -0,0 +1,47 @@
+
+/* [ ALLOCATOR STATISTICS HEADER FILE ]
+ *
+ *   A snapshot of what an allocator is doing, returned by get_stats().
+ *
+ *   The counters are kept up to date while allocating & freeing, but only
+ *   if EMMA_ENABLE_STATS is enabled in build_settings.hpp. Otherwise they are 0.
+ *   The rest is measured from the allocator's state when get_stats() is called,
+ *   which isn't free, but costs nothing while allocating.
+ *
+ *   Only the FreeList (& SharedFreeList) and the TLSF fill these in,
+ *   the other allocators return all zeroes. */
+
+#ifndef STATS_HPP
+# define STATS_HPP
+
+# include <cstddef>
+
+namespace emma
+{
+	class Stats
+	{
+		public:
+			Stats() : allocations(0), frees(0), failed_allocations(0), merges(0),
+			live_allocations(0), bytes_in_use(0), peak_bytes_in_use(0),
+			free_bytes(0), free_block_count(0), largest_free_block(0), tree_depth(0) {}
+
+			~Stats() {}
+
+			// Counters. Reallocations which have to move count as both.
+			std::size_t	allocations; // Successful ones, since the start
+			std::size_t	frees;
+			std::size_t	failed_allocations;
+			std::size_t	merges; // Times a freed block was merged with a free neighbour
+			std::size_t	live_allocations;
+			std::size_t	bytes_in_use; // usable_size() of every live allocation
+			std::size_t	peak_bytes_in_use;
+
+			// Measured by get_stats()
+			std::size_t	free_bytes;
+			std::size_t	free_block_count;
+			std::size_t	largest_free_block;
+			std::size_t	tree_depth; // Of the FreeList's red-black tree, 0 for others
+	};
+};
+
+#endif
@@ -0,0 +1,82 @@
+
+/* [ STANDARD ALLOCATOR HEADER FILE ]
+ *
+ *   This is NOT derived from the base allocator class.
+ *
+ *   Meets the requirements of a C++ Allocator, so that it can be given to
+ *   standard containers as a template argument. Every allocation is made by
+ *   the allocator it was constructed with.
+ *
+ *   Unlike MemoryResource, the allocator is part of the container's type.
+ *   Copies, & copies rebound to other types, all share the same allocator.
+ *
+ *   emma::allocators::TLSF	heap(memory, size);
+ *   std::vector<int, emma::StdAllocator<int>> numbers(heap); */
+
+#ifndef STDALLOCATOR_HPP
+# define STDALLOCATOR_HPP
+
+# include <EMMA.hpp>
+# include <new>
+# include <cstddef>
+# include <type_traits>
+# include <stdint.h>
+
+namespace emma
+{
+	template <class T>
+	class StdAllocator
+	{
+		public:
+			typedef T	value_type;
+
+			// Containers keep the allocator their memory came from
+			typedef std::true_type	propagate_on_container_copy_assignment;
+			typedef std::true_type	propagate_on_container_move_assignment;
+			typedef std::true_type	propagate_on_container_swap;
+			typedef std::false_type	is_always_equal;
+
+			StdAllocator(emma::BaseAllocator& allocator) noexcept : m_allocator(&allocator) {}
+
+			template <class U>
+			StdAllocator(const StdAllocator<U>& other) noexcept : m_allocator(&other.get_allocator()) {}
+
+			// Containers can't handle NULL, so running out of memory always throws.
+			// Even if EMMA's own exceptions are disabled.
+			T*	allocate(std::size_t count)
+			{
+				if (count > SIZE_MAX / sizeof(T))
+					throw std::bad_array_new_length();
+
+				void* ptr = m_allocator->allocate_raw_ptr(count == 0 ? 1 : count * sizeof(T), alignof(T));
+				if (ptr == NULL)
+					throw std::bad_alloc();
+				return static_cast<T*>(ptr);
+			}
+
+			void	deallocate(T* ptr, std::size_t count) noexcept
+			{
+				(void) count;
+				m_allocator->free_raw_ptr(static_cast<void*>(ptr));
+			}
+
+			emma::BaseAllocator&	get_allocator() const noexcept { return *m_allocator; }
+
+		private:
+			emma::BaseAllocator*	m_allocator;
+	};
+
+	template <class T, class U>
+	bool	operator==(const StdAllocator<T>& left, const StdAllocator<U>& right) noexcept
+	{
+		return (&left.get_allocator() == &right.get_allocator());
+	}
+
+	template <class T, class U>
+	bool	operator!=(const StdAllocator<T>& left, const StdAllocator<U>& right) noexcept
+	{
+		return !(left == right);
+	}
+};
+
+#endif
@@ -0,0 +1,89 @@
+
+/* [ TLSF ALLOCATOR HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   Implements Two-Level Segregated Fit. Allocating & freeing are O(1),
+ *   no matter what state the heap is in.
+ *   More detailed overview of the algorithm can be found inside the .cpp file */
+
+#ifndef TLSF_HPP
+# define TLSF_HPP
+
+# include <EMMA.hpp>
+# include <stdint.h>
+
+namespace emma
+{
+	namespace allocators
+	{
+		class TLSF final : public emma::BaseAllocator
+		{
+			public:
+				TLSF(void* memory_location, std::size_t memory_maxsize);
+				~TLSF();
+
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+				void	free_raw_ptr(void *data) override;
+
+				using emma::BaseAllocator::reallocate_raw_ptr;
+				void*		reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment) override;
+				std::size_t	usable_size(void* ptr) override;
+
+				emma::Stats	get_stats() const override;
+
+				// Every block is a multiple of this, and so is aligned to it
+				static constexpr std::size_t ALIGNMENT = 16;
+
+				// Second level splits every first level into 2^SL_SHIFT lists
+				static constexpr unsigned int SL_SHIFT = 4;
+				static constexpr unsigned int SL_COUNT = 1 << SL_SHIFT;
+
+				// Blocks smaller than 2^FL_SHIFT all go to the first first level.
+				// Larger ones get a first level per power of two, up to 2^FL_MAX.
+				static constexpr unsigned int FL_SHIFT = SL_SHIFT + 4;
+				static constexpr unsigned int FL_MAX = 32;
+				static constexpr unsigned int FL_COUNT = FL_MAX - FL_SHIFT + 1;
+
+			private:
+				// In front of every block. Size includes the header.
+				// The lowest bit of the size tells if the block is free.
+				class Block
+				{
+					public:
+						Block() : prev_physical(NULL), size(0), next_free(NULL), prev_free(NULL) {}
+						~Block() {}
+
+						Block*		prev_physical;
+						std::size_t	size;
+
+						// Only used while free, otherwise part of the data
+						Block*		next_free;
+						Block*		prev_free;
+				};
+
+				static constexpr std::size_t HEADER_SIZE = 2 * sizeof(void*);
+				static constexpr std::size_t MIN_BLOCK_SIZE = sizeof(Block);
+				static constexpr std::size_t FREE_BIT = 1;
+
+				// Stored at the start of the memory
+				class Control
+				{
+					public:
+						uint32_t	fl_bitmap;
+						uint32_t	sl_bitmaps[FL_COUNT];
+						Block*		free_lists[FL_COUNT][SL_COUNT];
+				};
+
+				Control*	m_control;
+
+				void	insert_free_block(Block* block);
+				void	remove_free_block(Block* block);
+				Block*	find_free_block(std::size_t block_size);
+				Block*	split_front_for_alignment(Block* block, std::size_t alignment, std::size_t& block_size);
+		};
+	};
+};
+
+#endif
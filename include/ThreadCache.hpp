@@ -0,0 +1,84 @@
+
+/* [ THREAD CACHE ALLOCATOR HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   A per-thread cache in front of a SharedFreeList.
+ *   Each thread constructs it's own ThreadCache on top of the same shared heap.
+ *   Allocations & deallocations are served from the cache without any locks,
+ *   the shared heap is only locked to refill/drain the cache in batches.
+ *   More detailed overview of the algorithm can be found inside the .cpp file */
+
+#ifndef THREADCACHE_HPP
+# define THREADCACHE_HPP
+
+# include <EMMA.hpp>
+# include <SharedFreeList.hpp>
+# include <cstddef>
+
+namespace emma
+{
+	namespace allocators
+	{
+		class ThreadCache final : public emma::BaseAllocator
+		{
+			public:
+				ThreadCache(emma::allocators::SharedFreeList& shared_heap);
+				~ThreadCache();
+
+				using emma::BaseAllocator::allocate_raw_ptr;
+				void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+				void	free_raw_ptr(void *data) override;
+
+				std::size_t	usable_size(void* ptr) override;
+
+				// Gives every cached block back to the shared heap
+				void	flush();
+
+				// Size classes are powers of two, from MIN to MAX_CLASS_SIZE.
+				// Anything larger than MAX_CLASS_SIZE goes to the shared heap.
+				static constexpr std::size_t MIN_CLASS_SIZE = 16;
+				static constexpr std::size_t MAX_CLASS_SIZE = 1024;
+				static constexpr std::size_t CLASS_COUNT = 7;
+
+				// Blocks moved from/to the shared heap per lock
+				static constexpr std::size_t BATCH_SIZE = 16;
+				// A class drains a batch once it has more cached blocks than this
+				static constexpr std::size_t MAX_CACHED_BLOCKS = 4 * BATCH_SIZE;
+
+			private:
+				// Placed in front of every block, tells which class it belongs to.
+				// Padded so that the data after it keeps the max alignment.
+				class alignas(std::max_align_t) Tag
+				{
+					public:
+						Tag(std::size_t index, std::size_t offset) : class_index(index), block_offset(offset) {}
+						~Tag() {}
+
+						std::size_t	class_index;
+						std::size_t	block_offset; // From the block to the data
+				};
+				static constexpr std::size_t LARGE_BLOCK = CLASS_COUNT;
+
+				// Stored in the data of cached blocks. Only exists while cached.
+				class CachedBlock
+				{
+					public:
+						CachedBlock(CachedBlock* nxt) : next(nxt) {}
+						~CachedBlock() {}
+
+						CachedBlock*	next;
+				};
+
+				emma::allocators::SharedFreeList&	m_shared_heap;
+				CachedBlock*	m_cached_blocks[CLASS_COUNT];
+				std::size_t		m_cached_count[CLASS_COUNT];
+
+				std::size_t	get_class_index(std::size_t data_size);
+				bool		refill_class(std::size_t class_index);
+				void		drain_class(std::size_t class_index, std::size_t count);
+		};
+	};
+};
+
+#endif
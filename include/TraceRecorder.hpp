@@ -0,0 +1,107 @@
+/* [ TRACE RECORDER HEADER FILE ]
+ *
+ *   This is derived from the base allocator class.
+ *
+ *   Wraps another allocator, and records every allocate_raw_ptr() &
+ *   free_raw_ptr() call into a binary trace file. The trace can then be
+ *   replayed against any allocator with 'make emma_replay', to compare
+ *   them on the same workload. See src/replay/emma_replay.cpp.
+ *
+ *   The recorder doesn't own the allocator, which has to outlive it.
+ *
+ *   emma::allocators::FreeList	heap(memory, size);
+ *   emma::TraceRecorder		recorder(heap, std::fopen("heap.trace", "wb"));
+ *
+ *   The file starts with TRACE_MAGIC, followed by one TraceRecord per call.
+ *   Records are written in the byte order of the machine. */
+
+#ifndef TRACERECORDER_HPP
+# define TRACERECORDER_HPP
+
+# include <EMMA.hpp>
+# include <cstdio>
+# include <cstddef>
+# include <chrono>
+# include <stdint.h>
+
+namespace emma
+{
+	// First 8 bytes of every trace file
+	static constexpr char	TRACE_MAGIC[8] = { 'E', 'M', 'M', 'A', 'T', 'R', 'C', '1' };
+
+	class TraceRecord // One call, 24 bytes
+	{
+		public:
+			enum Operation { ALLOCATE = 0, FREE = 1 };
+
+			// Recorded sizes are cut to 48 bits, far more than any heap has
+			static constexpr uint64_t	SIZE_MASK = (uint64_t(1) << 48) - 1;
+
+			TraceRecord() : time(0), id(0), info(0) {}
+			TraceRecord(uint64_t nanoseconds, uint64_t allocation_id, Operation operation,
+				std::size_t size, std::size_t alignment) : time(nanoseconds), id(allocation_id),
+				info((uint64_t(size) & SIZE_MASK) | (uint64_t(log2_of(alignment)) << 48)
+				| (uint64_t(operation) << 56)) {}
+
+			~TraceRecord() {}
+
+			Operation	get_operation() const { return static_cast<Operation>(info >> 56); }
+			std::size_t	get_size() const { return static_cast<std::size_t>(info & SIZE_MASK); }
+			std::size_t	get_alignment() const { return std::size_t(1) << ((info >> 48) & 0xFF); }
+
+			uint64_t	time; // Nanoseconds since the recording started
+			uint64_t	id; // Address of the allocation in the recorded heap, 0 if it failed
+			uint64_t	info; // Size, log2 of the alignment & the operation, from low to high
+
+		private:
+			static uint64_t	log2_of(std::size_t alignment)
+			{
+				uint64_t shift = 0;
+				while (shift < 63 && (std::size_t(1) << shift) < alignment)
+					++shift;
+				return shift;
+			}
+	};
+
+	class TraceRecorder final : public emma::BaseAllocator
+	{
+		public:
+			TraceRecorder(emma::BaseAllocator& allocator, std::FILE* trace_file);
+			~TraceRecorder(); // Flushes, but doesn't close the file
+
+			TraceRecorder(const TraceRecorder&) = delete;
+			TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+			// Reallocations & bulk calls aren't forwarded as they are. They go
+			// through BaseAllocator's defaults, so each allocation & free they
+			// are made of gets recorded.
+			using emma::BaseAllocator::allocate_raw_ptr;
+			void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override;
+			void	free_raw_ptr(void *data) override;
+
+			std::size_t	usable_size(void* ptr) override;
+			emma::Stats	get_stats() const override;
+
+			// Writes the buffered records into the file
+			void	flush();
+
+			std::size_t				get_record_count() const { return m_record_count; }
+			emma::BaseAllocator&	get_allocator() const { return m_allocator; }
+
+			// Records kept in memory between writes
+			static constexpr std::size_t BUFFER_SIZE = 256;
+
+		private:
+			emma::BaseAllocator&	m_allocator;
+			std::FILE*				m_file;
+			std::chrono::steady_clock::time_point	m_start;
+			std::size_t				m_record_count;
+			std::size_t				m_buffered;
+			TraceRecord				m_buffer[BUFFER_SIZE];
+
+			void	record(TraceRecord::Operation operation, void* ptr,
+					std::size_t data_size, std::size_t alignment);
+	};
+};
+
+#endif
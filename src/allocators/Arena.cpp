@@ -0,0 +1,175 @@
+/* [ ARENA ALLOCATOR CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * The simplest of all algorithms. There is a pointer to the next free byte,
+ * an allocation aligns it and moves (bumps) it forward by the size requested.
+ *
+ *  - Simplified example of memory layout -
+ * ┌──────┬───┬────────────┬───┬──────────────┬──────────────────────────────┐
+ * │ Data │Pad│ Data       │Dtr│ Class        │ Free memory                  │
+ * └──────┴───┴────────────┴───┴──────────────┴──────────────────────────────┘
+ *                                            └ Top
+ *
+ * Freeing a single allocation does nothing. Instead, everything is freed at
+ * once with reset(), which just moves the top back to the start. O(1).
+ *
+ * Classes with a non-trivial destructor get a small entry (Dtr) in front of
+ * them. The entries form a list from the newest class to the oldest, which
+ * reset() walks to destroy the classes in the reverse order of construction.
+ * Classes which don't need destroying have no entry, and cost nothing to reset.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <Arena.hpp>
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+
+EMMA_INLINE emma::allocators::Arena::Arena(void* start, std::size_t size) : emma::BaseAllocator(start, size),
+m_top(static_cast<uint8_t*>(start)), m_last(NULL), m_end(static_cast<uint8_t*>(start) + size), m_destructors(NULL)
+{/* Params    : (1) Ptr to the start of the memory available for the allocator
+ *              (2) Size of the memory available for the allocator
+ *  On Success: Initializes the allocator, which will be ready for immediate use.
+ *  On failure: Throws an exception if they're enabled.
+ *              Otherwise does nothing & attempted allocations return NULL.
+ *  Fails if  : Start is NULL */
+
+	if (start == NULL)
+	{
+		emma::return_error<bool>(true, "Starting address can't be NULL");
+		this->m_end = NULL; // Nothing fits, allocations will fail
+	}
+}
+
+EMMA_INLINE emma::allocators::Arena::~Arena()
+{
+	reset();
+}
+
+
+EMMA_INLINE void* emma::allocators::Arena::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns an aligned pointer to the newly allocated data
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory, data_size == 0,
+ *              or alignment is not a power of two */
+
+	if (data_size == 0)
+		return emma::return_error<void*>(NULL, "Allocation size can't be 0!");
+	if (alignment_is_invalid(alignment))
+		return emma::return_error<void*>(NULL, "Alignment must be a power of two");
+
+	std::size_t padding = static_cast<std::size_t>(\
+		(alignment - reinterpret_cast<uintptr_t>(this->m_top) % alignment) % alignment);
+	std::size_t space_left = static_cast<std::size_t>(this->m_end - this->m_top);
+
+	if (padding > space_left || data_size > space_left - padding)
+		return emma::return_error<void*>(NULL, "Arena is out of memory");
+
+	this->m_last = this->m_top + padding;
+	this->m_top = this->m_last + data_size;
+	return static_cast<void*>(this->m_last);
+}
+
+EMMA_INLINE void emma::allocators::Arena::free_raw_ptr(void *data)
+{/* Does nothing on purpose, the memory is only freed by reset() */
+
+	(void) data;
+}
+
+
+EMMA_INLINE void* emma::allocators::Arena::reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment)
+{/* Params    : (1) Data which has been previously allocated, or NULL
+ *              (2) New size of the data
+ *              (3) Alignment of the data, must be a power of two
+ *  On success: Returns a pointer to the resized data.
+ *              The newest allocation is resized in place, by moving the top.
+ *              Anything else is copied to a new allocation.
+ *              The old allocation stays used until reset().
+ *  On failure: Returns NULL, ptr is left as is. Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory */
+
+	if (ptr == NULL || alignment_is_invalid(alignment))
+		return allocate_raw_ptr(new_size, alignment);
+	if (new_size == 0)
+	{
+		free_raw_ptr(ptr);
+		return NULL;
+	}
+
+	uint8_t* data = static_cast<uint8_t*>(ptr);
+	if (data == this->m_last && reinterpret_cast<uintptr_t>(data) % alignment == 0
+		&& new_size <= static_cast<std::size_t>(this->m_end - data))
+	{
+		this->m_top = data + new_size;
+		return ptr;
+	}
+
+	// We don't know the old size, but it can't go past the top.
+	// Everything up to the top is our memory, so it is safe to copy.
+	std::size_t old_size_limit = static_cast<std::size_t>(this->m_top - data);
+	void* new_ptr = allocate_raw_ptr(new_size, alignment);
+	if (new_ptr == NULL)
+		return NULL; // Also throws an exception if they're enabled
+
+	std::memcpy(new_ptr, ptr, old_size_limit < new_size ? old_size_limit : new_size);
+	return new_ptr;
+}
+
+EMMA_INLINE std::size_t emma::allocators::Arena::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Returns the amount of bytes from ptr to the top,
+ *              if ptr is the newest allocation.
+ *  On failure: Returns 0
+ *  Fails if  : The ptr is not the newest allocation, as sizes aren't stored */
+
+	if (ptr == NULL || static_cast<uint8_t*>(ptr) != this->m_last)
+		return 0;
+	return static_cast<std::size_t>(this->m_top - this->m_last);
+}
+
+EMMA_INLINE void emma::allocators::Arena::reset()
+{/* On success: Destroys every registered class, newest first.
+ *              Then frees all memory, by moving the top back to the start.
+ *  Fails if  : Cannot fail */
+
+	while (this->m_destructors != NULL)
+	{
+		DestructorEntry* entry = this->m_destructors;
+		if (entry->destroy != NULL) // NULL if it was already freed
+			entry->destroy(static_cast<void*>(entry + 1));
+		this->m_destructors = entry->prev;
+	}
+	this->m_top = static_cast<uint8_t*>(this->m_memory_location);
+	this->m_last = NULL;
+}
+
+
+EMMA_INLINE emma::allocators::Arena::DestructorEntry* \
+emma::allocators::Arena::allocate_with_entry(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the class
+ *              (2) Alignment of the class
+ *  On success: Allocates space for an entry & the class right after it.
+ *              Returns the entry, which is not yet registered.
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory */
+
+	// The class has to be aligned for the entry too, so there is no gap
+	if (alignment < alignof(DestructorEntry))
+		alignment = alignof(DestructorEntry);
+
+	// Allocating the entry first leaves the top right where the class will be.
+	// Any padding for the class is then added in front of the entry instead.
+	uint8_t* class_position = this->m_top + sizeof(DestructorEntry);
+	std::size_t padding = static_cast<std::size_t>(\
+		(alignment - reinterpret_cast<uintptr_t>(class_position) % alignment) % alignment);
+
+	void* entry = allocate_raw_ptr(padding + sizeof(DestructorEntry) + data_size, 1);
+	if (entry == NULL)
+		return NULL;
+
+	return new(static_cast<uint8_t*>(entry) + padding) DestructorEntry();
+}
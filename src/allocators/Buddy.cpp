@@ -0,0 +1,270 @@
+/* [ BUDDY ALLOCATOR CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * The memory is treated as one block of 2^max_order bytes, which can be split
+ * in two halves, which can be split again, down to MIN_BLOCK_SIZE bytes.
+ * The order of a block is the power of two of it's size.
+ * The two halves of a block are each other's buddies.
+ *
+ *  - Simplified example of the blocks as a tree -
+ *                 ┌───────────────────────────────┐
+ *                 │ Order 8 (split)               │
+ *                 └───────────────────────────────┘
+ *                 ┌───────────────┐ ┌─────────────┐
+ *                 │ Order 7 split │ │ Order 7 free│
+ *                 └───────────────┘ └─────────────┘
+ *                 ┌──────┐ ┌──────┐
+ *                 │ Used │ │ Free │
+ *                 └──────┘ └──────┘
+ *
+ * Every order has it's own free list, and a bit in a mask which is set when
+ * the list is not empty. Allocating rounds the size up to an order, and
+ * finds the smallest order with a free block by bit-scanning the mask.
+ * That block is split in half until it's the right size. The unused halves
+ * go to the free lists.
+ *
+ * Freeing finds the order of the block by going down the tree from the top,
+ * following the split bits. Then the block is merged with it's buddy for as
+ * long as the buddy is also a free block of the same order.
+ * Both are O(log M), where M is the size of the memory.
+ *
+ * The state of the tree is kept in two bitmaps (split & free), one bit per
+ * node, which are stored in front of the blocks. The blocks themselves have
+ * no headers, a free block only holds the links of it's free list.
+ *
+ * The memory rarely is a power of two. The tree is made large enough to
+ * cover all of it, and the part past the end just never becomes free.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <Buddy.hpp>
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+static inline unsigned int get_block_order(std::size_t data_size)
+{/* Order of the smallest block which fits the size */
+
+	if (data_size <= emma::allocators::Buddy::MIN_BLOCK_SIZE)
+		return emma::allocators::Buddy::MIN_ORDER;
+	return static_cast<unsigned int>(64 - __builtin_clzll(data_size - 1));
+}
+
+static inline bool get_bit(const uint8_t* bitmap, std::size_t index)
+{
+	return (bitmap[index >> 3] >> (index & 7)) & 1;
+}
+
+static inline void set_bit(uint8_t* bitmap, std::size_t index, bool value)
+{
+	if (value)
+		bitmap[index >> 3] |= static_cast<uint8_t>(1 << (index & 7));
+	else
+		bitmap[index >> 3] &= static_cast<uint8_t>(~(1 << (index & 7)));
+}
+
+EMMA_INLINE emma::allocators::Buddy::Buddy(void* start, std::size_t size) : emma::BaseAllocator(start, size),
+m_first_block(NULL), m_max_order(0), m_free_lists(), m_nonempty_orders(0),
+m_split_bits(NULL), m_free_bits(NULL)
+{/* Params    : (1) Ptr to the start of the memory available for the allocator
+ *              (2) Size of the memory available for the allocator
+ *  On Success: Initializes the allocator, which will be ready for immediate use.
+ *  On failure: Throws an exception if they're enabled.
+ *              Otherwise does nothing & attempted allocations return NULL.
+ *  Fails if  : Start is NULL, or memsize can't fit the bitmaps & one block */
+
+	if (start == NULL)
+	{
+		emma::return_error<bool>(true, "Starting address can't be NULL");
+		return;
+	}
+
+	// Tree large enough to cover all of the memory, with 2 bits per node
+	this->m_max_order = get_block_order(size);
+	std::size_t node_count = (std::size_t(2) << (this->m_max_order - MIN_ORDER)) - 1;
+	std::size_t bitmap_size = (node_count + 7) / 8;
+
+	// Blocks start after the bitmaps, aligned to std::max_align_t
+	uint8_t* first_block = static_cast<uint8_t*>(start) + bitmap_size * 2;
+	first_block += (alignof(std::max_align_t) - \
+		reinterpret_cast<uintptr_t>(first_block) % alignof(std::max_align_t)) % alignof(std::max_align_t);
+	if (first_block + MIN_BLOCK_SIZE > static_cast<uint8_t*>(start) + size)
+	{
+		emma::return_error<bool>(true, "Memsize is too small");
+		return;
+	}
+
+	this->m_split_bits = static_cast<uint8_t*>(start);
+	this->m_free_bits = this->m_split_bits + bitmap_size;
+	this->m_first_block = first_block;
+	std::memset(start, 0, bitmap_size * 2);
+
+	// Cover the usable memory with the largest blocks possible.
+	// Each is aligned to it's own size, since they only get smaller.
+	std::size_t usable_size = static_cast<std::size_t>(static_cast<uint8_t*>(start) + size - first_block);
+	std::size_t offset = 0;
+	for (unsigned int order = this->m_max_order; order >= MIN_ORDER; --order)
+	{
+		if (usable_size - offset < (std::size_t(1) << order))
+			continue;
+
+		// Every node above the block has been split to make it
+		for (unsigned int parent = order + 1; parent <= this->m_max_order; ++parent)
+			set_bit(this->m_split_bits, get_node_index(offset >> parent << parent, parent), true);
+
+		push_free_block(offset, order);
+		offset += std::size_t(1) << order;
+	}
+}
+
+EMMA_INLINE emma::allocators::Buddy::~Buddy() {}
+
+
+EMMA_INLINE void* emma::allocators::Buddy::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns a pointer to a block which is at least data_size bytes.
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : There is no free block large enough, data_size == 0,
+ *              or alignment is not a power of two */
+
+	if (data_size == 0)
+		return emma::return_error<void*>(NULL, "Allocation size can't be 0!");
+	if (alignment_is_invalid(alignment))
+		return emma::return_error<void*>(NULL, "Alignment must be a power of two");
+
+	// Blocks are aligned to their size, counted from the first block.
+	// So every block at least as large as the alignment needs the same padding.
+	std::size_t padding = static_cast<std::size_t>(\
+		(alignment - reinterpret_cast<uintptr_t>(this->m_first_block) % alignment) % alignment);
+	if (alignment > (std::size_t(1) << this->m_max_order)
+		|| data_size > (std::size_t(1) << this->m_max_order) - padding)
+		return emma::return_error<void*>(NULL, "Allocation size is larger than the memory");
+
+	// Smallest order with a free block, which still fits the data
+	unsigned int order = get_block_order(data_size + padding < alignment ? alignment : data_size + padding);
+	uint64_t large_enough = this->m_nonempty_orders & ~((uint64_t(1) << order) - 1);
+	if (large_enough == 0)
+		return emma::return_error<void*>(NULL, "No free block large enough");
+	unsigned int free_order = static_cast<unsigned int>(__builtin_ctzll(large_enough));
+
+	std::size_t offset = static_cast<std::size_t>(\
+		reinterpret_cast<uint8_t*>(this->m_free_lists[free_order]) - this->m_first_block);
+	remove_free_block(offset, free_order);
+
+	// Split it until it's the right size. We keep the lower half.
+	while (free_order > order)
+	{
+		set_bit(this->m_split_bits, get_node_index(offset, free_order), true);
+		--free_order;
+		push_free_block(offset + (std::size_t(1) << free_order), free_order);
+	}
+	return static_cast<void*>(this->m_first_block + offset + padding);
+}
+
+EMMA_INLINE void emma::allocators::Buddy::free_raw_ptr(void *data)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Deallocates the requested data and merges it with it's buddies
+ *  On failure: Does nothing
+ *  Fails if  : Data is NULL. Otherwise cannot fail (assuming ptr is valid) */
+
+	if (data == NULL)
+		return;
+
+	std::size_t offset = static_cast<std::size_t>(static_cast<uint8_t*>(data) - this->m_first_block);
+	unsigned int order = find_block(offset);
+
+	// Merge with the buddy for as long as it's a free block of the same order
+	while (order < this->m_max_order)
+	{
+		std::size_t buddy_offset = offset ^ (std::size_t(1) << order);
+		if (!get_bit(this->m_free_bits, get_node_index(buddy_offset, order)))
+			break;
+
+		remove_free_block(buddy_offset, order);
+		++order;
+		offset = offset >> order << order;
+		set_bit(this->m_split_bits, get_node_index(offset, order), false);
+	}
+	push_free_block(offset, order);
+}
+
+EMMA_INLINE std::size_t emma::allocators::Buddy::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Returns the amount of bytes from ptr to the end of it's block
+ *  Fails if  : Returns 0 if ptr is NULL */
+
+	if (ptr == NULL)
+		return 0;
+
+	std::size_t data_offset = static_cast<std::size_t>(static_cast<uint8_t*>(ptr) - this->m_first_block);
+	std::size_t offset = data_offset;
+	unsigned int order = find_block(offset);
+	return (offset + (std::size_t(1) << order) - data_offset);
+}
+
+
+EMMA_INLINE unsigned int emma::allocators::Buddy::find_block(std::size_t& offset) const
+{/* Params    : (1) Offset of a ptr from the first block. Set to the block's offset.
+ *  On success: Returns the order of the allocated block the ptr is in.
+ *              Found by going down the split nodes, the block is the first
+ *              node which is not split.
+ *  Fails if  : Cannot fail, if the offset is inside an allocated block */
+
+	unsigned int order = this->m_max_order;
+	while (order > MIN_ORDER && get_bit(this->m_split_bits, get_node_index(offset >> order << order, order)))
+		--order;
+	offset = offset >> order << order; // Data may be padded for alignment
+	return order;
+}
+
+EMMA_INLINE std::size_t emma::allocators::Buddy::get_node_index(std::size_t offset, unsigned int order) const
+{/* Params    : (1) Offset of a block from the first block
+ *              (2) Order of the block
+ *  On success: Returns the index of the block's node in the bitmaps.
+ *              The nodes are in the order of a binary heap, top node first.
+ *  Fails if  : Cannot fail, if the offset is aligned to the order */
+
+	unsigned int depth = this->m_max_order - order;
+	return ((std::size_t(1) << depth) - 1 + (offset >> order));
+}
+
+EMMA_INLINE void emma::allocators::Buddy::push_free_block(std::size_t offset, unsigned int order)
+{/* Params    : (1) Offset of a block from the first block
+ *              (2) Order of the block
+ *  On success: Adds the block to the front of the free list of it's order
+ *  Fails if  : Cannot fail */
+
+	FreeBlock* block = new(this->m_first_block + offset) FreeBlock();
+
+	block->next = this->m_free_lists[order];
+	if (block->next != NULL)
+		block->next->prev = block;
+	this->m_free_lists[order] = block;
+
+	this->m_nonempty_orders |= uint64_t(1) << order;
+	set_bit(this->m_free_bits, get_node_index(offset, order), true);
+}
+
+EMMA_INLINE void emma::allocators::Buddy::remove_free_block(std::size_t offset, unsigned int order)
+{/* Params    : (1) Offset of a free block from the first block
+ *              (2) Order of the block
+ *  On success: Removes the block from the free list of it's order
+ *  Fails if  : Cannot fail, if the block is free */
+
+	FreeBlock* block = reinterpret_cast<FreeBlock*>(this->m_first_block + offset);
+
+	if (block->prev != NULL)
+		block->prev->next = block->next;
+	else
+		this->m_free_lists[order] = block->next;
+	if (block->next != NULL)
+		block->next->prev = block->prev;
+
+	if (this->m_free_lists[order] == NULL)
+		this->m_nonempty_orders &= ~(uint64_t(1) << order);
+	set_bit(this->m_free_bits, get_node_index(offset, order), false);
+}
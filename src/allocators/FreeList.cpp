@@ -7,13 +7,17 @@
  * guarantees that the time complexity for all operations is at most O(log n).  │
  *                                                                              │
  *  - Simplified example of memory layout -                                     │
- * ┌─────────┬─────────┐┌─────────┬──────────────────────┐┌─────────┬─────────┐ │
- * │Next|Prev│Allocated││Next|Prev│ RBnode & free memory ││Next|Prev│Allocated│ │
- * └─────────┴─────────┘└─────────┴──────────────────────┘└─────────┴─────────┘ │
+ * ┌────┬─────────┐┌────┬──────────────────────────────┬──────┐┌────┬─────────┐ │
+ * │Size│Allocated││Size│ RBnode & free memory         │Footer││Size│Allocated│ │
+ * └────┴─────────┘└────┴──────────────────────────────┴──────┘└────┴─────────┘ │
  *                                                                              │
- * Each block of memory always contains a header with a double linked list.     │
- * The list connects nearby blocks together, which helps us achieve a time      │
- * complexity of O(1) for coalescence (merging of nearby free blocks).          │
+ * Each block of memory starts with a boundary tag: one word with the size of   │
+ * the block, a bit for if it's free & a bit for if the block before it is.     │
+ * The next block is found by adding the size, with no pointers to load.        │
+ * Free blocks also end with a copy of their size, a footer, so the block       │
+ * after them can find their start. Used blocks need no footer at all.          │
+ * This gives us a time complexity of O(1) for coalescence (merging of nearby   │
+ * free blocks), with the smallest header we can have.                          │
  *                                                                              │
  * For each free block, there is a red-black tree node following the header.    │
  * These nodes are used only for navigating the free blocks of memory.          │
@@ -21,8 +25,11 @@
  * The nodes do not use up any potential allocatable space, because they are    │
  * stored inside the free memory they represent & are destroyed on allocation.  │
  *                                                                              │
- * Not shown in illustration is any required padding needed for alignment.      │
- * The allocated memory, header and nodes are all naturally aligned.            │
+ * Blocks start & end at multiples of the header's size, which is also the      │
+ * alignment of the data right after it. Data that needs more is moved forward. │
+ * If the gap in front of it is large enough, it becomes a free block of it's   │
+ * own. Otherwise the word right before the data holds the size of the gap.     │
+ * It is always smaller than any block, so it can't be mistaken for a header.   │
  *
  */
 
@@ -31,17 +38,23 @@
 #include <stdint.h>
 #include <memory>
 #include <limits>
+#include <cstring>
+#include <algorithm>
+#include <functional>
 #include <new>
+#include <cstdio>
+
+static_assert(sizeof(emma::RedBlackTree::Node) % sizeof(emma::allocators::FreeList::Header) == 0
+	&& alignof(emma::RedBlackTree::Node) <= sizeof(emma::allocators::FreeList::Header),
+	"Nodes have to fit right after a header, without padding");
+static_assert(emma::allocators::FreeList::SMALL_BIN_COUNT <= 64, "The small bins have a 64 bit bitmap");
 
 static inline bool start_or_size_is_invalid(void* start, std::size_t size)
 {/* Returns true if one of the values is invalid and throws exception if enabled.
     Returns false if both start and size are valid */
 
-	static std::string too_small_error_msg =\
-    	"Memsize can't be under " + std::to_string(emma::allocators::FreeList::MIN_INIT_SIZE);
-
 	if (size < emma::allocators::FreeList::MIN_INIT_SIZE)
-		return emma::return_error<bool>(true, too_small_error_msg);
+		return emma::return_error<bool>(true, "Memsize can't be under FreeList::MIN_INIT_SIZE");
 
 	if (start == NULL)
 		return emma::return_error<bool>(true, "Starting address can't be NULL");
@@ -49,28 +62,127 @@ static inline bool start_or_size_is_invalid(void* start, std::size_t size)
 	return false;
 }
 
-emma::allocators::FreeList::FreeList(void* start, std::size_t size) : emma::BaseAllocator(start, size)
+static inline uintptr_t align_position_up(uintptr_t position, std::size_t alignment)
+{/* Returns the first position at or after the given one, that is aligned */
+
+	return position + (alignment - position % alignment) % alignment;
+}
+
+EMMA_INLINE emma::allocators::FreeList::FreeList(void* start, std::size_t size, bool deferred_coalescing)\
+: emma::BaseAllocator(start, size)
 {/* Params    : (1) Ptr to the start of the memory available for the allocator
  *              (2) Size of the memory available for the allocator
+ *              (3) If true, small freed blocks are kept as they are for reuse,
+ *                  and only coalesced once there are too many of them,
+ *                  an allocation doesn't fit any of them, or on consolidate()
  *  On Success: Initializes the allocator, which will be ready for immediate use.
  *  On failure: Throws an exception if they're enabled.
  *              Otherwise does nothing & attempted allocations return NULL.
  *  Fails if  : There is not enough memory to add a single alligned header/node */
 
-	if (start_or_size_is_invalid(start, size))
+	this->m_superblock = NULL;
+	reset_free_lists(deferred_coalescing);
+	if (!set_memory_bounds(start, size))
 		return; // Also throws an exception if they're enbaled
 
-	// Set this to point to the end of the memory we have available
-	this->m_end_of_memory = reinterpret_cast<Header*>(static_cast<uint8_t*>(start) + size);
-	
 	// Create our first free block of memory, using our entire free memory
-	create_new_memory_block(NULL, this->m_end_of_memory, start);
+	create_new_memory_block(this->m_first_header,
+		static_cast<std::size_t>(this->m_end_of_memory - this->m_first_header) * sizeof(Header));
+}
+
+static inline void* get_persistent_heap_start(void* region)
+{/* Returns where the heap of a persistent region starts, right after it's superblock */
+
+	if (region == NULL)
+		return NULL;
+	return static_cast<uint8_t*>(region) + sizeof(emma::allocators::FreeList::PersistentSuperblock);
+}
+
+static inline std::size_t get_persistent_heap_size(std::size_t region_size)
+{/* Returns the size left for the heap of a persistent region, 0 if there isn't any */
+
+	if (region_size < sizeof(emma::allocators::FreeList::PersistentSuperblock))
+		return 0;
+	return region_size - sizeof(emma::allocators::FreeList::PersistentSuperblock);
+}
+
+static inline bool persistent_region_is_invalid(void* region, std::size_t region_size)
+{/* Returns true if the region can't hold a persistent heap and throws exception if enabled.
+    Returns false if it can */
+
+	if (region == NULL)
+		return emma::return_error<bool>(true, "Persistent region can't be NULL");
+	if (reinterpret_cast<uintptr_t>(region) % alignof(emma::allocators::FreeList::PersistentSuperblock) != 0)
+		return emma::return_error<bool>(true, "Persistent region has to be aligned to 8 bytes");
+	if (get_persistent_heap_size(region_size) < emma::allocators::FreeList::MIN_INIT_SIZE)
+		return emma::return_error<bool>(true,
+			"Persistent region can't be under sizeof(PersistentSuperblock) + FreeList::MIN_INIT_SIZE");
+
+	return false;
+}
+
+static inline uint32_t get_region_alignment(const void* region)
+{/* Returns the largest power of two the region is aligned to, up to PERSISTENT_MAX_ALIGNMENT */
+
+	uintptr_t address = reinterpret_cast<uintptr_t>(region);
+	uintptr_t alignment = address & (~address + 1); // Lowest set bit
+	if (address == 0 || alignment > emma::allocators::FreeList::PERSISTENT_MAX_ALIGNMENT)
+		return emma::allocators::FreeList::PERSISTENT_MAX_ALIGNMENT;
+	return static_cast<uint32_t>(alignment);
+}
+
+EMMA_INLINE emma::allocators::FreeList::FreeList(PersistentMode mode, void* region, std::size_t region_size)\
+: emma::BaseAllocator(get_persistent_heap_start(region), get_persistent_heap_size(region_size))
+{/* Params    : (1) CREATE_PERSISTENT to start a new heap in the region,
+ *                  OPEN_EXISTING to reattach to one made earlier
+ *              (2) Ptr to the start of the region, aligned to 8 bytes. Usually mmap'd from a file.
+ *                  When opening, aligned at least as much as when it was created,
+ *                  up to PERSISTENT_MAX_ALIGNMENT. So that aligned data stays aligned.
+ *              (3) Size of the region, the same every time it's opened
+ *  On Success: The region starts with a superblock & the rest is the heap. When opened,
+ *              every allocation & root made before is still there, even if the region
+ *              is now at a different address. Only sizes are stored inside the heap,
+ *              so pointers to it's data have to be stored as offsets, or through set_root().
+ *              Writing the region back to it's file (msync) is up to the user.
+ *  On failure: Throws an exception if they're enabled.
+ *              Otherwise does nothing & attempted allocations return NULL.
+ *  Fails if  : The region is too small or misaligned, or when opening,
+ *              the superblock or the heap's boundary tags are not valid */
+
+	this->m_superblock = NULL;
+	reset_free_lists(false);
+	if (persistent_region_is_invalid(region, region_size) || !set_memory_bounds(m_memory_location, m_memory_maxsize))
+		return; // Also throws an exception if they're enbaled
+
+	if (mode == OPEN_EXISTING)
+	{
+		// Only the free lists have links, and they are rebuilt from the tags
+		if (!has_persistent_heap(region, region_size) || !heap_tags_are_valid())
+		{
+			this->m_first_header = NULL;
+			emma::return_error<bool>(true, "Persistent region doesn't hold a valid heap, or is less aligned than when created");
+			return;
+		}
+		this->m_superblock = static_cast<PersistentSuperblock*>(region);
+		rebuild_free_lists();
+		return;
+	}
+
+	this->m_superblock = new(region) PersistentSuperblock();
+	this->m_superblock->magic = PERSISTENT_MAGIC;
+	this->m_superblock->version = PERSISTENT_VERSION;
+	this->m_superblock->header_size = sizeof(Header);
+	this->m_superblock->min_block_size = MIN_BLOCK_SIZE;
+	this->m_superblock->region_size = region_size;
+	this->m_superblock->region_alignment = get_region_alignment(region);
+	create_new_memory_block(this->m_first_header,
+		static_cast<std::size_t>(this->m_end_of_memory - this->m_first_header) * sizeof(Header));
 }
 
-emma::allocators::FreeList::~FreeList() {}
+EMMA_INLINE emma::allocators::FreeList::~FreeList() {}
 
 
-static inline bool data_size_is_invalid(std::size_t data_size)
+static inline bool data_size_or_alignment_is_invalid(std::size_t data_size, std::size_t alignment)
 {/* Simple error checking helper for allocate_raw_ptr()
     Returns true if data_size is invalid. Throws exception if they are enabled
     Returns false if data_size is valid */
@@ -78,245 +190,953 @@ static inline bool data_size_is_invalid(std::size_t data_size)
 	if (data_size == 0)
 		return emma::return_error<bool>(true, "Allocation size can't be 0!");
 
-	if (std::numeric_limits<std::size_t>::max() / data_size < 2)
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+		return emma::return_error<bool>(true, "Alignment must be a power of two");
+
+	if (std::numeric_limits<std::size_t>::max() - data_size < alignment + emma::allocators::FreeList::MIN_INIT_SIZE)
 		return emma::return_error<bool>(true, "Allocation size would overflow!");
 
 	return false;
 }
 
-void* emma::allocators::FreeList::allocate_raw_ptr(std::size_t data_size)
-{/* Params    : Size of the allocation we want to make
+static inline std::size_t get_search_size(std::size_t data_size, std::size_t alignment)
+{/* Returns the usable size a free block needs, to fit the data at any alignment.
+    The block must also fit a node once freed. */
+
+	typedef emma::allocators::FreeList FreeList;
+
+	std::size_t	min_data_size = FreeList::MIN_BLOCK_SIZE - sizeof(FreeList::Header);
+	std::size_t	search_size = data_size < min_data_size ? min_data_size : data_size;
+	if (alignment > sizeof(FreeList::Header))
+		search_size += alignment - sizeof(FreeList::Header); // The data after the header is already aligned this much
+	return search_size;
+}
+
+EMMA_INLINE void* emma::allocators::FreeList::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
  *  On success: Returns an aligned pointer to the newly allocated data
  *  On failure: Returns NULL. Throws exception if they are enabled.
- *  Fails if  : There is not enough memory,
- *	        or data_size == 0, or data_size would overflow with padding*/
+ *  Fails if  : There is not enough memory, data_size == 0,
+ *	        alignment is not a power of two or data_size would overflow with padding*/
 
-	if (data_size_is_invalid(data_size))
+	if (data_size_or_alignment_is_invalid(data_size, alignment))
+	{
+		EMMA_STATS(++this->m_stats.failed_allocations);
 		return NULL;
+	}
 
-	// Smallest size that guarantees natural alignment. Extra is trimmed later
-	std::size_t	search_size = HEADER_MAX_PADDING + data_size * 2;
-	search_size = search_size < MIN_INIT_SIZE ? MIN_INIT_SIZE : search_size;
+	// A recently freed block of about the right size is reused as it is
+	if (this->m_deferred_coalescing)
+	{
+		void* cached_ptr = take_cached_block(data_size, alignment);
+		if (cached_ptr != NULL)
+		{
+			EMMA_STATS(count_allocation(usable_size(cached_ptr)));
+			return cached_ptr;
+		}
+		consolidate();
+	}
 
 	// Find best fitting free node
-	emma::RedBlackTree::Node* free_node = this->m_rb_tree.search_best_fit(search_size);
+	emma::RedBlackTree::Node* free_node = search_free_node(get_search_size(data_size, alignment));
 	if (free_node == NULL)
+	{
+		EMMA_STATS(++this->m_stats.failed_allocations);
 		return emma::return_error<void*>(NULL, "No free nodes were found");
+	}
 
-	Header*   header = get_header_placement_from_ptr(free_node);
-	
-	void* aligned_data_ptr = reinterpret_cast<void*>(reinterpret_cast<uint8_t*>(header) + sizeof(Header));
-	std::size_t space_left = free_node->value;
-
-	// This aligns the aligned_data_ptr. Also updates the remaining space.
-	align_to_natural(data_size, aligned_data_ptr, space_left);
-
-	// Move header forward to the closest aligned position behind the data
-	Header* next = header->next;
-	Header* prev = header->prev;
-	std::destroy_at(header);
-	header = get_header_placement_from_ptr(aligned_data_ptr);
-	new(header) Header(next, prev);
-	if (prev != NULL) // Update the previous node to point to us!!
-		prev->next = header;
-	if (next != this->m_end_of_memory) // Update the next node to point to us!!
-		next->prev = header;
-
-	// Make sure we have enough space to create a node when we deallocate it
-	std::size_t space_taken = free_node->value - space_left;
-	data_size = (space_taken + data_size) < MIN_INIT_SIZE ? MIN_INIT_SIZE - space_taken : data_size;
-	space_left -= data_size;
-
-	// Remove the RB free node
-	this->m_rb_tree.remove_node(free_node);
-	std::destroy_at(free_node);
-
-	split_extra_memory_into_new_block(\
-		space_left, header, static_cast<uint8_t*>(aligned_data_ptr) + data_size);
+	// Take the whole block, then give back what's left after the data
+	Header*	header = take_free_block(free_node);
+	void*	aligned_data_ptr = place_data(header, alignment);
+	trim_block_to_size(header, aligned_data_ptr, data_size);
 
+	EMMA_STATS(count_allocation(usable_size(aligned_data_ptr)));
 	return aligned_data_ptr;
 }
 
-void emma::allocators::FreeList::free_raw_ptr(void *data)
+EMMA_INLINE void emma::allocators::FreeList::free_raw_ptr(void *data)
 {/* Params    : (1) Data which has been previously allocated
  *  On success: Deallocates the requested data
  *  On failure: Does nothing
  *  Fails if  : Data is NULL. Otherwise cannot fail (assuming ptr is valid) */
 
-	Header*	our_header   = get_header_placement_from_ptr(data);
-	Header*	left_header  = our_header->prev;
-	Header*	right_header = our_header->next;
-	Header*	new_next     = our_header->next;
+	if (data == NULL)
+		return;
+	EMMA_STATS(count_free(usable_size(data)));
+
+	if (this->m_deferred_coalescing && cache_freed_block(data))
+		return;
+	release_block(data);
+}
+
+EMMA_INLINE void emma::allocators::FreeList::release_block(void* data)
+{/* Params    : (1) Data of a used block
+ *  On success: Merges the block with the free blocks next to it, and puts it in a bin or the tree
+ *  Fails if  : Cannot fail (assuming ptr is valid) */
+
+	Header*		header = get_header_placement_from_ptr(data);
+	Header*		right_header = header->get_next();
+	std::size_t	size = header->get_size();
+
+	// If the block on our right is free, take it's memory
+	if (right_header != this->m_end_of_memory && right_header->is_free())
+	{
+		EMMA_STATS(++this->m_stats.merges);
+		remove_free_node(right_header->get_node());
+		std::destroy_at(right_header->get_node());
+		size += right_header->get_size();
+	}
+	// If the block on our left is free, it's footer tells us where it starts
+	if (header->is_prev_free())
+	{
+		EMMA_STATS(++this->m_stats.merges);
+		Header* left_header = header->get_prev();
+		remove_free_node(left_header->get_node());
+		std::destroy_at(left_header->get_node());
+		size += left_header->get_size();
+		header = left_header;
+	}
+
+	create_new_memory_block(header, size);
+}
+
+
+EMMA_INLINE void* emma::allocators::FreeList::reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment)
+{/* Params    : (1) Data which has been previously allocated, or NULL
+ *              (2) New size of the data
+ *              (3) Alignment of the data, must be a power of two
+ *  On success: Returns a pointer to the resized data. Same as ptr, if it could
+ *              be resized in place. Otherwise the data is copied to a new
+ *              allocation & ptr is freed.
+ *              If ptr is NULL, works just like allocate_raw_ptr().
+ *              If new_size is 0, frees ptr & returns NULL.
+ *  On failure: Returns NULL, ptr is left as is. Throws exception if they are enabled.
+ *  Fails if  : Neither there is space next to ptr, nor a free block large enough */
+
+	if (ptr == NULL || new_size == 0 || alignment_is_invalid(alignment))
+		return emma::BaseAllocator::reallocate_raw_ptr(ptr, new_size, alignment);
+
+	Header* header = get_header_placement_from_ptr(ptr);
+
+	// In place, taking the free block on our right if there is one.
+	// Even when shrinking, so that our extra memory gets merged with it.
+	if (reinterpret_cast<uintptr_t>(ptr) % alignment == 0)
+	{
+		std::size_t available = usable_size(ptr);
+		EMMA_STATS(std::size_t old_size = available);
+		Header* next = header->get_next();
+		bool	next_is_free = (next != this->m_end_of_memory && next->is_free());
+		if (next_is_free)
+			available += next->get_size();
+
+		if (new_size <= available)
+		{
+			if (next_is_free)
+				absorb_next_free_block(header);
+			trim_block_to_size(header, ptr, new_size);
+			EMMA_STATS(count_resize(old_size, usable_size(ptr)));
+			return ptr;
+		}
+	}
+
+	// Last resort, move it
+	void* new_ptr = allocate_raw_ptr(new_size, alignment);
+	if (new_ptr == NULL)
+		return NULL; // Also throws an exception if they're enabled
+
+	std::size_t old_size = usable_size(ptr);
+	std::memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+	free_raw_ptr(ptr);
+	return new_ptr;
+}
+
+EMMA_INLINE std::size_t emma::allocators::FreeList::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Returns the amount of bytes from ptr to the next block
+ *  Fails if  : Returns 0 if ptr is NULL. Otherwise cannot fail */
+
+	if (ptr == NULL)
+		return 0;
+
+	Header* header = get_header_placement_from_ptr(ptr);
+	return static_cast<std::size_t>(\
+		reinterpret_cast<uintptr_t>(header->get_next()) - reinterpret_cast<uintptr_t>(ptr));
+}
+
+
+EMMA_INLINE std::size_t emma::allocators::FreeList::allocate_bulk(\
+std::size_t data_size, std::size_t count, void** out_ptrs, std::size_t alignment)
+{/* Params    : (1) Size of each allocation
+ *              (2) Amount of allocations to make
+ *              (3) Array with space for 'count' pointers, filled with the results
+ *              (4) Alignment of the allocations, must be a power of two
+ *  On success: Carves all of the allocations out of as few free blocks as
+ *              possible. Each free block is removed from the tree once, and
+ *              what's left of it is inserted back once. Returns 'count'.
+ *  On failure: Returns the amount of allocations that did succeed.
+ *              They are always at the start of the array.
+ *              Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory, data_size == 0,
+ *              or alignment is not a power of two */
+
+	if (count == 0)
+		return 0;
+	if (data_size_or_alignment_is_invalid(data_size, alignment))
+	{
+		EMMA_STATS(this->m_stats.failed_allocations += count);
+		return 0;
+	}
+	consolidate(); // Recently freed blocks might be what joins two free blocks together
+
+	// Same as allocate_raw_ptr(). Each block also needs a header, and to end aligned.
+	std::size_t	search_size = get_search_size(data_size, alignment);
+	std::size_t	block_size_limit = search_size + 2 * sizeof(Header);
+
+	std::size_t allocated = 0;
+	while (allocated < count)
+	{
+		// Best fit for everything that's left, otherwise the largest block
+		std::size_t left = count - allocated;
+		emma::RedBlackTree::Node* free_node = NULL;
+		if (left <= std::numeric_limits<std::size_t>::max() / block_size_limit)
+			free_node = search_free_node(block_size_limit * left);
+		if (free_node == NULL)
+			free_node = search_largest_free_node();
+		if (free_node == NULL || free_node->value < search_size)
+			break;
+
+		allocated += carve_free_block(free_node, data_size, alignment, left, out_ptrs + allocated);
+	}
+
+	EMMA_STATS(for (std::size_t i = 0; i < allocated; ++i) count_allocation(usable_size(out_ptrs[i])));
+	EMMA_STATS(this->m_stats.failed_allocations += count - allocated);
+
+	if (allocated < count)
+		return emma::return_error<std::size_t>(allocated, "No free nodes were found");
+	return allocated;
+}
+
+EMMA_INLINE void emma::allocators::FreeList::free_bulk(void** ptrs, std::size_t count)
+{/* Params    : (1) Array of previously allocated pointers. Gets sorted.
+ *              (2) Amount of pointers in the array
+ *  On success: Sorts the pointers by address, so that blocks next to each
+ *              other in memory are found together. Every such run is joined
+ *              into one block first, and then freed with one tree operation.
+ *  Fails if  : Cannot fail (assuming the pointers are valid). NULLs are skipped */
+
+	std::sort(ptrs, ptrs + count, std::less<void*>());
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (ptrs[i] == NULL)
+			continue;
+
+		Header* first = get_header_placement_from_ptr(ptrs[i]);
+		void*	first_data = ptrs[i];
+		EMMA_STATS(std::size_t first_size = usable_size(first_data));
+
+		// Join the blocks right after us, which are also being freed
+		while (i + 1 < count && first->get_next() != this->m_end_of_memory
+			&& get_header_placement_from_ptr(ptrs[i + 1]) == first->get_next())
+		{
+			EMMA_STATS(count_free(usable_size(ptrs[i + 1])));
+			Header* joined = first->get_next();
+			first->set_size(first->get_size() + joined->get_size());
+			std::destroy_at(joined);
+			++i;
+		}
+		// free_raw_ptr() counts the whole run, not just the first block
+		EMMA_STATS(this->m_stats.bytes_in_use += usable_size(first_data) - first_size);
+		free_raw_ptr(first_data);
+	}
+}
+
+
+static inline void* get_quick_list_link(void* data)
+{/* Returns the next block of a quick list, stored in the data of a waiting block.
+    Compact data is only aligned to 4 bytes, so the link is copied out. */
+
+	void* next;
+	std::memcpy(&next, data, sizeof(next));
+	return next;
+}
+
+static inline void set_quick_list_link(void* data, void* next)
+{/* Stores the next block of a quick list in the data of a waiting block */
+
+	std::memcpy(data, &next, sizeof(next));
+}
+
+EMMA_INLINE std::size_t emma::allocators::FreeList::consolidate(std::size_t max_blocks)
+{/* Params    : (1) Max amount of recently freed blocks to coalesce, all of them by default
+ *  On success: Merges that many recently freed blocks with their neighbours,
+ *              smallest ones first, and puts them in a bin or the tree.
+ *              Returns the amount of blocks still waiting.
+ *  Fails if  : Cannot fail. Without deferred coalescing there is nothing to do */
+
+	for (std::size_t released = 0; released < max_blocks && this->m_quick_list_bitmap != 0; ++released)
+	{
+		std::size_t bin = static_cast<std::size_t>(__builtin_ctzll(this->m_quick_list_bitmap));
+		void* data = this->m_quick_lists[bin];
+		this->m_quick_lists[bin] = get_quick_list_link(data);
+		if (this->m_quick_lists[bin] == NULL)
+			this->m_quick_list_bitmap &= ~(uint64_t(1) << bin);
+		--this->m_quick_list_count;
+		release_block(data);
+	}
+	return this->m_quick_list_count;
+}
+
+
+EMMA_INLINE emma::Stats emma::allocators::FreeList::get_stats() const
+{/* On success: Returns the counters, with the free blocks measured from the tree.
+ *              O(n) in the amount of free blocks. Blocks waiting with deferred
+ *              coalescing are counted as free blocks of their own, even if
+ *              consolidate() would merge them with a neighbour.
+ *  Fails if  : Cannot fail */
+
+	emma::Stats stats = emma::BaseAllocator::get_stats();
+	this->m_rb_tree.measure(stats.free_block_count, stats.free_bytes,
+		stats.largest_free_block, stats.tree_depth);
+
+	// The blocks in the bins are smaller than any in the tree
+	for (std::size_t bin = 0; bin < SMALL_BIN_COUNT; ++bin)
+	{
+		for (const emma::RedBlackTree::Node* node = this->m_small_bins[bin]; node != NULL; node = node->get_same())
+		{
+			++stats.free_block_count;
+			stats.free_bytes += node->value;
+			if (node->value > stats.largest_free_block)
+				stats.largest_free_block = node->value;
+		}
+	}
+
+	// As large as they would be once released, before any merging
+	for (std::size_t bin = 0; bin < SMALL_BIN_COUNT; ++bin)
+	{
+		for (void* data = this->m_quick_lists[bin]; data != NULL; data = get_quick_list_link(data))
+		{
+			std::size_t size = get_header_placement_from_ptr(data)->get_size() - sizeof(Header);
+			++stats.free_block_count;
+			stats.free_bytes += size;
+			if (size > stats.largest_free_block)
+				stats.largest_free_block = size;
+		}
+	}
+	return stats;
+}
+
+
+EMMA_INLINE bool emma::allocators::FreeList::walk_heap(BlockInfo& block) const
+{/* Params    : (1) The block we are at. Default constructed to start from the first one.
+ *  On success: Moves to the next block in memory & fills it in. Returns true.
+ *              The heap must not change during the walk. Blocks waiting
+ *              with deferred coalescing are still used until consolidate().
+ *
+ *              emma::allocators::FreeList::BlockInfo block;
+ *              while (heap.walk_heap(block)) ...
+ *
+ *  On failure: Returns false, the block is left as is
+ *  Fails if  : There are no more blocks, or the constructor failed */
+
+	Header* header = this->m_first_header;
+	if (block.address != NULL)
+		header = static_cast<Header*>(block.address)->get_next();
+	if (header == NULL || header == this->m_end_of_memory)
+		return false;
+
+	// Only the first block can have padding in front of it, and only
+	// the last one after it, which it's size includes.
+	block.address = header;
+	block.size = header->get_size();
+	if (header->get_next() == this->m_end_of_memory)
+		block.size += get_unaligned_end_size();
+	block.padding = 0;
+	if (header == this->m_first_header)
+		block.padding = static_cast<std::size_t>(\
+			reinterpret_cast<uintptr_t>(header) - reinterpret_cast<uintptr_t>(m_memory_location));
+	block.is_free = header->is_free();
+	return true;
+}
 
-	// If the block on our right is free, destroy it and extend our own memory
-	if (right_header != this->m_end_of_memory && right_header->node != NULL)
+EMMA_INLINE emma::allocators::FreeList::Fragmentation emma::allocators::FreeList::get_fragmentation() const
+{/* On success: Walks every block & returns a summary of them. O(n) in the amount of blocks.
+ *              The padding in front of the data of used blocks is counted as
+ *              used, as only the pointer to the data knows where it starts.
+ *              So are blocks waiting with deferred coalescing, call
+ *              consolidate() first to count them as free.
+ *  Fails if  : Cannot fail. Returns all zeroes if the constructor failed */
+
+	Fragmentation report;
+	BlockInfo block;
+	while (walk_heap(block))
 	{
-		new_next = right_header->next;
-		our_header->next = right_header->next;
-		if (right_header->next != this->m_end_of_memory)
-			right_header->next->prev = our_header;
-
-		this->m_rb_tree.remove_node(right_header->node);
-		std::destroy_at(right_header->node);
-		std::destroy_at(right_header);
-		right_header = NULL;
+		std::size_t usable = static_cast<Header*>(block.address)->get_size() - sizeof(Header);
+		++report.block_count;
+		report.header_bytes += sizeof(Header);
+		report.padding_bytes += block.padding + (block.size - usable - sizeof(Header));
+		if (!block.is_free)
+		{
+			report.used_bytes += usable;
+			continue;
+		}
+
+		++report.free_block_count;
+		report.free_bytes += usable;
+		if (usable > report.largest_free_block)
+			report.largest_free_block = usable;
+
+		std::size_t bucket = 0;
+		while ((usable >> bucket) > 1)
+			++bucket;
+		++report.free_size_histogram[bucket];
 	}
-	// If the block on our left is free, destroy ourselves and extend left block
-	if (left_header != NULL && left_header->node != NULL)
+
+	// 0 if all of the free memory is in one block, closer to 1 the more it's split
+	if (report.free_bytes != 0)
+		report.external_ratio = 1.0 - static_cast<double>(report.largest_free_block)
+			/ static_cast<double>(report.free_bytes);
+	return report;
+}
+
+EMMA_INLINE void emma::allocators::FreeList::dump_heap(std::FILE* stream, bool as_csv) const
+{/* Params    : (1) Stream to write to, e.g. stdout or an opened file
+ *              (2) If true, writes one CSV row per block without a summary
+ *  On success: Writes every block, one per line, & then the summary.
+ *              Nothing is allocated, so it can be used when allocations fail.
+ *              Blocks waiting with deferred coalescing are written as used.
+ *  Fails if  : Stream is NULL, in which case nothing is written */
+
+	if (stream == NULL)
+		return;
+
+	BlockInfo block;
+	if (as_csv)
 	{
-		// Update our right block to point to our left block
-		if (right_header != NULL && right_header != this->m_end_of_memory)
-			right_header->prev = left_header;
+		std::fprintf(stream, "address,size,state,padding\n");
+		while (walk_heap(block))
+			std::fprintf(stream, "%p,%zu,%s,%zu\n", block.address, block.size,
+				block.is_free ? "free" : "used", block.padding);
+		return;
+	}
 
-		left_header->next = our_header->next;
+	std::fprintf(stream, "FreeList heap at %p, %zu bytes\n", m_memory_location, m_memory_maxsize);
+	std::fprintf(stream, "  %-18s %12s  %-5s %8s\n", "address", "size", "state", "padding");
+	while (walk_heap(block))
+		std::fprintf(stream, "  %-18p %12zu  %-5s %8zu\n", block.address, block.size,
+			block.is_free ? "free" : "used", block.padding);
+
+	Fragmentation report = get_fragmentation();
+	std::fprintf(stream, "%zu blocks, %zu free. %zu bytes used, %zu bytes free, largest free block %zu\n",
+		report.block_count, report.free_block_count, report.used_bytes,
+		report.free_bytes, report.largest_free_block);
+	std::fprintf(stream, "%zu bytes of headers, %zu bytes of padding, external fragmentation %.3f\n",
+		report.header_bytes, report.padding_bytes, report.external_ratio);
+	for (std::size_t bucket = 0; bucket < HISTOGRAM_SIZE; ++bucket)
+		if (report.free_size_histogram[bucket] != 0)
+			std::fprintf(stream, "  free blocks of %zu+ bytes: %zu\n",
+				std::size_t(1) << bucket, report.free_size_histogram[bucket]);
+}
 
-		this->m_rb_tree.remove_node(our_header->node);
-		std::destroy_at(our_header->node);
-		std::destroy_at(our_header);
 
-		std::size_t new_memory_size = reinterpret_cast<std::size_t>(\
-			reinterpret_cast<uintptr_t>(left_header->next) - reinterpret_cast<uintptr_t>(left_header));
+EMMA_INLINE bool emma::allocators::FreeList::has_persistent_heap(const void* region, std::size_t region_size)
+{/* Params    : (1) Ptr to the start of a region
+ *              (2) Size of the region
+ *  On success: Returns true if the region starts with a superblock made by a FreeList
+ *              with the same sizes as ours, for a region of this size, and the region
+ *              is aligned at least as much as when it was created
+ *  On failure: Returns false
+ *  Fails if  : Cannot fail */
+
+	if (region == NULL || reinterpret_cast<uintptr_t>(region) % alignof(PersistentSuperblock) != 0
+		|| region_size < sizeof(PersistentSuperblock))
+		return false;
+
+	const PersistentSuperblock* superblock = static_cast<const PersistentSuperblock*>(region);
+	if (superblock->magic != PERSISTENT_MAGIC || superblock->version != PERSISTENT_VERSION
+		|| superblock->header_size != sizeof(Header) || superblock->min_block_size != MIN_BLOCK_SIZE
+		|| superblock->region_size != region_size)
+		return false;
+
+	// Data aligned more than the region would move out of alignment
+	uint32_t alignment = superblock->region_alignment;
+	if (alignment == 0 || alignment > PERSISTENT_MAX_ALIGNMENT || (alignment & (alignment - 1)) != 0
+		|| reinterpret_cast<uintptr_t>(region) % alignment != 0)
+		return false;
+
+	for (std::size_t i = 0; i < PERSISTENT_ROOT_COUNT; ++i)
+	{
+		if (superblock->root_offsets[i] >= region_size
+			|| superblock->root_names[i][PERSISTENT_ROOT_NAME_SIZE - 1] != '\0')
+			return false;
+	}
+	return true;
+}
 
-		// Update size of the left block's node
-		this->m_rb_tree.remove_node(left_header->node);
-		left_header->node->value = new_memory_size;
-		this->m_rb_tree.insert_node(left_header->node);
+EMMA_INLINE bool emma::allocators::FreeList::set_root(const char* name, void* ptr)
+{/* Params    : (1) Name of the root, shorter than PERSISTENT_ROOT_NAME_SIZE
+ *              (2) Ptr inside the heap, or NULL to remove the root
+ *  On success: Stores the ptr's offset under the name, to be found by get_root()
+ *              after the heap is opened again. Returns true.
+ *  On failure: Throws an exception if they're enabled. Returns false otherwise.
+ *  Fails if  : The heap isn't persistent, the name is invalid, the ptr is outside
+ *              of the heap, or all PERSISTENT_ROOT_COUNT roots are in use */
+
+	if (this->m_superblock == NULL)
+		return emma::return_error<bool>(false, "Roots can only be set on a persistent heap");
+	if (name == NULL || name[0] == '\0' || std::strlen(name) >= PERSISTENT_ROOT_NAME_SIZE)
+		return emma::return_error<bool>(false, "Root name has to be 1 to PERSISTENT_ROOT_NAME_SIZE - 1 chars");
+	if (ptr != NULL && (ptr < static_cast<void*>(this->m_first_header) || ptr >= static_cast<void*>(this->m_end_of_memory)))
+		return emma::return_error<bool>(false, "Root has to point inside the heap");
+
+	// The root's own slot if it exists, otherwise the first unused one
+	std::size_t slot = PERSISTENT_ROOT_COUNT;
+	for (std::size_t i = 0; i < PERSISTENT_ROOT_COUNT; ++i)
+	{
+		if (this->m_superblock->root_offsets[i] == 0)
+		{
+			if (slot == PERSISTENT_ROOT_COUNT)
+				slot = i;
+			continue;
+		}
+		if (std::strcmp(this->m_superblock->root_names[i], name) != 0)
+			continue;
+		slot = i; // The root already exists, replace or remove it
+		break;
 	}
-	else // Left block isn't free or is NULL
+
+	if (slot == PERSISTENT_ROOT_COUNT)
+		return ptr == NULL || emma::return_error<bool>(false, "All PERSISTENT_ROOT_COUNT roots are in use");
+	if (ptr == NULL)
 	{
-		std::destroy_at(our_header);
-		if (left_header == NULL) // We are the root block. We can reset padding.
-			our_header = static_cast<Header*>(m_memory_location);
+		this->m_superblock->root_offsets[slot] = 0;
+		std::memset(this->m_superblock->root_names[slot], 0, PERSISTENT_ROOT_NAME_SIZE);
+		return true;
+	}
+
+	std::strcpy(this->m_superblock->root_names[slot], name);
+	this->m_superblock->root_offsets[slot] = static_cast<uint64_t>(static_cast<uint8_t*>(ptr)
+		- reinterpret_cast<uint8_t*>(this->m_superblock));
+	return true;
+}
+
+EMMA_INLINE void* emma::allocators::FreeList::get_root(const char* name) const
+{/* Params    : (1) Name given to set_root()
+ *  On success: Returns the ptr stored under the name, at the region's current address
+ *  On failure: Returns NULL
+ *  Fails if  : The heap isn't persistent, or there is no root with the name */
 
-		create_new_memory_block(left_header, new_next, static_cast<void*>(our_header));
+	if (this->m_superblock == NULL || name == NULL)
+		return NULL;
+
+	for (std::size_t i = 0; i < PERSISTENT_ROOT_COUNT; ++i)
+	{
+		if (this->m_superblock->root_offsets[i] != 0
+			&& std::strcmp(this->m_superblock->root_names[i], name) == 0)
+			return reinterpret_cast<uint8_t*>(this->m_superblock) + this->m_superblock->root_offsets[i];
 	}
+	return NULL;
+}
+
+
+EMMA_INLINE std::size_t emma::allocators::FreeList::get_unaligned_end_size() const
+{/* On success: Returns the amount of bytes after the last block, too few to align
+ *  Fails if  : Cannot fail */
+
+	return static_cast<std::size_t>(reinterpret_cast<uintptr_t>(m_memory_location) + m_memory_maxsize
+		- reinterpret_cast<uintptr_t>(this->m_end_of_memory));
 }
 
 
-void emma::allocators::FreeList::split_extra_memory_into_new_block(\
-std::size_t space_left, Header* prev_header, void* extra_memory)
-{/* Params    : (1) Free space left over from an allocation
- *              (2) Ptr to header of what we just allocated
- *              (3) Ptr to the unused extra memory
- *  On success: Creates new header and RB-Node inside the leftover space.
+EMMA_INLINE void emma::allocators::FreeList::absorb_next_free_block(Header* header)
+{/* Params    : (1) Ptr to a header, which has a free block on it's right
+ *  On success: Destroys the free block & adds it's memory to our block
+ *  Fails if  : Cannot fail, if the next block is free */
+
+	Header* next = header->get_next();
+
+	remove_free_node(next->get_node());
+	std::destroy_at(next->get_node());
+	header->set_size(header->get_size() + next->get_size());
+	std::destroy_at(next);
+
+	next = header->get_next();
+	if (next != this->m_end_of_memory)
+		next->set_prev_free(false);
+}
+
+EMMA_INLINE void emma::allocators::FreeList::trim_block_to_size(Header* header, void* data, std::size_t data_size)
+{/* Params    : (1) Ptr to the header of an allocated block, with no free block on it's right
+ *              (2) Ptr to the data of the block
+ *              (3) Size of the data the block should keep
+ *  On success: Splits the extra memory after the data into a new free block
  *  On failure: Does nothing
- *  Fails if  : There is not enough memory to add aligned headers/nodes */
+ *  Fails if  : The extra memory is too small to be a block of it's own */
 
-	if (space_left < (HEADER_MAX_PADDING + NODE_MAX_PADDING))
-			return ; // Not enough space for a new block
-	
-	std::size_t original_space_left = space_left;
+	// Make sure we have enough space to create a node when we deallocate it
+	uintptr_t block_start = reinterpret_cast<uintptr_t>(header);
+	uintptr_t data_end = reinterpret_cast<uintptr_t>(data) + data_size;
+	if (data_end < block_start + MIN_BLOCK_SIZE)
+		data_end = block_start + MIN_BLOCK_SIZE;
+
+	uintptr_t split = align_position_up(data_end, sizeof(Header));
+	uintptr_t next = reinterpret_cast<uintptr_t>(header->get_next());
+	if (split > next || next - split < MIN_BLOCK_SIZE)
+		return; // Not enough space for a new block
+
+	header->set_size(static_cast<std::size_t>(split - block_start));
+	create_new_memory_block(reinterpret_cast<Header*>(split), static_cast<std::size_t>(next - split));
+}
 
-	// Figure out where to put the header in an aligned way
-	void*	aligned_header = extra_memory;
-	align_to_natural(sizeof(Header), aligned_header, space_left);
 
-	// Same for the node
-	void*	aligned_node = static_cast<uint8_t*>(aligned_header) + sizeof(Header);
-	align_to_natural(sizeof(emma::RedBlackTree::Node), aligned_node, space_left);
+EMMA_INLINE std::size_t emma::allocators::FreeList::carve_free_block(emma::RedBlackTree::Node* free_node,\
+std::size_t data_size, std::size_t alignment, std::size_t count, void** out_ptrs)
+{/* Params    : (1) Free node, of a block which fits at least one allocation
+ *              (2) Size of each allocation
+ *              (3) Alignment of the allocations, must be a power of two
+ *              (4) Max amount of allocations to carve
+ *              (5) Array with space for 'count' pointers, filled with the results
+ *  On success: Carves allocations one after another from the start of the
+ *              block, and puts what's left into a new free block.
+ *              Returns the amount of allocations carved.
+ *  Fails if  : Cannot fail, if the block fits at least one allocation */
+
+	// The rest of the block is a used block of it's own, until it's carved up
+	Header*		rest = take_free_block(free_node);
+	uintptr_t	end = reinterpret_cast<uintptr_t>(rest->get_next());
+	std::size_t	carved = 0;
+	while (carved < count)
+	{
+		// Same as place_data(), checking that the data fits first
+		uintptr_t	block_start = reinterpret_cast<uintptr_t>(rest);
+		uintptr_t	data = align_position_up(block_start + sizeof(Header), alignment);
+		std::size_t	gap = static_cast<std::size_t>(data - block_start - sizeof(Header));
+		if (gap >= MIN_BLOCK_SIZE)
+			block_start += gap;
+
+		// Make sure we have enough space to create a node when we deallocate it
+		uintptr_t	data_end = data + data_size;
+		if (data_end < block_start + MIN_BLOCK_SIZE)
+			data_end = block_start + MIN_BLOCK_SIZE;
+		if (data_end > end)
+			break;
+
+		place_data(rest, alignment);
+		out_ptrs[carved++] = reinterpret_cast<void*>(data);
+
+		uintptr_t split = align_position_up(data_end, sizeof(Header));
+		if (split > end || end - split < MIN_BLOCK_SIZE)
+			return carved; // The last allocation keeps what's left
+		rest->set_size(static_cast<std::size_t>(split - block_start));
+		rest = new(reinterpret_cast<void*>(split)) Header(static_cast<std::size_t>(end - split), 0);
+	}
+
+	// Shouldn't happen without allocations, but the block can't get lost either way
+	create_new_memory_block(rest, static_cast<std::size_t>(end - reinterpret_cast<uintptr_t>(rest)));
+	return carved;
+}
+
 
-	// Move header to closest aligned position behind the node
-	aligned_header = get_header_placement_from_ptr(aligned_node);
-	std::size_t	memory_left_minus_header = reinterpret_cast<std::size_t>(original_space_left \
-		- (reinterpret_cast<uintptr_t>(aligned_header) - reinterpret_cast<uintptr_t>(extra_memory))
-		- sizeof(Header));
+EMMA_INLINE void emma::allocators::FreeList::create_new_memory_block(Header* header, std::size_t size)
+{/* Params    : (1) Ptr to where the block starts, the block before it must be used
+ *              (2) Size of the block, header included. The block after it must be used.
+ *  On success: Creates a free header, it's RB-Node & footer inside the space,
+ *              and tells the next block that we are free.
+ *  Fails if  : Cannot fail, if size is at least MIN_BLOCK_SIZE */
+
+	new(header) Header(size, Header::FREE_BIT);
 
 	// Construct new node & store the size available (minus the header)
-	new(aligned_node) emma::RedBlackTree::Node(memory_left_minus_header);
-	this->m_rb_tree.insert_node(static_cast<emma::RedBlackTree::Node*>(aligned_node));
-
-	// Construct new header & update the linked list
-	new(aligned_header) Header(prev_header->next, prev_header);
-	prev_header->next = static_cast<Header*>(aligned_header);
-	static_cast<Header*>(aligned_header)->node = static_cast<emma::RedBlackTree::Node*>(aligned_node);	
- }
-
-
-void emma::allocators::FreeList::create_new_memory_block(\
-Header* prev_header, Header* next_header, void* deallocated_ptr)
-{/* Params    : (1) Ptr to a header on our left (or NULL if it doesn't exist)
- *              (2) Ptr to a header on our right (or end of memory if it doesn't exist)
- *              (3) Ptr to the unused memory
- *  On success: Creates new header and RB-Node inside the space.
- *  On failure: Does nothing
- *  Fails if  : There is not enough memory, or next_header is NULL*/
+	emma::RedBlackTree::Node* node = new(header->get_node()) emma::RedBlackTree::Node(size - sizeof(Header));
+	insert_free_node(node);
+
+	Header* next = header->get_next();
+	if (next == this->m_end_of_memory)
+		return;
+	*(reinterpret_cast<Header::Tag*>(next) - 1) = static_cast<Header::Tag>(size);
+	next->set_prev_free(true);
+}
+
+EMMA_INLINE void emma::allocators::FreeList::reset_free_lists(bool deferred_coalescing)
+{/* Params    : (1) If freed blocks wait for reuse, see the constructor
+ *  On success: Empties the bins & quick lists, and marks the heap as not set up yet
+ *  Fails if  : Cannot fail */
+
+	this->m_first_header = NULL;
+	this->m_small_bin_bitmap = 0;
+	this->m_deferred_coalescing = deferred_coalescing;
+	this->m_quick_list_bitmap = 0;
+	this->m_quick_list_count = 0;
+	for (std::size_t bin = 0; bin < SMALL_BIN_COUNT; ++bin)
+	{
+		this->m_small_bins[bin] = NULL;
+		this->m_quick_lists[bin] = NULL;
+	}
+}
+
+EMMA_INLINE bool emma::allocators::FreeList::set_memory_bounds(void* start, std::size_t size)
+{/* Params    : (1) Ptr to the start of the memory available for the heap
+ *              (2) Size of the memory available for the heap
+ *  On success: Sets where the first block starts & where the last one ends. Returns true.
+ *  On failure: Throws an exception if they're enabled. Returns false otherwise.
+ *  Fails if  : There is not enough memory to add a single alligned header/node */
+
+	if (start_or_size_is_invalid(start, size))
+		return false;
+
+	// Anything past what the compact tags can reach is left unused
+	# if EMMA_COMPACT_FREELIST
+	if (size > COMPACT_MAX_SIZE)
+	{
+		size = COMPACT_MAX_SIZE;
+		this->m_memory_maxsize = size;
+	}
+	# endif
+
+	// Blocks start & end at aligned positions, anything outside of them is left unused
+	uintptr_t first = align_position_up(reinterpret_cast<uintptr_t>(start), sizeof(Header));
+	uintptr_t end = reinterpret_cast<uintptr_t>(start) + size;
+	end -= end % sizeof(Header);
+	this->m_first_header = reinterpret_cast<Header*>(first);
+	this->m_end_of_memory = reinterpret_cast<Header*>(end);
+	return true;
+}
+
+EMMA_INLINE bool emma::allocators::FreeList::heap_tags_are_valid() const
+{/* On success: Returns true if the boundary tags from the first block to the end of memory
+ *              describe a heap this FreeList could have made
+ *  On failure: Returns false
+ *  Fails if  : A size is too small, unaligned or past the end, a free block has a free
+ *              neighbour or a wrong footer, or a block is wrong about it's neighbour */
+
+	bool prev_free = false;
+	for (Header* header = this->m_first_header; header != this->m_end_of_memory; header = header->get_next())
+	{
+		std::size_t size = header->get_size();
+		std::size_t size_left = static_cast<std::size_t>(this->m_end_of_memory - header) * sizeof(Header);
+		if (size < MIN_BLOCK_SIZE || size % sizeof(Header) != 0 || size > size_left)
+			return false;
+		if (header->is_prev_free() != prev_free || (prev_free && header->is_free()))
+			return false;
+
+		prev_free = header->is_free();
+		if (prev_free && size != size_left && *(reinterpret_cast<Header::Tag*>(header->get_next()) - 1) != size)
+			return false;
+	}
+	return true;
+}
+
+EMMA_INLINE void emma::allocators::FreeList::rebuild_free_lists()
+{/* On success: Gives every free block a new node in a bin or the tree,
+ *              the old ones pointed to where the heap used to be mapped.
+ *  Fails if  : Cannot fail, if heap_tags_are_valid() */
+
+	for (Header* header = this->m_first_header; header != this->m_end_of_memory; header = header->get_next())
+	{
+		if (header->is_free())
+			insert_free_node(new(header->get_node()) emma::RedBlackTree::Node(header->get_size() - sizeof(Header)));
+	}
+}
+
+static inline std::size_t get_small_bin(std::size_t size)
+{/* Returns the bin of free blocks with this much usable memory, rounded up.
+    SMALL_BIN_COUNT or more if the size is too large for any bin */
+
+	typedef emma::allocators::FreeList FreeList;
 
-	if (next_header == NULL)
+	std::size_t smallest = FreeList::MIN_BLOCK_SIZE - sizeof(FreeList::Header);
+	if (size <= smallest)
+		return 0;
+	return (size - smallest + sizeof(FreeList::Header) - 1) / sizeof(FreeList::Header);
+}
+
+EMMA_INLINE void emma::allocators::FreeList::insert_free_node(emma::RedBlackTree::Node* node)
+{/* Params    : (1) Node of a free block
+ *  On success: Adds the node to the front of it's bin if it's small, otherwise to the tree
+ *  Fails if  : Cannot fail */
+
+	std::size_t bin = get_small_bin(node->value);
+	if (bin >= SMALL_BIN_COUNT)
+	{
+		this->m_rb_tree.insert_node(node);
 		return;
+	}
 
-	std::size_t space_left = static_cast<std::size_t>(\
-	reinterpret_cast<uintptr_t>(next_header) - reinterpret_cast<uintptr_t>(deallocated_ptr));
+	// Linked just like the tree chains nodes of the same size
+	node->set_parent(NULL);
+	node->set_same(this->m_small_bins[bin]);
+	if (this->m_small_bins[bin] != NULL)
+		this->m_small_bins[bin]->set_parent(node);
+	this->m_small_bins[bin] = node;
+	this->m_small_bin_bitmap |= uint64_t(1) << bin;
+}
 
-	std::size_t original_space_left = space_left;
+EMMA_INLINE void emma::allocators::FreeList::remove_free_node(emma::RedBlackTree::Node* node)
+{/* Params    : (1) Node of a free block, in a bin or the tree
+ *  On success: Removes the node from where it is. Does not deconstruct it!
+ *  Fails if  : Cannot fail */
 
-	if (space_left < (HEADER_MAX_PADDING + NODE_MAX_PADDING))
-		return ; // Not enough space for a new block
+	std::size_t bin = get_small_bin(node->value);
+	if (bin >= SMALL_BIN_COUNT)
+	{
+		this->m_rb_tree.remove_node(node);
+		return;
+	}
 
-	// Figure out where to put the header in an aligned way
-	void*	aligned_header = deallocated_ptr;
-	align_to_natural(sizeof(Header), aligned_header, space_left);
+	if (node->get_parent() != NULL)
+		node->get_parent()->set_same(node->get_same());
+	else
+		this->m_small_bins[bin] = node->get_same();
+	if (node->get_same() != NULL)
+		node->get_same()->set_parent(node->get_parent());
+	if (this->m_small_bins[bin] == NULL)
+		this->m_small_bin_bitmap &= ~(uint64_t(1) << bin);
+}
 
-	// Same for the node
-	void*	aligned_node = static_cast<uint8_t*>(aligned_header) + sizeof(Header);
-	align_to_natural(sizeof(emma::RedBlackTree::Node), aligned_node, space_left);
+EMMA_INLINE emma::RedBlackTree::Node* emma::allocators::FreeList::search_free_node(std::size_t size)
+{/* Params    : (1) Usable size the free block needs
+ *  On success: Returns the node of the smallest free block that fits.
+ *              The first non empty bin that fits is found with one bit scan,
+ *              only if there is none the tree is searched.
+ *  On failure: Returns NULL
+ *  Fails if  : No free block is large enough */
 
-	// Move header to closest aligned position behind the node
-	// Space available - padding - sizeof header
-	aligned_header = get_header_placement_from_ptr(aligned_node);
-	std::size_t memory_left_minus_header = reinterpret_cast<std::size_t>(\
-	            original_space_left
-	            - (reinterpret_cast<uintptr_t>(aligned_header)
-	            - reinterpret_cast<uintptr_t>(deallocated_ptr))
-	            - sizeof(Header));
+	std::size_t bin = get_small_bin(size);
+	if (bin < SMALL_BIN_COUNT)
+	{
+		uint64_t large_enough = this->m_small_bin_bitmap >> bin;
+		if (large_enough != 0)
+			return this->m_small_bins[bin + static_cast<std::size_t>(__builtin_ctzll(large_enough))];
+	}
+	return this->m_rb_tree.search_best_fit(size);
+}
 
-	// Construct new node & store the size available (minus the header)
-	new(aligned_node) emma::RedBlackTree::Node(memory_left_minus_header);
-	this->m_rb_tree.insert_node(static_cast<emma::RedBlackTree::Node*>(aligned_node));
+EMMA_INLINE emma::RedBlackTree::Node* emma::allocators::FreeList::search_largest_free_node()
+{/* On success: Returns the node of the largest free block
+ *  On failure: Returns NULL
+ *  Fails if  : There are no free blocks */
 
-	// Construct new header & update the linked list
-	new(aligned_header) Header(next_header, prev_header);
-	if (prev_header != NULL)
-		prev_header->next = static_cast<Header*>(aligned_header);
-	if (next_header != NULL && next_header != this->m_end_of_memory)
-		next_header->prev = static_cast<Header*>(aligned_header);
-	static_cast<Header*>(aligned_header)->node = static_cast<emma::RedBlackTree::Node*>(aligned_node);
- }
+	emma::RedBlackTree::Node* node = this->m_rb_tree.search_largest();
+	if (node != NULL || this->m_small_bin_bitmap == 0)
+		return node;
+	return this->m_small_bins[63 - __builtin_clzll(this->m_small_bin_bitmap)];
+}
 
+EMMA_INLINE bool emma::allocators::FreeList::cache_freed_block(void* data)
+{/* Params    : (1) Data of a block that was just freed
+ *  On success: Keeps the block as it is, still used as far as the heap knows,
+ *              so that the next allocation of the same size can take it back.
+ *              Coalesces all of the blocks waiting first, if there are too many.
+ *              Returns true.
+ *  On failure: Returns false, the block has to be released normally
+ *  Fails if  : The block is too small or too large for the small bins */
+
+	std::size_t usable = usable_size(data);
+	std::size_t bin = get_small_bin(usable);
+	if (usable < MIN_BLOCK_SIZE - sizeof(Header) || bin >= SMALL_BIN_COUNT)
+		return false;
+
+	if (this->m_quick_list_count == QUICK_LIST_CAPACITY)
+		consolidate();
+	set_quick_list_link(data, this->m_quick_lists[bin]);
+	this->m_quick_lists[bin] = data;
+	this->m_quick_list_bitmap |= uint64_t(1) << bin;
+	++this->m_quick_list_count;
+	return true;
+}
 
-emma::allocators::FreeList::Header* \
-emma::allocators::FreeList::get_header_placement_from_ptr(void *ptr)
-{/* Params    : (1) Ptr to data/node that is located after the header
- *  On success: Returns location of header, based on the location of the ptr
+EMMA_INLINE void* emma::allocators::FreeList::take_cached_block(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns the data of the smallest recently freed block that fits,
+ *              as long as it's no larger than what an allocation would have
+ *              been left with anyway. Found with one bit scan.
  *  On failure: Returns NULL
- *  Fails if  : Input ptr is NULL */
+ *  Fails if  : No such block is waiting, or it's data isn't aligned */
 
-	if (ptr == NULL)
+	std::size_t min_data_size = MIN_BLOCK_SIZE - sizeof(Header);
+	std::size_t bin = get_small_bin(data_size < min_data_size ? min_data_size : data_size);
+	if (bin >= SMALL_BIN_COUNT)
 		return NULL;
 
-	// We get the earliest point where the header could be (right behind us).
-	// Then we just move backwards to the first point that works for alignment.
-	uint8_t*	earliest_unaligned_header = static_cast<uint8_t*>(ptr) - sizeof(Header);
-	std::size_t	align_offset = static_cast<std::size_t>(\
-				reinterpret_cast<uintptr_t>(earliest_unaligned_header) % sizeof(Header));
-	return (reinterpret_cast<Header*>(earliest_unaligned_header - align_offset));
+	// Anything larger would have had the rest split off into a block of it's own
+	uint64_t close_enough = (this->m_quick_list_bitmap >> bin)
+		& ((uint64_t(1) << (MIN_BLOCK_SIZE / sizeof(Header))) - 1);
+	if (close_enough == 0)
+		return NULL;
+
+	bin += static_cast<std::size_t>(__builtin_ctzll(close_enough));
+	void* data = this->m_quick_lists[bin];
+	if (reinterpret_cast<uintptr_t>(data) % alignment != 0)
+		return NULL;
+
+	this->m_quick_lists[bin] = get_quick_list_link(data);
+	if (this->m_quick_lists[bin] == NULL)
+		this->m_quick_list_bitmap &= ~(uint64_t(1) << bin);
+	--this->m_quick_list_count;
+	return data;
 }
 
+EMMA_INLINE emma::allocators::FreeList::Header* \
+emma::allocators::FreeList::take_free_block(emma::RedBlackTree::Node* free_node)
+{/* Params    : (1) Free node of the block we want
+ *  On success: Removes the node from the tree & marks the whole block as used.
+ *              Returns it's header.
+ *  Fails if  : Cannot fail, if the node is in the tree */
 
-void emma::allocators::FreeList::align_to_natural(std::size_t data_size, void *&ptr, std::size_t &space_left)
-{/* Params    : (1) Ptr to data/node that is located after the header
- *              (2) Ptr to to our memory
- *              (3) Space available in memory
- *  On success: Updates ptr to point to an aligned position, decrements data_size by the offset
- *  Fails if  : Cannot fail if unless space left is too small. There is no check for this!*/
+	Header* header = get_header_placement_from_ptr(free_node);
+	remove_free_node(free_node);
+	std::destroy_at(free_node);
 
-	// We move back to the first aligned position
-	uint8_t*	u_ptr = static_cast<uint8_t*>(ptr);
-	std::size_t	align_offset = static_cast<std::size_t>(reinterpret_cast<uintptr_t>(u_ptr) % data_size);
-	u_ptr -= align_offset;
+	// Free blocks never have a free block before them, they would have merged
+	new(header) Header(header->get_size(), 0);
+	if (header->get_next() != this->m_end_of_memory)
+		header->get_next()->set_prev_free(false);
+	return header;
+}
 
-	// Then we move forward by 1 unit of natural alignment. Simple!
-	u_ptr += data_size;
-	ptr = reinterpret_cast<void*>(u_ptr);
+EMMA_INLINE void* emma::allocators::FreeList::place_data(Header*& header, std::size_t alignment)
+{/* Params    : (1) Ptr to the header of a used block, large enough for the alignment.
+ *                  Updated if the block gets moved forward.
+ *              (2) Alignment of the data, must be a power of two
+ *  On success: Returns the first aligned position for data in the block.
+ *              A large gap in front of it becomes a free block, a small one
+ *              is written right before the data for get_header_placement_from_ptr()
+ *  Fails if  : Cannot fail */
+
+	uintptr_t	block_start = reinterpret_cast<uintptr_t>(header);
+	uintptr_t	data = align_position_up(block_start + sizeof(Header), alignment);
+	std::size_t	gap = static_cast<std::size_t>(data - block_start - sizeof(Header));
+
+	if (gap >= MIN_BLOCK_SIZE)
+	{
+		// The moved header has to exist first, the free block tells it that it's free
+		Header* moved = new(reinterpret_cast<void*>(block_start + gap)) Header(header->get_size() - gap, 0);
+		create_new_memory_block(header, gap);
+		header = moved;
+	}
+	else if (gap > 0)
+		*(reinterpret_cast<Header::Tag*>(data) - 1) = static_cast<Header::Tag>(gap);
+	return reinterpret_cast<void*>(data);
+}
+
+
+EMMA_INLINE emma::allocators::FreeList::Header* \
+emma::allocators::FreeList::get_header_placement_from_ptr(const void *ptr) const
+{/* Params    : (1) Ptr to data/node that is located after the header
+ *  On success: Returns location of header, based on the location of the ptr
+ *  On failure: Returns NULL
+ *  Fails if  : Input ptr is NULL */
+
+	if (ptr == NULL)
+		return NULL;
 
-	space_left -= (data_size - align_offset);
+	// The word right behind us is either our header, or the size of the gap
+	// between it & us. Blocks are never that small, so they can't be confused.
+	uint8_t*	earliest_header = static_cast<uint8_t*>(const_cast<void*>(ptr)) - sizeof(Header);
+	Header::Tag	tag = *reinterpret_cast<Header::Tag*>(earliest_header);
+	if ((tag & ~Header::FLAG_BITS) < MIN_BLOCK_SIZE)
+		return reinterpret_cast<Header*>(earliest_header - tag);
+	return reinterpret_cast<Header*>(earliest_header);
 }
@@ -0,0 +1,190 @@
+/* [ POOL ALLOCATOR CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * The memory is split into equally sized blocks, which are kept in a
+ * lock-free stack (a Treiber stack). Allocating pops a block from the stack,
+ * freeing pushes it back. Both are O(1), even in the worst case.
+ *
+ *  - Simplified example of memory layout -
+ * ┌───────────┬───────────┬───────────┬───────────┬───────────┐
+ * │ Next: 2   │ Allocated │ Next: 4   │ Allocated │ Next: -   │
+ * └───────────┴───────────┴───────────┴───────────┴───────────┘
+ *   Head: 0
+ *
+ * There are no headers. A free block stores the index of the next free block
+ * inside itself, an allocated block is entirely data. The index of a block is
+ * calculated from it's address when it is freed.
+ *
+ * Popping reads the next index of the head block, and swaps it in as the new
+ * head with a compare-exchange. In between, another thread could pop the same
+ * block, pop another, and push the first one back (ABA). Then the next index
+ * we read would be stale, but the head would look unchanged.
+ * To prevent this, the head also contains a version tag which is incremented
+ * on every change. An ABA would change the tag, and our exchange would fail.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <Pool.hpp>
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+static inline uint64_t make_head(uint64_t version_tag, uint32_t block_index)
+{
+	return ((version_tag << 32) | block_index);
+}
+
+static inline uint32_t get_head_index(uint64_t head)
+{
+	return static_cast<uint32_t>(head & 0xFFFFFFFF);
+}
+
+static inline uint64_t get_head_tag(uint64_t head)
+{
+	return (head >> 32);
+}
+
+static inline bool start_or_block_size_is_invalid(void* start, std::size_t block_size)
+{/* Returns true if one of the values is invalid and throws exception if enabled.
+    Returns false if both start and block size are valid */
+
+	if (start == NULL)
+		return emma::return_error<bool>(true, "Starting address can't be NULL");
+
+	if (block_size == 0)
+		return emma::return_error<bool>(true, "Block size can't be 0");
+
+	return false;
+}
+
+static inline std::size_t get_block_alignment(std::size_t block_size)
+{/* Small blocks are aligned to the power of two that fits them,
+    larger ones to the alignment of std::max_align_t */
+
+	std::size_t alignment = emma::allocators::Pool::MIN_BLOCK_SIZE;
+
+	while (alignment < block_size && alignment < alignof(std::max_align_t))
+		alignment <<= 1;
+	return alignment;
+}
+
+EMMA_INLINE emma::allocators::Pool::Pool(void* start, std::size_t size, std::size_t block_size) :
+emma::BaseAllocator(start, size), m_head(make_head(0, NO_BLOCK)), m_first_block(NULL),
+m_block_size(0), m_block_alignment(0), m_block_count(0)
+{/* Params    : (1) Ptr to the start of the memory available for the allocator
+ *              (2) Size of the memory available for the allocator
+ *              (3) Size of one block
+ *  On Success: Initializes the allocator, which will be ready for immediate use.
+ *  On failure: Throws an exception if they're enabled.
+ *              Otherwise does nothing & attempted allocations return NULL.
+ *  Fails if  : Start is NULL, block size is 0, or not even one block fits */
+
+	if (start_or_block_size_is_invalid(start, block_size))
+		return; // Also throws an exception if they're enabled
+
+	// Round the block size up, so that every block stays aligned
+	std::size_t alignment = get_block_alignment(block_size);
+	block_size = (block_size + alignment - 1) / alignment * alignment;
+
+	std::size_t padding = (alignment - reinterpret_cast<uintptr_t>(start) % alignment) % alignment;
+	if (size < padding + block_size)
+	{
+		emma::return_error<bool>(true, "Memsize can't fit a single block");
+		return; // Allocations will fail, the stack is empty
+	}
+
+	std::size_t block_count = (size - padding) / block_size;
+	if (block_count >= NO_BLOCK)
+		block_count = NO_BLOCK - 1;
+
+	this->m_first_block = static_cast<uint8_t*>(start) + padding;
+	this->m_block_size  = block_size;
+	this->m_block_alignment = alignment;
+	this->m_block_count = static_cast<uint32_t>(block_count);
+
+	// Link every block to the one after it
+	for (uint32_t i = 0; i < this->m_block_count; ++i)
+	{
+		uint32_t next = (i + 1 == this->m_block_count) ? NO_BLOCK : i + 1;
+		new(this->m_first_block + i * block_size) std::atomic<uint32_t>(next);
+	}
+	this->m_head.store(make_head(0, 0), std::memory_order_release);
+}
+
+EMMA_INLINE emma::allocators::Pool::~Pool() {}
+
+
+EMMA_INLINE void* emma::allocators::Pool::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns an aligned pointer to a free block
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : There are no free blocks left, or data_size == 0,
+ *	        or data_size/alignment is larger than the block size/alignment */
+
+	if (data_size == 0)
+		return emma::return_error<void*>(NULL, "Allocation size can't be 0!");
+	if (data_size > this->m_block_size)
+		return emma::return_error<void*>(NULL, "Allocation size is larger than the block size");
+	if (alignment_is_invalid(alignment) || alignment > this->m_block_alignment)
+		return emma::return_error<void*>(NULL, "Alignment is larger than the block alignment");
+
+	uint64_t head = this->m_head.load(std::memory_order_acquire);
+	while (true)
+	{
+		uint32_t index = get_head_index(head);
+		if (index == NO_BLOCK)
+			return emma::return_error<void*>(NULL, "No free blocks left");
+
+		// May be stale if another thread got here first. The tag catches it.
+		uint32_t next = get_next_index(index)->load(std::memory_order_relaxed);
+		uint64_t new_head = make_head(get_head_tag(head) + 1, next);
+
+		if (this->m_head.compare_exchange_weak(head, new_head,
+				std::memory_order_acquire, std::memory_order_acquire))
+			return static_cast<void*>(this->m_first_block + index * this->m_block_size);
+	}
+}
+
+EMMA_INLINE void emma::allocators::Pool::free_raw_ptr(void *data)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Deallocates the requested data
+ *  On failure: Does nothing
+ *  Fails if  : Data is NULL. Otherwise cannot fail (assuming ptr is valid) */
+
+	if (data == NULL)
+		return;
+
+	uint32_t index = static_cast<uint32_t>(\
+		(static_cast<uint8_t*>(data) - this->m_first_block) / this->m_block_size);
+	std::atomic<uint32_t>* next = new(data) std::atomic<uint32_t>(NO_BLOCK);
+
+	uint64_t head = this->m_head.load(std::memory_order_relaxed);
+	do
+	{
+		next->store(get_head_index(head), std::memory_order_relaxed);
+	}
+	while (!this->m_head.compare_exchange_weak(head, make_head(get_head_tag(head) + 1, index),
+			std::memory_order_release, std::memory_order_relaxed));
+}
+
+EMMA_INLINE std::size_t emma::allocators::Pool::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Returns the block size
+ *  Fails if  : Returns 0 if ptr is NULL */
+
+	return (ptr == NULL ? 0 : this->m_block_size);
+}
+
+
+EMMA_INLINE std::atomic<uint32_t>* emma::allocators::Pool::get_next_index(uint32_t block_index)
+{/* Params    : (1) Index of a free block
+ *  On success: Returns the next index stored inside of the block
+ *  Fails if  : Cannot fail if the index is valid */
+
+	return reinterpret_cast<std::atomic<uint32_t>*>(\
+		this->m_first_block + block_index * this->m_block_size);
+}
@@ -5,6 +5,11 @@
  * Only difference is that conventional RB-tree variable names like x/y/z
  * are not used due to making the operational logic hard to follow.
  *
+ * And that nodes with a value already in the tree are not added to it, they
+ * are chained behind the node with that value instead. The free list has
+ * thousands of blocks of the same size, this keeps the tree as high as the
+ * amount of distinct sizes, and makes inserting & removing them O(1).
+ *
  * The functions document the logic inside themselve, however,
  * an explanation of how red-black trees work as a whole is not provided here.
  * They are well documented online, you will find much better explanations there.
@@ -18,11 +23,11 @@
 #define RED emma::RedBlackTree::Node::RED
 #define BLACK emma::RedBlackTree::Node::BLACK
 
-emma::RedBlackTree::RedBlackTree() : m_root(NULL) {}
+EMMA_INLINE emma::RedBlackTree::RedBlackTree() : m_root(NULL) {}
 
-emma::RedBlackTree::~RedBlackTree() {}
+EMMA_INLINE emma::RedBlackTree::~RedBlackTree() {}
 
-void emma::RedBlackTree::insert_node(Node* new_node)
+EMMA_INLINE void emma::RedBlackTree::insert_node(Node* new_node)
 {/* Params    : Ptr to the node to add to the tree
  *  On success: Adds the node to the tree
  *  On failure: Does nothing
@@ -31,9 +36,11 @@ void emma::RedBlackTree::insert_node(Node* new_node)
 	if (new_node == NULL)
 		return;
 
-	new_node->left   = NULL; 
-	new_node->right  = NULL;
-	new_node->color  = RED;
+	new_node->set_left(NULL);
+	new_node->set_right(NULL);
+	new_node->set_color(RED);
+	new_node->set_same(NULL);
+	new_node->set_chained(false);
 
 	// 1. Traverse nodes down from root until we reach the bottom
 	Node* parent_node  = NULL;
@@ -41,27 +48,38 @@ void emma::RedBlackTree::insert_node(Node* new_node)
 	while (current_node != NULL)
 	{
 		parent_node = current_node;
+		if (new_node->value == current_node->value)
+		{
+			// The value is already in the tree, chain right behind it's node
+			new_node->set_chained(true);
+			new_node->set_parent(current_node);
+			new_node->set_same(current_node->get_same());
+			if (current_node->get_same() != NULL)
+				current_node->get_same()->set_parent(new_node);
+			current_node->set_same(new_node);
+			return;
+		}
 		if (new_node->value < current_node->value)
-			current_node = current_node->left;
+			current_node = current_node->get_left();
 		else
-			current_node = current_node->right;
+			current_node = current_node->get_right();
 	}
 
 	// 2. Update new node as child of the last node we traversed.
-	new_node->parent = parent_node;
+	new_node->set_parent(parent_node);
 	if (parent_node == NULL)
 		this->m_root = new_node;
 	else if (new_node->value < parent_node->value)
-		parent_node->left = new_node;
+		parent_node->set_left(new_node);
 	else
-		parent_node->right = new_node;
+		parent_node->set_right(new_node);
 
 	// 3. We may have violated the structure of the tree. Fix it!
 	fix_insert_node_violations(new_node);
 }
 
 
-void emma::RedBlackTree::remove_node(Node* target_node)
+EMMA_INLINE void emma::RedBlackTree::remove_node(Node* target_node)
 {/* Params    : Ptr to the node to remove from the tree
  *  On success: Removes the node from the tree. Does not deconstruct it!
  *  On failure: Does nothing
@@ -70,54 +88,70 @@ void emma::RedBlackTree::remove_node(Node* target_node)
 	if (target_node == NULL)
 		return;
 
-	enum Node::Color	original_color = target_node->color;
+	// Chained nodes aren't in the tree, they only have to be unlinked
+	if (target_node->is_chained())
+	{
+		target_node->get_parent()->set_same(target_node->get_same());
+		if (target_node->get_same() != NULL)
+			target_node->get_same()->set_parent(target_node->get_parent());
+		return;
+	}
+	if (target_node->get_same() != NULL)
+	{
+		replace_with_chained_node(target_node);
+		return;
+	}
+
+	enum Node::Color	original_color = target_node->get_color();
 	Node*	temp_node = target_node;
 	Node*	replacing_node = NULL;
+	Node*	replacing_parent = NULL; // Tracked on it's own, replacing node may be NULL
 
 	// We want to replace the original node with the child node.
 	// If we have 0 or 1 children, this is easy - let's check for that.
-	if (target_node->left == NULL)
+	if (target_node->get_left() == NULL)
 	{
-		replacing_node = target_node->right;
-		transplant_node(target_node, target_node->right);
+		replacing_node = target_node->get_right();
+		replacing_parent = target_node->get_parent();
+		transplant_node(target_node, target_node->get_right());
 	}
-	else if (target_node->right == NULL)
+	else if (target_node->get_right() == NULL)
 	{
-		replacing_node = target_node->left;
-		transplant_node(target_node, target_node->left);
+		replacing_node = target_node->get_left();
+		replacing_parent = target_node->get_parent();
+		transplant_node(target_node, target_node->get_left());
 	}
 	else // Bummer, it has both children...
 	{
 		// Get the smallest value node from our right child's subtree
-		temp_node = get_smallest_in_subtree(target_node->right);
-		original_color = temp_node->color;
-
-		// If the smallest node's parent is the target, set the replacing node's
-		// parent as the smallest node.
-		replacing_node = temp_node->right;
-		if (temp_node->parent == target_node)
-			replacing_node->parent = temp_node;
+		temp_node = get_smallest_in_subtree(target_node->get_right());
+		original_color = temp_node->get_color();
+
+		// If the smallest node's parent is the target, the smallest node
+		// becomes the parent of the replacing node.
+		replacing_node = temp_node->get_right();
+		if (temp_node->get_parent() == target_node)
+			replacing_parent = temp_node;
 		else
 		{
-			transplant_node(temp_node, temp_node->right);
-			temp_node->right = target_node->right;
-			if (temp_node->right != NULL)
-				temp_node->right->parent = temp_node;
+			replacing_parent = temp_node->get_parent();
+			transplant_node(temp_node, temp_node->get_right());
+			temp_node->set_right(target_node->get_right());
+			temp_node->get_right()->set_parent(temp_node);
 		}
 		transplant_node(target_node, temp_node);
-		temp_node->left = target_node->left;
-		if (temp_node->left != NULL)
-			temp_node->left->parent = temp_node;
-		temp_node->color = target_node->color;
+		temp_node->set_left(target_node->get_left());
+		temp_node->get_left()->set_parent(temp_node);
+		temp_node->set_color(target_node->get_color());
 	}
 
 	// Violations may have occured if the original node was black. Fix it!
 	if (original_color == BLACK)
-		fix_remove_node_violations(replacing_node);
+		fix_remove_node_violations(replacing_node, replacing_parent);
 }
 
 
-emma::RedBlackTree::Node* emma::RedBlackTree::search_best_fit(std::size_t target_size)
+EMMA_INLINE emma::RedBlackTree::Node* emma::RedBlackTree::search_best_fit(std::size_t target_size)
 {/* Params    : Size to find the closest matching node of
  *  On success: Finds a node with the closest matching size from the whole tree
  *  On failure: Returns NULL
@@ -133,19 +167,80 @@ emma::RedBlackTree::Node* emma::RedBlackTree::search_best_fit(std::size_t target
 		if (target_size == current_node->value)
 			break;
 		else if (target_size < current_node->value)
-			current_node = current_node->left;
+			current_node = current_node->get_left();
 		else
-			current_node = current_node->right;
+			current_node = current_node->get_right();
 	}
 
 	// Traverse back upwards until we hit a value >= target
 	while (parent_node != NULL && target_size > parent_node->value)
-		parent_node = parent_node->parent;
+		parent_node = parent_node->get_parent();
+
+	// A chained node of the same value is quicker to remove later
+	if (parent_node != NULL && parent_node->get_same() != NULL)
+		return parent_node->get_same();
 	return (parent_node);
 }
 
+EMMA_INLINE emma::RedBlackTree::Node* emma::RedBlackTree::search_largest()
+{/* On success: Returns the node with the largest value in the whole tree
+ *  On failure: Returns NULL
+ *  Fails if  : Tree is empty */
+
+	Node*	current_node = m_root;
+
+	if (current_node == NULL)
+		return NULL;
+
+	while (current_node->get_right() != NULL)
+		current_node = current_node->get_right();
+
+	if (current_node->get_same() != NULL)
+		return current_node->get_same();
+	return current_node;
+}
+
+EMMA_INLINE void emma::RedBlackTree::measure(std::size_t& node_count, std::size_t& value_sum,
+std::size_t& largest_value, std::size_t& height) const
+{/* Params    : (1) Set to the amount of nodes
+ *              (2) Set to the sum of their values
+ *              (3) Set to the largest value, 0 if the tree is empty
+ *              (4) Set to the amount of nodes on the longest path from the root
+ *  On success: Visits every node once, chained ones included. O(n)
+ *              The height only counts the nodes in the tree.
+ *  Fails if  : Cannot fail */
+
+	node_count = 0;
+	value_sum = 0;
+	largest_value = 0;
+	height = 0;
+	measure_subtree(m_root, 1, node_count, value_sum, height);
+
+	for (const Node* current_node = m_root; current_node != NULL; current_node = current_node->get_right())
+		largest_value = current_node->value;
+}
 
-emma::RedBlackTree::Node* emma::RedBlackTree::get_smallest_in_subtree(Node* target)
+EMMA_INLINE void emma::RedBlackTree::measure_subtree(const Node* target, std::size_t depth,
+std::size_t& node_count, std::size_t& value_sum, std::size_t& height)
+{/* Recursive helper for measure(). The tree is balanced, so the
+    recursion is never deeper than about 2 * log2(n). */
+
+	if (target == NULL)
+		return;
+
+	for (const Node* same_node = target; same_node != NULL; same_node = same_node->get_same())
+	{
+		++node_count;
+		value_sum += same_node->value;
+	}
+	if (depth > height)
+		height = depth;
+	measure_subtree(target->get_left(), depth + 1, node_count, value_sum, height);
+	measure_subtree(target->get_right(), depth + 1, node_count, value_sum, height);
+}
+
+
+EMMA_INLINE emma::RedBlackTree::Node* emma::RedBlackTree::get_smallest_in_subtree(Node* target)
 {/* Params    : Ptr to the node we want to search the subtree of
  *  On success: Returns the node with the smallest value in the subtree
  *  On failure: Returns NULL
@@ -154,13 +249,38 @@ emma::RedBlackTree::Node* emma::RedBlackTree::get_smallest_in_subtree(Node* targ
 	if (target == NULL)
 		return NULL; 
 
-	while (target->left != NULL)
-		target = target->left;
+	while (target->get_left() != NULL)
+		target = target->get_left();
 
 	return target;
 }
 
-void emma::RedBlackTree::fix_insert_node_violations(Node* current_node)
+EMMA_INLINE void emma::RedBlackTree::replace_with_chained_node(Node* target_node)
+{/* Params    : Ptr to a node in the tree, with nodes chained behind it
+ *  On success: Puts the first chained node in the target's place in the tree,
+ *              with the same color, so that the tree needs no fixing. O(1)
+ *  On failure: Does nothing
+ *  Fails if  : Target node is NULL or has no chained nodes */
+
+	if (target_node == NULL || target_node->get_same() == NULL)
+		return;
+
+	// The rest of the chain stays behind the replacing node
+	Node* replacing_node = target_node->get_same();
+	replacing_node->set_chained(false);
+	replacing_node->set_color(target_node->get_color());
+
+	replacing_node->set_left(target_node->get_left());
+	if (replacing_node->get_left() != NULL)
+		replacing_node->get_left()->set_parent(replacing_node);
+	replacing_node->set_right(target_node->get_right());
+	if (replacing_node->get_right() != NULL)
+		replacing_node->get_right()->set_parent(replacing_node);
+	transplant_node(target_node, replacing_node);
+}
+
+
+EMMA_INLINE void emma::RedBlackTree::fix_insert_node_violations(Node* current_node)
 {/* Params    : Ptr to a node we just inserted.
  *  On success: Checks if the insertion violated rules, and fixes them.
  *  On failure: Does nothing.
@@ -173,158 +293,161 @@ void emma::RedBlackTree::fix_insert_node_violations(Node* current_node)
 	Node* grandparent_node	= NULL;
 
 	// Keeps traversing upwards until there are no more violations to fix
-	while (current_node != this->m_root && current_node->color == RED 
-			&& current_node->parent->color == RED)
+	while (current_node != this->m_root && current_node->get_color() == RED 
+			&& current_node->get_parent()->get_color() == RED)
 	{
-		parent_node = current_node->parent;
-		grandparent_node = parent_node->parent;
+		parent_node = current_node->get_parent();
+		grandparent_node = parent_node->get_parent();
 
-		if (parent_node == grandparent_node->left)
+		if (parent_node == grandparent_node->get_left())
 		{
-			Node* uncle_node = grandparent_node->right;
-			if (uncle_node != NULL && uncle_node->color == RED)
+			Node* uncle_node = grandparent_node->get_right();
+			if (uncle_node != NULL && uncle_node->get_color() == RED)
 			{
-				grandparent_node->color = RED;
-				parent_node->color = BLACK;
-				uncle_node->color = BLACK;
+				grandparent_node->set_color(RED);
+				parent_node->set_color(BLACK);
+				uncle_node->set_color(BLACK);
 				current_node = grandparent_node;
 			}
 			else
 			{
-				if (current_node == parent_node->right)
+				if (current_node == parent_node->get_right())
 				{
 					rotate_node_left(parent_node);
 					current_node = parent_node;
-					parent_node = current_node->parent;
+					parent_node = current_node->get_parent();
 				}
 				rotate_node_right(grandparent_node);
-				std::swap(parent_node->color, grandparent_node->color);
+				enum Node::Color parent_color = parent_node->get_color();
+				parent_node->set_color(grandparent_node->get_color());
+				grandparent_node->set_color(parent_color);
 				current_node = parent_node; //Move up in the tree
 			}
 		}
 		else
 		{
-			Node* uncle_node = grandparent_node->left;
-			if (uncle_node != NULL && uncle_node->color == RED)
+			Node* uncle_node = grandparent_node->get_left();
+			if (uncle_node != NULL && uncle_node->get_color() == RED)
 			{
-				grandparent_node->color = RED;
-				parent_node->color = BLACK;
-				uncle_node->color = BLACK;
+				grandparent_node->set_color(RED);
+				parent_node->set_color(BLACK);
+				uncle_node->set_color(BLACK);
 				current_node = grandparent_node;
 			}
 			else
 			{
-				if (current_node == parent_node->left)
+				if (current_node == parent_node->get_left())
 				{
 					rotate_node_right(parent_node);
 					current_node = parent_node;
-					parent_node = current_node->parent;
+					parent_node = current_node->get_parent();
 				}
 				rotate_node_left(grandparent_node);
-				std::swap(parent_node->color, grandparent_node->color);
+				enum Node::Color parent_color = parent_node->get_color();
+				parent_node->set_color(grandparent_node->get_color());
+				grandparent_node->set_color(parent_color);
 				current_node = parent_node;
 			}
 		}
 	}
-	this->m_root->color = BLACK;
+	this->m_root->set_color(BLACK);
 }
 
 
-void emma::RedBlackTree::fix_remove_node_violations(Node* current_node)
-{/* Params    : Ptr to the node that replaced the one which was removed
+EMMA_INLINE void emma::RedBlackTree::fix_remove_node_violations(Node* current_node, Node* parent_node)
+{/* Params    : (1) Ptr to the node that replaced the one which was removed
+ *              (2) Ptr to the parent of said node
  *  On success: Fixes rule violations the remove operation may have caused
  *  On failure: Does nothing
- *  Fails if  : Target node is NULL */
-
-	if (current_node == NULL)
-		return;
+ *  Notes     : The replacing node may be NULL (an empty leaf), which is why
+ *              the parent is passed and tracked separately. */
 
 	// Traverse the tree upwards starting from the node.
 	// There are no more violations if the current node is red or root
-	while (current_node != this->m_root && current_node->color == BLACK)
+	while (current_node != this->m_root
+			&& (current_node == NULL || current_node->get_color() == BLACK))
 	{
-		if (current_node == current_node->parent->left) // We are left child
+		if (current_node == parent_node->get_left()) // We are left child
 		{
-			Node* sibling_node = current_node->parent->right;
+			Node* sibling_node = parent_node->get_right();
 
 			// Fixes red siblings
-			if (sibling_node->color == RED)
+			if (sibling_node->get_color() == RED)
 			{
-				sibling_node->color = BLACK;
-				current_node->parent->color = RED;
-				rotate_node_left(current_node->parent);
-				sibling_node = current_node->parent->right;
+				sibling_node->set_color(BLACK);
+				parent_node->set_color(RED);
+				rotate_node_left(parent_node);
+				sibling_node = parent_node->get_right();
 			}
 			// Fixes siblings with 2 black children
-			if ((sibling_node->left == NULL || sibling_node->left->color == BLACK) 
-					&& (sibling_node->right == NULL || sibling_node->right->color == BLACK))
+			if ((sibling_node->get_left() == NULL || sibling_node->get_left()->get_color() == BLACK) 
+					&& (sibling_node->get_right() == NULL || sibling_node->get_right()->get_color() == BLACK))
 			{
-				sibling_node->color = RED;
-				current_node = current_node->parent; // Move up in the tree
+				sibling_node->set_color(RED);
+				current_node = parent_node; // Move up in the tree
+				parent_node = current_node->get_parent();
 			}
 			else // The sibling must have 1 or 2 red children
 			{
 				// Fixes sibling with a left red child & black right child
-				if (sibling_node->right == NULL || sibling_node->right->color == BLACK)
+				if (sibling_node->get_right() == NULL || sibling_node->get_right()->get_color() == BLACK)
 				{
-					if (sibling_node->left != NULL)
-						sibling_node->left->color = BLACK;
-					sibling_node->color = RED;
+					sibling_node->get_left()->set_color(BLACK);
+					sibling_node->set_color(RED);
 					rotate_node_right(sibling_node);
-					sibling_node = current_node->parent->right;
+					sibling_node = parent_node->get_right();
 				}
-				sibling_node->color = current_node->parent->color;
-				sibling_node->parent->color = BLACK;
-				if (sibling_node->right != NULL)
-					sibling_node->right->color = BLACK;
-				rotate_node_right(current_node->parent);
+				sibling_node->set_color(parent_node->get_color());
+				parent_node->set_color(BLACK);
+				sibling_node->get_right()->set_color(BLACK);
+				rotate_node_left(parent_node);
 				current_node = this->m_root;
 			}
 		}
 		else // We are right child
 		{
-			Node* sibling_node = current_node->parent->left;
+			Node* sibling_node = parent_node->get_left();
 
 			// Fixes red siblings
-			if (sibling_node->color == RED)
+			if (sibling_node->get_color() == RED)
 			{
-				sibling_node->color = BLACK;
-				current_node->parent->color = RED;
-				rotate_node_right(current_node->parent);
-				sibling_node = current_node->parent->left;
+				sibling_node->set_color(BLACK);
+				parent_node->set_color(RED);
+				rotate_node_right(parent_node);
+				sibling_node = parent_node->get_left();
 			}
 			// Fixes siblings with 2 black children
-			if ((sibling_node->left == NULL || sibling_node->left->color == BLACK)
-					&& (sibling_node->right == NULL || sibling_node->right->color == BLACK))
+			if ((sibling_node->get_left() == NULL || sibling_node->get_left()->get_color() == BLACK)
+					&& (sibling_node->get_right() == NULL || sibling_node->get_right()->get_color() == BLACK))
 			{
-				sibling_node->color = RED;
-				current_node = current_node->parent;
+				sibling_node->set_color(RED);
+				current_node = parent_node;
+				parent_node = current_node->get_parent();
 			}
 			else
 			{
 				// Fixes sibling with a left black child & red right child
-				if (sibling_node->left == NULL || sibling_node->left->color == BLACK)
+				if (sibling_node->get_left() == NULL || sibling_node->get_left()->get_color() == BLACK)
 				{
-					if (sibling_node->right != NULL)
-						sibling_node->right->color = BLACK;
-					sibling_node->color = RED;
+					sibling_node->get_right()->set_color(BLACK);
+					sibling_node->set_color(RED);
 					rotate_node_left(sibling_node);
-					sibling_node = current_node->parent->left;
+					sibling_node = parent_node->get_left();
 				}
-				sibling_node->color = current_node->parent->color;
-				current_node->parent->color = BLACK;
-				if (sibling_node->left != NULL)
-					sibling_node->left->color = BLACK;
-				rotate_node_right(current_node->parent);
+				sibling_node->set_color(parent_node->get_color());
+				parent_node->set_color(BLACK);
+				sibling_node->get_left()->set_color(BLACK);
+				rotate_node_right(parent_node);
 				current_node = this->m_root;
 			}
 		}
 	}
-	current_node->color = BLACK;
+	if (current_node != NULL)
+		current_node->set_color(BLACK);
 }
 
 
-void emma::RedBlackTree::transplant_node(Node* dest_node, Node* src_node)
+EMMA_INLINE void emma::RedBlackTree::transplant_node(Node* dest_node, Node* src_node)
 {/* Params    : Destination node & Source node
  *  On success: Replaces destination node with the source node
  *  On failure: Does nothing
@@ -333,19 +456,19 @@ void emma::RedBlackTree::transplant_node(Node* dest_node, Node* src_node)
 	if (dest_node == NULL)
 		return;
 
-	if (dest_node->parent == NULL) // We are root
+	if (dest_node->get_parent() == NULL) // We are root
 		this->m_root = src_node;
-	else if (dest_node == dest_node->parent->left) // We are left child
-		dest_node->parent->left = src_node;
+	else if (dest_node == dest_node->get_parent()->get_left()) // We are left child
+		dest_node->get_parent()->set_left(src_node);
 	else // We are right child
-		dest_node->parent->right = src_node;
+		dest_node->get_parent()->set_right(src_node);
 
 	if (src_node != NULL)
-		src_node->parent = dest_node->parent;
+		src_node->set_parent(dest_node->get_parent());
 }
 
 
-void emma::RedBlackTree::rotate_node_left(Node* target_node)
+EMMA_INLINE void emma::RedBlackTree::rotate_node_left(Node* target_node)
 {/* Params    : Ptr to the node to rotate
  *  On success: Rotates the node of the tree to the left, returns nothing.
  *  On failure: Does nothing
@@ -354,31 +477,31 @@ void emma::RedBlackTree::rotate_node_left(Node* target_node)
 	if (target_node == NULL)
 		return;
 
-	Node*	right_child = target_node->right;
+	Node*	right_child = target_node->get_right();
 	
 	// 1. Set target_node's right child ptr as the current right child's left 
-	target_node->right = right_child->left;
-	if (target_node->right != NULL) 
-		target_node->right->parent = target_node;
+	target_node->set_right(right_child->get_left());
+	if (target_node->get_right() != NULL) 
+		target_node->get_right()->set_parent(target_node);
 
 	// 2. Set parent of the old right child to the parent of the target_node
-	right_child->parent = target_node->parent;
+	right_child->set_parent(target_node->get_parent());
 
 	// 3. Update the parent of the target_node node
-	if (target_node->parent == NULL)
+	if (target_node->get_parent() == NULL)
 		this->m_root = right_child;
-	else if (target_node->parent->left == target_node)
-		target_node->parent->left = right_child;
+	else if (target_node->get_parent()->get_left() == target_node)
+		target_node->get_parent()->set_left(right_child);
 	else
-		target_node->parent->right = right_child;
+		target_node->get_parent()->set_right(right_child);
 
 	// 4. Set target_node to be a child of the old right child.
-	right_child->left = target_node;
-	target_node->parent = right_child;
+	right_child->set_left(target_node);
+	target_node->set_parent(right_child);
 }
 
 
-void emma::RedBlackTree::rotate_node_right(Node* target_node)
+EMMA_INLINE void emma::RedBlackTree::rotate_node_right(Node* target_node)
 {/* Params    : Ptr to the node to rotate
  *  On success: Rotates the node of the tree to the right, returns nothing.
  *  On failure: Does nothing
@@ -387,27 +510,27 @@ void emma::RedBlackTree::rotate_node_right(Node* target_node)
 	if (target_node == NULL)
 		return;
 
-	Node*	left_child = target_node->left;
+	Node*	left_child = target_node->get_left();
 	
 	// 1. Set target_node's left child ptr as the current left child's right
-	target_node->left = left_child->right;
-	if (target_node->left != NULL) 
-		target_node->left->parent = target_node;
+	target_node->set_left(left_child->get_right());
+	if (target_node->get_left() != NULL) 
+		target_node->get_left()->set_parent(target_node);
 
 	// 2. Set parent of the old left child to the parent of the target_node
-	left_child->parent = target_node->parent;
+	left_child->set_parent(target_node->get_parent());
 
 	// 3. Update the parent of the target_node node
-	if (target_node->parent == NULL)
+	if (target_node->get_parent() == NULL)
 		this->m_root = left_child;
-	else if (target_node->parent->left == target_node)
-		target_node->parent->left = left_child;
+	else if (target_node->get_parent()->get_left() == target_node)
+		target_node->get_parent()->set_left(left_child);
 	else
-		target_node->parent->right = left_child;
+		target_node->get_parent()->set_right(left_child);
 
 	// 4. Set target_node to be a child of the old left child.
-	left_child->right = target_node;
-	target_node->parent = left_child;
+	left_child->set_right(target_node);
+	target_node->set_parent(left_child);
 }
 
 #undef BLACK
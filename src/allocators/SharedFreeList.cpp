@@ -0,0 +1,98 @@
+/* [ SHARED FREE LIST ALLOCATOR CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * Just a FreeList with a mutex around every call, nothing fancy.
+ * Every thread may use it directly, but it is much faster to give each thread
+ * a ThreadCache of it's own. The caches only come here in batches.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <SharedFreeList.hpp>
+#include <mutex>
+
+EMMA_INLINE emma::allocators::SharedFreeList::SharedFreeList(void* start, std::size_t size) :
+emma::BaseAllocator(start, size), m_free_list(start, size)
+{/* Params    : (1) Ptr to the start of the memory available for the allocator
+ *              (2) Size of the memory available for the allocator
+ *  On Success: Initializes the allocator, which will be ready for immediate use.
+ *  On failure: Same as FreeList */
+}
+
+EMMA_INLINE emma::allocators::SharedFreeList::~SharedFreeList() {}
+
+
+EMMA_INLINE void* emma::allocators::SharedFreeList::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns an aligned pointer to the newly allocated data
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : Same as FreeList */
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	return this->m_free_list.allocate_raw_ptr(data_size, alignment);
+}
+
+EMMA_INLINE void emma::allocators::SharedFreeList::free_raw_ptr(void *data)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Deallocates the requested data
+ *  On failure: Does nothing
+ *  Fails if  : Data is NULL. Otherwise cannot fail (assuming ptr is valid) */
+
+	if (data == NULL)
+		return;
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	this->m_free_list.free_raw_ptr(data);
+}
+
+EMMA_INLINE void* emma::allocators::SharedFreeList::reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment)
+{/* Params    : (1) Data which has been previously allocated, or NULL
+ *              (2) New size of the data
+ *              (3) Alignment of the data, must be a power of two
+ *  On success: Same as FreeList, while holding the lock once
+ *  On failure: Same as FreeList */
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	return this->m_free_list.reallocate_raw_ptr(ptr, new_size, alignment);
+}
+
+EMMA_INLINE std::size_t emma::allocators::SharedFreeList::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Same as FreeList */
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	return this->m_free_list.usable_size(ptr);
+}
+
+EMMA_INLINE emma::Stats emma::allocators::SharedFreeList::get_stats() const
+{/* On success: Same as FreeList, while holding the lock */
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	return this->m_free_list.get_stats();
+}
+
+
+EMMA_INLINE std::size_t emma::allocators::SharedFreeList::allocate_bulk(\
+std::size_t data_size, std::size_t count, void** out_ptrs, std::size_t alignment)
+{/* Params    : (1) Size of each allocation
+ *              (2) Amount of allocations to make
+ *              (3) Array with space for 'count' pointers, filled with the results
+ *              (4) Alignment of the allocations, must be a power of two
+ *  On success: Same as FreeList, while holding the lock only once
+ *  On failure: Same as FreeList */
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	return this->m_free_list.allocate_bulk(data_size, count, out_ptrs, alignment);
+}
+
+EMMA_INLINE void emma::allocators::SharedFreeList::free_bulk(void** ptrs, std::size_t count)
+{/* Params    : (1) Array of previously allocated pointers. Gets sorted.
+ *              (2) Amount of pointers in the array
+ *  On success: Same as FreeList, while holding the lock only once
+ *  Fails if  : Cannot fail (assuming the pointers are valid) */
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	this->m_free_list.free_bulk(ptrs, count);
+}
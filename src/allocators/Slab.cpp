@@ -0,0 +1,205 @@
+/* [ SLAB ALLOCATOR CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * A segregated size class front-end, in front of a free list.
+ * Small allocations take O(1), large allocations are as fast as the free list.
+ *
+ *  - Simplified example of memory layout -
+ * ┌─────────┬────────────────────┐┌─────────┬──────────────────────────────────┐
+ * │Size|F|PF│ Slab (class 16)    ││Size|F|PF│ Large allocation / free memory   │
+ * └─────────┴────────────────────┘└─────────┴──────────────────────────────────┘
+ *            └ 16 │ 16 │ 16 │ ...
+ *
+ * Each block of the free list starts with one boundary tag: it's size, with
+ * FREE_BIT (F) & PREV_FREE_BIT (PF) in the lowest bits.
+ *
+ * The whole memory is managed by a free list. Small allocations are rounded up
+ * to the nearest size class, which are powers of two up to MAX_CLASS_SIZE.
+ *
+ * Each size class carves fixed size slabs out of the free list. The objects of
+ * a slab are linked into an intrusive list of free objects for that class.
+ * Allocating & freeing a small object is just a pop/push from said list.
+ * The free list is only touched when a class runs out of objects.
+ *
+ * Slabs are SLAB_SIZE long and aligned to SLAB_SIZE, meaning every slab fills
+ * exactly one page of the memory. A small map (one byte per page) tells us if
+ * a pointer belongs to a slab, and which class it is. So no per-object header.
+ *
+ * Slabs are never given back to the free list. Memory which a size class has
+ * used once will stay reserved for that size class.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <Slab.hpp>
+#include <stdint.h>
+#include <memory>
+#include <new>
+
+EMMA_INLINE emma::allocators::Slab::Slab(void* start, std::size_t size) :
+emma::BaseAllocator(start, size), m_backend(start, size), m_slab_map(NULL),
+m_first_page(0), m_page_count(0)
+{/* Params    : (1) Ptr to the start of the memory available for the allocator
+ *              (2) Size of the memory available for the allocator
+ *  On Success: Initializes the allocator, which will be ready for immediate use.
+ *  On failure: Throws an exception if they're enabled.
+ *              Otherwise does nothing & attempted allocations return NULL.
+ *  Fails if  : The free list fails, or the slab map doesn't fit in memory.
+ *              If only the slab map doesn't fit, it acts just like a free list */
+
+	for (std::size_t i = 0; i < CLASS_COUNT; ++i)
+		this->m_free_objects[i] = NULL;
+
+	if (start == NULL)
+		return; // The free list already reported the error
+
+	// Pages are counted from an absolute SLAB_SIZE boundary
+	uintptr_t last_page = (reinterpret_cast<uintptr_t>(start) + size - 1) >> SLAB_SHIFT;
+	this->m_first_page  = reinterpret_cast<uintptr_t>(start) >> SLAB_SHIFT;
+	this->m_page_count  = static_cast<std::size_t>(last_page - this->m_first_page + 1);
+
+	this->m_slab_map = static_cast<uint8_t*>(m_backend.allocate_raw_ptr(this->m_page_count));
+	if (this->m_slab_map == NULL)
+		return; // Also throws an exception if they're enabled
+
+	for (std::size_t i = 0; i < this->m_page_count; ++i)
+		this->m_slab_map[i] = 0;
+}
+
+EMMA_INLINE emma::allocators::Slab::~Slab() {}
+
+
+EMMA_INLINE void* emma::allocators::Slab::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns an aligned pointer to the newly allocated data
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory, data_size == 0,
+ *	        alignment is not a power of two or data_size would overflow with padding*/
+
+	if (data_size > MAX_CLASS_SIZE || alignment > MAX_CLASS_SIZE || data_size == 0
+		|| alignment_is_invalid(alignment) || this->m_slab_map == NULL)
+		return this->m_backend.allocate_raw_ptr(data_size, alignment);
+
+	// Objects are aligned to their class size, any class as large as the alignment works
+	std::size_t class_index = get_class_index(data_size < alignment ? alignment : data_size);
+
+	// Get a new slab only if we have run out of objects of this class
+	if (this->m_free_objects[class_index] == NULL && !refill_class(class_index))
+		return emma::return_error<void*>(NULL, "No memory left for a new slab");
+
+	FreeObject* object = this->m_free_objects[class_index];
+	this->m_free_objects[class_index] = object->next;
+	std::destroy_at(object);
+
+	return static_cast<void*>(object);
+}
+
+EMMA_INLINE void emma::allocators::Slab::free_raw_ptr(void *data)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Deallocates the requested data
+ *  On failure: Does nothing
+ *  Fails if  : Data is NULL. Otherwise cannot fail (assuming ptr is valid) */
+
+	if (data == NULL)
+		return;
+
+	// Not inside a slab, the free list owns it
+	std::size_t slab_class = get_slab_class(data);
+	if (slab_class == 0)
+	{
+		this->m_backend.free_raw_ptr(data);
+		return;
+	}
+
+	std::size_t class_index = slab_class - 1;
+	this->m_free_objects[class_index] = new(data) FreeObject(this->m_free_objects[class_index]);
+}
+
+EMMA_INLINE void* emma::allocators::Slab::reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment)
+{/* Params    : (1) Data which has been previously allocated, or NULL
+ *              (2) New size of the data
+ *              (3) Alignment of the data, must be a power of two
+ *  On success: Returns a pointer to the resized data.
+ *              Objects of a slab stay in place while they fit their class,
+ *              anything else is resized in place by the free list if possible.
+ *  On failure: Returns NULL, ptr is left as is. Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory */
+
+	if (ptr != NULL && new_size != 0 && get_slab_class(ptr) == 0)
+		return this->m_backend.reallocate_raw_ptr(ptr, new_size, alignment);
+
+	return emma::BaseAllocator::reallocate_raw_ptr(ptr, new_size, alignment);
+}
+
+EMMA_INLINE std::size_t emma::allocators::Slab::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Returns the size of the object's class, or the free list's
+ *              usable size if it isn't in a slab
+ *  Fails if  : Returns 0 if ptr is NULL */
+
+	if (ptr == NULL)
+		return 0;
+
+	std::size_t slab_class = get_slab_class(ptr);
+	if (slab_class == 0)
+		return this->m_backend.usable_size(ptr);
+	return (MIN_CLASS_SIZE << (slab_class - 1));
+}
+
+
+EMMA_INLINE std::size_t emma::allocators::Slab::get_class_index(std::size_t data_size)
+{/* Params    : (1) Size of the allocation, at most MAX_CLASS_SIZE
+ *  On success: Returns the index of the smallest size class that fits the size
+ *  Fails if  : Cannot fail */
+
+	std::size_t class_index = 0;
+	std::size_t class_size = MIN_CLASS_SIZE;
+
+	while (class_size < data_size)
+	{
+		class_size <<= 1;
+		++class_index;
+	}
+	return class_index;
+}
+
+EMMA_INLINE std::size_t emma::allocators::Slab::get_slab_class(void* ptr)
+{/* Params    : (1) Ptr anywhere inside of our memory
+ *  On success: Returns the class index + 1 of the slab the ptr is in
+ *  On failure: Returns 0
+ *  Fails if  : The ptr is not inside of a slab */
+
+	std::size_t page = static_cast<std::size_t>(\
+		(reinterpret_cast<uintptr_t>(ptr) >> SLAB_SHIFT) - this->m_first_page);
+
+	if (this->m_slab_map == NULL || page >= this->m_page_count)
+		return 0;
+	return this->m_slab_map[page];
+}
+
+EMMA_INLINE bool emma::allocators::Slab::refill_class(std::size_t class_index)
+{/* Params    : (1) Index of the size class that has no free objects left
+ *  On success: Carves a new slab from the free list, returns true
+ *  On failure: Returns false
+ *  Fails if  : The free list doesn't have a free SLAB_SIZE block */
+
+	// Aligned to SLAB_SIZE, so that the slab fills exactly one page
+	uint8_t* slab = static_cast<uint8_t*>(this->m_backend.allocate_raw_ptr(SLAB_SIZE, SLAB_SIZE));
+	if (slab == NULL)
+		return false;
+
+	std::size_t page = static_cast<std::size_t>(\
+		(reinterpret_cast<uintptr_t>(slab) >> SLAB_SHIFT) - this->m_first_page);
+	this->m_slab_map[page] = static_cast<uint8_t>(class_index + 1);
+
+	// Link the objects backwards, so they get handed out in address order
+	std::size_t class_size = MIN_CLASS_SIZE << class_index;
+	FreeObject* head = NULL;
+	for (std::size_t offset = SLAB_SIZE; offset != 0; offset -= class_size)
+		head = new(slab + offset - class_size) FreeObject(head);
+
+	this->m_free_objects[class_index] = head;
+	return true;
+}
@@ -0,0 +1,177 @@
+/* [ STACK ALLOCATOR CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * Like the arena, allocating moves (bumps) a pointer to the next free byte.
+ * Unlike the arena, the pointer can also be moved back, one allocation at a
+ * time. So allocations must be freed in the reverse order of allocating.
+ *
+ *  - Simplified example of memory layout -
+ * ┌───┬──┬────────┬─┬──┬──────────────┬───┬──┬──────┬──────────────────────┐
+ * │Pad│Of│ Data   │P│Of│ Data         │Pad│Of│ Data │ Free memory          │
+ * └───┴──┴────────┴─┴──┴──────────────┴───┴──┴──────┴──────────────────────┘
+ * ^─────┘           ^──┘                ^──────┘    └ Top
+ *
+ * The only metadata is a 4 byte offset (Of) in front of the data, which tells
+ * how far back the top was before the allocation. Freeing just moves the top
+ * back by it. O(1).
+ *
+ * Freeing something other than the newest allocation also frees everything
+ * allocated after it, the same way as going back to a marker does.
+ *
+ * A marker is just the current position of the top. Going back to it frees
+ * everything allocated since, in O(1). The Scope class does this for you
+ * when it goes out of scope, which makes nested scopes easy.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <Stack.hpp>
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+
+EMMA_INLINE emma::allocators::Stack::Stack(void* start, std::size_t size) : emma::BaseAllocator(start, size),
+m_top(static_cast<uint8_t*>(start)), m_last(NULL), m_end(static_cast<uint8_t*>(start) + size)
+{/* Params    : (1) Ptr to the start of the memory available for the allocator
+ *              (2) Size of the memory available for the allocator
+ *  On Success: Initializes the allocator, which will be ready for immediate use.
+ *  On failure: Throws an exception if they're enabled.
+ *              Otherwise does nothing & attempted allocations return NULL.
+ *  Fails if  : Start is NULL */
+
+	if (start == NULL)
+	{
+		emma::return_error<bool>(true, "Starting address can't be NULL");
+		this->m_end = NULL; // Nothing fits, allocations will fail
+	}
+}
+
+EMMA_INLINE emma::allocators::Stack::~Stack() {}
+
+
+EMMA_INLINE void* emma::allocators::Stack::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns an aligned pointer to the newly allocated data
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory, data_size == 0,
+ *              or alignment is not a power of two */
+
+	if (data_size == 0)
+		return emma::return_error<void*>(NULL, "Allocation size can't be 0!");
+	if (alignment_is_invalid(alignment))
+		return emma::return_error<void*>(NULL, "Alignment must be a power of two");
+
+	// The offset has to be aligned too
+	if (alignment < alignof(BackOffset))
+		alignment = alignof(BackOffset);
+
+	uint8_t* data_position = this->m_top + sizeof(BackOffset);
+	std::size_t offset = sizeof(BackOffset) + static_cast<std::size_t>(\
+		(alignment - reinterpret_cast<uintptr_t>(data_position) % alignment) % alignment);
+	std::size_t space_left = static_cast<std::size_t>(this->m_end - this->m_top);
+
+	if (offset > space_left || data_size > space_left - offset)
+		return emma::return_error<void*>(NULL, "Stack is out of memory");
+
+	uint8_t* ptr = this->m_top + offset;
+	*(reinterpret_cast<BackOffset*>(ptr) - 1) = static_cast<BackOffset>(offset);
+	this->m_top = ptr + data_size;
+	this->m_last = ptr;
+	return static_cast<void*>(ptr);
+}
+
+EMMA_INLINE void emma::allocators::Stack::free_raw_ptr(void *data)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Frees the data & everything allocated after it
+ *  On failure: Does nothing. Throws exception if they are enabled.
+ *  Fails if  : Data is NULL or has already been freed */
+
+	if (data == NULL)
+		return;
+
+	uint8_t* ptr = static_cast<uint8_t*>(data);
+	if (ptr < static_cast<uint8_t*>(this->m_memory_location) || ptr >= this->m_top)
+	{
+		emma::return_error<bool>(true, "Pointer is not on the stack");
+		return;
+	}
+
+	BackOffset offset = *(reinterpret_cast<BackOffset*>(ptr) - 1);
+	this->m_top = ptr - offset;
+	this->m_last = NULL;
+}
+
+
+EMMA_INLINE void* emma::allocators::Stack::reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment)
+{/* Params    : (1) Data which has been previously allocated, or NULL
+ *              (2) New size of the data
+ *              (3) Alignment of the data, must be a power of two
+ *  On success: Returns a pointer to the resized data.
+ *              The newest allocation is resized in place, by moving the top.
+ *              Anything else is copied to a new allocation.
+ *              The old allocation is freed together with the new one.
+ *  On failure: Returns NULL, ptr is left as is. Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory */
+
+	if (ptr == NULL || alignment_is_invalid(alignment))
+		return allocate_raw_ptr(new_size, alignment);
+	if (new_size == 0)
+	{
+		free_raw_ptr(ptr);
+		return NULL;
+	}
+
+	uint8_t* data = static_cast<uint8_t*>(ptr);
+	if (data == this->m_last && reinterpret_cast<uintptr_t>(data) % alignment == 0
+		&& new_size <= static_cast<std::size_t>(this->m_end - data))
+	{
+		this->m_top = data + new_size;
+		return ptr;
+	}
+
+	// We don't know the old size, but it can't go past the top.
+	// Everything up to the top is our memory, so it is safe to copy.
+	std::size_t old_size_limit = static_cast<std::size_t>(this->m_top - data);
+	void* new_ptr = allocate_raw_ptr(new_size, alignment);
+	if (new_ptr == NULL)
+		return NULL; // Also throws an exception if they're enabled
+
+	std::memcpy(new_ptr, ptr, old_size_limit < new_size ? old_size_limit : new_size);
+	return new_ptr;
+}
+
+EMMA_INLINE std::size_t emma::allocators::Stack::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Returns the amount of bytes from ptr to the top,
+ *              if ptr is the newest allocation.
+ *  On failure: Returns 0
+ *  Fails if  : The ptr is not the newest allocation, as sizes aren't stored */
+
+	if (ptr == NULL || static_cast<uint8_t*>(ptr) != this->m_last)
+		return 0;
+	return static_cast<std::size_t>(this->m_top - this->m_last);
+}
+
+EMMA_INLINE emma::allocators::Stack::Marker emma::allocators::Stack::get_marker() const
+{/* On success: Returns a marker of the current top of the stack
+ *  Fails if  : Cannot fail */
+
+	return static_cast<Marker>(this->m_top - static_cast<uint8_t*>(this->m_memory_location));
+}
+
+EMMA_INLINE void emma::allocators::Stack::free_to_marker(Marker marker)
+{/* Params    : (1) Marker from get_marker()
+ *  On success: Frees everything allocated after the marker was taken
+ *  On failure: Does nothing. Throws exception if they are enabled.
+ *  Fails if  : Marker is past the current top, so it has already been freed */
+
+	if (marker > get_marker())
+	{
+		emma::return_error<bool>(true, "Marker is past the top of the stack");
+		return;
+	}
+	this->m_top = static_cast<uint8_t*>(this->m_memory_location) + marker;
+	this->m_last = NULL;
+}
@@ -0,0 +1,405 @@
+/* [ TLSF ALLOCATOR CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * Two-Level Segregated Fit. Free blocks are kept in lists by their size.
+ * The first level splits the sizes by powers of two, and the second level
+ * splits each power of two linearly into SL_COUNT lists.
+ *
+ *  - Simplified example of the lists -
+ *   First level    Second level (SL_COUNT = 4)
+ *   ┌──────────┐   ┌─────────┬─────────┬─────────┬─────────┐
+ *   │ 256-511  │ → │ 256-319 │ 320-383 │ 384-447 │ 448-511 │
+ *   ├──────────┤   ├─────────┼─────────┼─────────┼─────────┤
+ *   │ 512-1023 │ → │ 512-639 │ 640-767 │ 768-895 │ 896-1023│
+ *   └──────────┘   └─────────┴─────────┴─────────┴─────────┘
+ *
+ * There is a bitmap for which first levels have any free blocks, and one for
+ * every first level telling which of it's lists have free blocks.
+ * Allocating rounds the size up to the next list, so that any block in it is
+ * large enough. Then the first non-empty list at or above it is found with
+ * one bit-scan of each bitmap. The block is split, and the rest goes back.
+ * No searching, no loops, no trees. O(1).
+ *
+ *  - Simplified example of memory layout -
+ * ┌────────────────────┬───────────────────────────────────┬──────────┬────┐
+ * │ Control (bitmaps & │ Header ┬ Data   │ Header ┬ Free    │ ...      │ End│
+ * │ lists)             │ prev ┘ │        │ prev ┘ │ links   │          │    │
+ * └────────────────────┴───────────────────────────────────┴──────────┴────┘
+ *
+ * Every block has a header with it's size, and a pointer to the block right
+ * before it in memory. These are the boundary tags. Freeing checks the
+ * blocks on both sides, and merges with them right away if they are free.
+ * Also O(1).
+ *
+ * An empty, used block at the end keeps the last block from merging past it.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <TLSF.hpp>
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+static inline void get_list_indexes(std::size_t block_size, unsigned int& fl, unsigned int& sl)
+{/* Finds the first & second level of the list for the size */
+
+	if (block_size < (std::size_t(1) << emma::allocators::TLSF::FL_SHIFT))
+	{
+		fl = 0;
+		sl = static_cast<unsigned int>(block_size / (std::size_t(1) << (emma::allocators::TLSF::FL_SHIFT - emma::allocators::TLSF::SL_SHIFT)));
+		return;
+	}
+	unsigned int top_bit = static_cast<unsigned int>(63 - __builtin_clzll(block_size));
+	fl = top_bit - emma::allocators::TLSF::FL_SHIFT + 1;
+	sl = static_cast<unsigned int>(block_size >> (top_bit - emma::allocators::TLSF::SL_SHIFT)) ^ emma::allocators::TLSF::SL_COUNT;
+}
+
+static inline std::size_t round_up_to_next_list(std::size_t block_size)
+{/* Rounds the size up, so that every block in it's list is large enough */
+
+	if (block_size < (std::size_t(1) << emma::allocators::TLSF::FL_SHIFT))
+		return block_size;
+	unsigned int top_bit = static_cast<unsigned int>(63 - __builtin_clzll(block_size));
+	std::size_t list_range = std::size_t(1) << (top_bit - emma::allocators::TLSF::SL_SHIFT);
+	return (block_size + list_range - 1);
+}
+
+EMMA_INLINE emma::allocators::TLSF::TLSF(void* start, std::size_t size) : emma::BaseAllocator(start, size),
+m_control(NULL)
+{/* Params    : (1) Ptr to the start of the memory available for the allocator
+ *              (2) Size of the memory available for the allocator
+ *  On Success: Initializes the allocator, which will be ready for immediate use.
+ *  On failure: Throws an exception if they're enabled.
+ *              Otherwise does nothing & attempted allocations return NULL.
+ *  Fails if  : Start is NULL, or memsize can't fit the control & one block */
+
+	if (start == NULL)
+	{
+		emma::return_error<bool>(true, "Starting address can't be NULL");
+		return;
+	}
+
+	uint8_t* first_block = static_cast<uint8_t*>(start) + sizeof(Control);
+	first_block += (ALIGNMENT - reinterpret_cast<uintptr_t>(first_block) % ALIGNMENT) % ALIGNMENT;
+	uint8_t* end = static_cast<uint8_t*>(start) + size;
+	if (first_block + MIN_BLOCK_SIZE + HEADER_SIZE > end)
+	{
+		emma::return_error<bool>(true, "Memsize is too small");
+		return;
+	}
+
+	// One free block for all of the memory, except for the end block.
+	// Anything past the largest block size possible is left unused.
+	std::size_t block_size = static_cast<std::size_t>(end - first_block - HEADER_SIZE) / ALIGNMENT * ALIGNMENT;
+	if (block_size >= (std::size_t(1) << FL_MAX))
+		block_size = (std::size_t(1) << FL_MAX) - ALIGNMENT;
+
+	this->m_control = new(start) Control();
+	std::memset(static_cast<void*>(this->m_control), 0, sizeof(Control));
+
+	Block* block = new(first_block) Block();
+	block->size = block_size | FREE_BIT;
+
+	// The end block is only a header, so only the header is written.
+	// A whole Block would reach past the end of the memory.
+	Block* end_block = reinterpret_cast<Block*>(first_block + block_size);
+	end_block->prev_physical = block;
+	end_block->size = 0;
+
+	insert_free_block(block);
+}
+
+EMMA_INLINE emma::allocators::TLSF::~TLSF() {}
+
+
+EMMA_INLINE void* emma::allocators::TLSF::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns a pointer to the newly allocated data,
+ *              aligned to ALIGNMENT or the alignment asked, whichever is larger
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : There is no free block large enough, data_size == 0,
+ *              or alignment is not a power of two */
+
+	if (data_size == 0)
+	{
+		EMMA_STATS(++this->m_stats.failed_allocations);
+		return emma::return_error<void*>(NULL, "Allocation size can't be 0!");
+	}
+	if (alignment_is_invalid(alignment))
+	{
+		EMMA_STATS(++this->m_stats.failed_allocations);
+		return emma::return_error<void*>(NULL, "Alignment must be a power of two");
+	}
+	if (data_size >= (std::size_t(1) << FL_MAX) || alignment >= (std::size_t(1) << FL_MAX))
+	{
+		EMMA_STATS(++this->m_stats.failed_allocations);
+		return emma::return_error<void*>(NULL, "Allocation size is too large");
+	}
+
+	std::size_t block_size = HEADER_SIZE + (data_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	if (block_size < MIN_BLOCK_SIZE)
+		block_size = MIN_BLOCK_SIZE;
+
+	// Over-aligned data may have to be moved forward, far enough to leave
+	// a whole free block in front of it
+	std::size_t max_front_size = alignment > ALIGNMENT ? alignment + MIN_BLOCK_SIZE : 0;
+
+	Block* block = find_free_block(block_size + max_front_size);
+	if (block == NULL)
+	{
+		EMMA_STATS(++this->m_stats.failed_allocations);
+		return emma::return_error<void*>(NULL, "No free block large enough");
+	}
+	remove_free_block(block);
+
+	std::size_t free_size = block->size & ~FREE_BIT;
+	Block* next = reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) + free_size);
+
+	if (max_front_size != 0)
+		block = split_front_for_alignment(block, alignment, free_size);
+
+	// Split off the rest, if it's large enough to be a block
+	if (free_size - block_size >= MIN_BLOCK_SIZE)
+	{
+		Block* rest = new(reinterpret_cast<uint8_t*>(block) + block_size) Block();
+		rest->prev_physical = block;
+		rest->size = (free_size - block_size) | FREE_BIT;
+		next->prev_physical = rest;
+		insert_free_block(rest);
+		free_size = block_size;
+	}
+	block->size = free_size; // Clears the free bit
+	EMMA_STATS(count_allocation(free_size - HEADER_SIZE));
+	return static_cast<void*>(reinterpret_cast<uint8_t*>(block) + HEADER_SIZE);
+}
+
+EMMA_INLINE void emma::allocators::TLSF::free_raw_ptr(void *data)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Deallocates the data and merges it with free blocks beside it
+ *  On failure: Does nothing
+ *  Fails if  : Data is NULL. Otherwise cannot fail (assuming ptr is valid) */
+
+	if (data == NULL)
+		return;
+
+	Block* block = reinterpret_cast<Block*>(static_cast<uint8_t*>(data) - HEADER_SIZE);
+	Block* next = reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) + block->size);
+	EMMA_STATS(count_free(block->size - HEADER_SIZE));
+
+	// Merge with the next block
+	if (next->size & FREE_BIT)
+	{
+		EMMA_STATS(++this->m_stats.merges);
+		remove_free_block(next);
+		block->size += next->size & ~FREE_BIT;
+		next = reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) + block->size);
+	}
+
+	// Merge with the previous block
+	Block* prev = block->prev_physical;
+	if (prev != NULL && (prev->size & FREE_BIT))
+	{
+		EMMA_STATS(++this->m_stats.merges);
+		remove_free_block(prev);
+		prev->size = (prev->size & ~FREE_BIT) + block->size;
+		block = prev;
+	}
+
+	next->prev_physical = block;
+	block->size |= FREE_BIT;
+	insert_free_block(block);
+}
+
+
+EMMA_INLINE void* emma::allocators::TLSF::reallocate_raw_ptr(void* ptr, std::size_t new_size, std::size_t alignment)
+{/* Params    : (1) Data which has been previously allocated, or NULL
+ *              (2) New size of the data
+ *              (3) Alignment of the data, must be a power of two
+ *  On success: Returns a pointer to the resized data.
+ *              Grows in place if the next block is free & large enough,
+ *              and shrinks in place by splitting off the tail.
+ *              Otherwise moves the data to a new block.
+ *  On failure: Returns NULL, ptr is left as is. Throws exception if they are enabled.
+ *  Fails if  : There is no free block large enough */
+
+	if (ptr == NULL || new_size == 0 || alignment_is_invalid(alignment)
+		|| new_size >= (std::size_t(1) << FL_MAX)
+		|| reinterpret_cast<uintptr_t>(ptr) % alignment != 0)
+		return emma::BaseAllocator::reallocate_raw_ptr(ptr, new_size, alignment);
+
+	Block* block = reinterpret_cast<Block*>(static_cast<uint8_t*>(ptr) - HEADER_SIZE);
+	Block* next = reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) + block->size);
+	EMMA_STATS(std::size_t old_size = block->size - HEADER_SIZE);
+
+	std::size_t block_size = HEADER_SIZE + (new_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	if (block_size < MIN_BLOCK_SIZE)
+		block_size = MIN_BLOCK_SIZE;
+
+	// Take the next block, if it's free & we need it or it can take the tail
+	if ((next->size & FREE_BIT) && (block_size > block->size \
+		|| block->size - block_size + (next->size & ~FREE_BIT) >= MIN_BLOCK_SIZE))
+	{
+		if (block_size > block->size + (next->size & ~FREE_BIT))
+			return emma::BaseAllocator::reallocate_raw_ptr(ptr, new_size, alignment);
+		remove_free_block(next);
+		block->size += next->size & ~FREE_BIT;
+		next = reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) + block->size);
+		next->prev_physical = block;
+	}
+	else if (block_size > block->size)
+		return emma::BaseAllocator::reallocate_raw_ptr(ptr, new_size, alignment);
+
+	// Split off the tail, if it's large enough to be a block
+	if (block->size - block_size >= MIN_BLOCK_SIZE)
+	{
+		Block* rest = new(reinterpret_cast<uint8_t*>(block) + block_size) Block();
+		rest->prev_physical = block;
+		rest->size = (block->size - block_size) | FREE_BIT;
+		next->prev_physical = rest;
+		insert_free_block(rest);
+		block->size = block_size;
+	}
+	EMMA_STATS(count_resize(old_size, block->size - HEADER_SIZE));
+	return ptr;
+}
+
+EMMA_INLINE std::size_t emma::allocators::TLSF::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Returns the amount of bytes from ptr to the end of it's block
+ *  Fails if  : Returns 0 if ptr is NULL */
+
+	if (ptr == NULL)
+		return 0;
+
+	Block* block = reinterpret_cast<Block*>(static_cast<uint8_t*>(ptr) - HEADER_SIZE);
+	return (block->size - HEADER_SIZE);
+}
+
+EMMA_INLINE emma::Stats emma::allocators::TLSF::get_stats() const
+{/* On success: Returns the counters, with the free blocks measured from the lists.
+ *              O(n) in the amount of free blocks.
+ *  Fails if  : Cannot fail */
+
+	emma::Stats stats = emma::BaseAllocator::get_stats();
+	if (this->m_control == NULL)
+		return stats;
+
+	for (unsigned int fl = 0; fl < FL_COUNT; ++fl)
+		for (unsigned int sl = 0; sl < SL_COUNT; ++sl)
+			for (Block* block = this->m_control->free_lists[fl][sl]; block != NULL; block = block->next_free)
+			{
+				std::size_t block_size = block->size & ~FREE_BIT;
+				++stats.free_block_count;
+				stats.free_bytes += block_size;
+				if (block_size > stats.largest_free_block)
+					stats.largest_free_block = block_size;
+			}
+	return stats;
+}
+
+EMMA_INLINE void emma::allocators::TLSF::insert_free_block(Block* block)
+{/* Params    : (1) Free block
+ *  On success: Adds the block to the front of it's list, and marks the bitmaps
+ *  Fails if  : Cannot fail */
+
+	unsigned int fl, sl;
+	get_list_indexes(block->size & ~FREE_BIT, fl, sl);
+
+	block->prev_free = NULL;
+	block->next_free = this->m_control->free_lists[fl][sl];
+	if (block->next_free != NULL)
+		block->next_free->prev_free = block;
+	this->m_control->free_lists[fl][sl] = block;
+
+	this->m_control->fl_bitmap |= uint32_t(1) << fl;
+	this->m_control->sl_bitmaps[fl] |= uint32_t(1) << sl;
+}
+
+EMMA_INLINE void emma::allocators::TLSF::remove_free_block(Block* block)
+{/* Params    : (1) Free block
+ *  On success: Removes the block from it's list, and clears the bitmaps
+ *              if the list became empty
+ *  Fails if  : Cannot fail, if the block is free */
+
+	unsigned int fl, sl;
+	get_list_indexes(block->size & ~FREE_BIT, fl, sl);
+
+	if (block->prev_free != NULL)
+		block->prev_free->next_free = block->next_free;
+	else
+		this->m_control->free_lists[fl][sl] = block->next_free;
+	if (block->next_free != NULL)
+		block->next_free->prev_free = block->prev_free;
+
+	if (this->m_control->free_lists[fl][sl] == NULL)
+	{
+		this->m_control->sl_bitmaps[fl] &= ~(uint32_t(1) << sl);
+		if (this->m_control->sl_bitmaps[fl] == 0)
+			this->m_control->fl_bitmap &= ~(uint32_t(1) << fl);
+	}
+}
+
+EMMA_INLINE emma::allocators::TLSF::Block* emma::allocators::TLSF::split_front_for_alignment(\
+Block* block, std::size_t alignment, std::size_t& block_size)
+{/* Params    : (1) Free block, which has been removed from it's list
+ *              (2) Alignment of the data, larger than ALIGNMENT
+ *              (3) Size of the block. Updated to the size of the new block.
+ *  On success: Splits off the front of the block into a free block, so that
+ *              the data of the rest is aligned. Returns the rest, which the
+ *              block after it now points back to.
+ *  Fails if  : Cannot fail, if the block has alignment + MIN_BLOCK_SIZE extra */
+
+	uintptr_t data = reinterpret_cast<uintptr_t>(block) + HEADER_SIZE;
+	std::size_t front_size = static_cast<std::size_t>((alignment - data % alignment) % alignment);
+	if (front_size == 0)
+		return block;
+
+	// Too small to be a block of it's own, move to the next aligned position
+	if (front_size < MIN_BLOCK_SIZE)
+		front_size += alignment;
+
+	// The block after us has to find the rest, not the new free block,
+	// or freeing it would merge across the rest
+	Block* next = reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) + block_size);
+	Block* rest = new(reinterpret_cast<uint8_t*>(block) + front_size) Block();
+	rest->prev_physical = block;
+	next->prev_physical = rest;
+	block->size = front_size | FREE_BIT;
+	insert_free_block(block);
+
+	block_size -= front_size;
+	return rest;
+}
+
+EMMA_INLINE emma::allocators::TLSF::Block* emma::allocators::TLSF::find_free_block(std::size_t block_size)
+{/* Params    : (1) Size of the block we need, header included
+ *  On success: Returns a free block of at least that size. Doesn't remove it.
+ *  On failure: Returns NULL
+ *  Fails if  : There is no list with blocks that are all large enough */
+
+	if (this->m_control == NULL)
+		return NULL;
+
+	unsigned int fl, sl;
+	get_list_indexes(round_up_to_next_list(block_size), fl, sl);
+	if (fl >= FL_COUNT)
+		return NULL;
+
+	// A list at or after sl, in the same first level
+	uint32_t sl_bitmap = this->m_control->sl_bitmaps[fl] & (~uint32_t(0) << sl);
+	if (sl_bitmap == 0)
+	{
+		// Otherwise the first list of a larger first level
+		uint32_t fl_bitmap = (fl + 1 < 32) ? this->m_control->fl_bitmap & (~uint32_t(0) << (fl + 1)) : 0;
+		if (fl_bitmap == 0)
+			return NULL;
+		fl = static_cast<unsigned int>(__builtin_ctz(fl_bitmap));
+		sl_bitmap = this->m_control->sl_bitmaps[fl];
+	}
+	sl = static_cast<unsigned int>(__builtin_ctz(sl_bitmap));
+	return this->m_control->free_lists[fl][sl];
+}
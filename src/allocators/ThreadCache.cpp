@@ -0,0 +1,222 @@
+/* [ THREAD CACHE ALLOCATOR CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * Every thread owns one ThreadCache, all of them are built on the same
+ * SharedFreeList. Which means memory freed by an idle thread isn't stranded,
+ * it goes back to the shared heap once that thread's cache is drained.
+ *
+ *  - Simplified example of a cached block -
+ * ┌─────────┬───────────┬───────────────────────────────┐
+ * │Size|F|PF│ Tag       │ Data / next cached block      │
+ * └─────────┴───────────┴───────────────────────────────┘
+ *  FreeList  ThreadCache
+ *
+ * The FreeList's header is one boundary tag: the block's size, with
+ * FREE_BIT (F) & PREV_FREE_BIT (PF) in the lowest bits.
+ *
+ * Allocations are rounded up to a power of two size class. Each class has
+ * an intrusive list of cached blocks, allocating & freeing is just a pop/push.
+ * No locks or atomic operations are involved, the cache is only used by the
+ * thread that owns it.
+ *
+ * When a class runs out of blocks, BATCH_SIZE blocks are allocated from the
+ * shared heap while holding it's lock once. When a class has cached too many
+ * blocks, BATCH_SIZE of them are given back the same way.
+ *
+ * A small tag in front of each block remembers it's class, since a block may
+ * be freed by a different thread than the one who allocated it.
+ * Blocks larger than MAX_CLASS_SIZE skip the cache & go to the shared heap.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <ThreadCache.hpp>
+#include <stdint.h>
+#include <memory>
+#include <new>
+
+EMMA_INLINE emma::allocators::ThreadCache::ThreadCache(emma::allocators::SharedFreeList& shared_heap) :
+emma::BaseAllocator(shared_heap.get_memory_location(), shared_heap.get_memory_maxsize()),
+m_shared_heap(shared_heap)
+{/* Params    : (1) The shared heap, which this cache takes it's memory from
+ *  On Success: Initializes an empty cache, which will be ready for immediate use.
+ *  Fails if  : Cannot fail */
+
+	for (std::size_t i = 0; i < CLASS_COUNT; ++i)
+	{
+		this->m_cached_blocks[i] = NULL;
+		this->m_cached_count[i] = 0;
+	}
+}
+
+EMMA_INLINE emma::allocators::ThreadCache::~ThreadCache()
+{
+	flush();
+}
+
+
+EMMA_INLINE void* emma::allocators::ThreadCache::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Returns an aligned pointer to the newly allocated data
+ *  On failure: Returns NULL. Throws exception if they are enabled.
+ *  Fails if  : There is not enough memory in the shared heap, data_size == 0,
+ *	        alignment is not a power of two or data_size would overflow with the tag */
+
+	if (data_size == 0)
+		return emma::return_error<void*>(NULL, "Allocation size can't be 0!");
+	if (alignment_is_invalid(alignment))
+		return emma::return_error<void*>(NULL, "Alignment must be a power of two");
+
+	// Large & over-aligned blocks bypass the cache, but still need a tag for free_raw_ptr()
+	if (data_size > MAX_CLASS_SIZE || alignment > alignof(Tag))
+	{
+		std::size_t block_offset = alignment > sizeof(Tag) ? alignment : sizeof(Tag);
+		if (data_size + block_offset < data_size)
+			return emma::return_error<void*>(NULL, "Allocation size would overflow!");
+
+		uint8_t* block = static_cast<uint8_t*>(this->m_shared_heap.allocate_raw_ptr(\
+			data_size + block_offset, alignment > alignof(Tag) ? alignment : alignof(Tag)));
+		if (block == NULL)
+			return NULL; // Also throws an exception if they're enabled
+
+		return static_cast<void*>(new(block + block_offset - sizeof(Tag)) Tag(LARGE_BLOCK, block_offset) + 1);
+	}
+
+	std::size_t class_index = get_class_index(data_size);
+
+	if (this->m_cached_blocks[class_index] == NULL && !refill_class(class_index))
+		return emma::return_error<void*>(NULL, "Shared heap has no memory left");
+
+	CachedBlock* block = this->m_cached_blocks[class_index];
+	this->m_cached_blocks[class_index] = block->next;
+	--this->m_cached_count[class_index];
+	std::destroy_at(block);
+
+	return static_cast<void*>(block);
+}
+
+EMMA_INLINE void emma::allocators::ThreadCache::free_raw_ptr(void *data)
+{/* Params    : (1) Data which has been previously allocated by any ThreadCache
+ *                  of the same shared heap
+ *  On success: Deallocates the requested data
+ *  On failure: Does nothing
+ *  Fails if  : Data is NULL. Otherwise cannot fail (assuming ptr is valid) */
+
+	if (data == NULL)
+		return;
+
+	Tag* tag = static_cast<Tag*>(data) - 1;
+	std::size_t class_index = tag->class_index;
+
+	if (class_index == LARGE_BLOCK)
+	{
+		uint8_t* block = static_cast<uint8_t*>(data) - tag->block_offset;
+		std::destroy_at(tag);
+		this->m_shared_heap.free_raw_ptr(static_cast<void*>(block));
+		return;
+	}
+
+	this->m_cached_blocks[class_index] = new(data) CachedBlock(this->m_cached_blocks[class_index]);
+	++this->m_cached_count[class_index];
+
+	if (this->m_cached_count[class_index] > MAX_CACHED_BLOCKS)
+		drain_class(class_index, BATCH_SIZE);
+}
+
+EMMA_INLINE std::size_t emma::allocators::ThreadCache::usable_size(void* ptr)
+{/* Params    : (1) Data which has been previously allocated by any ThreadCache
+ *                  of the same shared heap
+ *  On success: Returns the size of the block's class. For large blocks, the
+ *              usable size given by the shared heap, minus the tag.
+ *  Fails if  : Returns 0 if ptr is NULL */
+
+	if (ptr == NULL)
+		return 0;
+
+	Tag* tag = static_cast<Tag*>(ptr) - 1;
+	if (tag->class_index == LARGE_BLOCK)
+	{
+		uint8_t* block = static_cast<uint8_t*>(ptr) - tag->block_offset;
+		return this->m_shared_heap.usable_size(static_cast<void*>(block)) - tag->block_offset;
+	}
+	return (MIN_CLASS_SIZE << tag->class_index);
+}
+
+EMMA_INLINE void emma::allocators::ThreadCache::flush()
+{/* On success: Gives all of the cached blocks back to the shared heap
+ *  Fails if  : Cannot fail */
+
+	for (std::size_t i = 0; i < CLASS_COUNT; ++i)
+	{
+		while (this->m_cached_count[i] != 0)
+			drain_class(i, BATCH_SIZE);
+	}
+}
+
+
+EMMA_INLINE std::size_t emma::allocators::ThreadCache::get_class_index(std::size_t data_size)
+{/* Params    : (1) Size of the allocation, at most MAX_CLASS_SIZE
+ *  On success: Returns the index of the smallest size class that fits the size
+ *  Fails if  : Cannot fail */
+
+	std::size_t class_index = 0;
+	std::size_t class_size = MIN_CLASS_SIZE;
+
+	while (class_size < data_size)
+	{
+		class_size <<= 1;
+		++class_index;
+	}
+	return class_index;
+}
+
+EMMA_INLINE bool emma::allocators::ThreadCache::refill_class(std::size_t class_index)
+{/* Params    : (1) Index of the size class that has no cached blocks left
+ *  On success: Takes up to BATCH_SIZE blocks from the shared heap, returns true
+ *  On failure: Returns false
+ *  Fails if  : The shared heap couldn't give us a single block */
+
+	void*		blocks[BATCH_SIZE];
+	std::size_t	class_size = MIN_CLASS_SIZE << class_index;
+
+	// A multiple of the tag size, so the shared heap aligns it for the tag
+	std::size_t	count = this->m_shared_heap.allocate_bulk(\
+		class_size + sizeof(Tag), BATCH_SIZE, blocks);
+
+	// The tag stays in place for as long as the block lives
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		Tag* data = new(blocks[i]) Tag(class_index, sizeof(Tag)) + 1;
+		this->m_cached_blocks[class_index] =\
+			new(data) CachedBlock(this->m_cached_blocks[class_index]);
+	}
+	this->m_cached_count[class_index] += count;
+
+	return (count != 0);
+}
+
+EMMA_INLINE void emma::allocators::ThreadCache::drain_class(std::size_t class_index, std::size_t count)
+{/* Params    : (1) Index of the size class to drain
+ *              (2) Max amount of blocks to give back, at most BATCH_SIZE
+ *  On success: Gives the blocks back to the shared heap, holding it's lock once
+ *  Fails if  : Cannot fail */
+
+	void*		blocks[BATCH_SIZE];
+	std::size_t	drained = 0;
+
+	while (drained < count && this->m_cached_blocks[class_index] != NULL)
+	{
+		CachedBlock* block = this->m_cached_blocks[class_index];
+		this->m_cached_blocks[class_index] = block->next;
+		std::destroy_at(block);
+
+		Tag* tag = reinterpret_cast<Tag*>(block) - 1;
+		std::destroy_at(tag);
+		blocks[drained++] = static_cast<void*>(tag);
+	}
+	this->m_cached_count[class_index] -= drained;
+
+	this->m_shared_heap.free_bulk(blocks, drained);
+}
@@ -0,0 +1,108 @@
+/* [ TRACE RECORDER CLASS FILE ]
+ *
+ * This is derived from the base allocator class.
+ *
+ * Every call is forwarded to the wrapped allocator as is, and then recorded.
+ * The records are kept in a small buffer inside of the recorder, and written
+ * into the file only once it's full. Nothing is allocated while recording,
+ * so the recorder can also sit behind the malloc shim.
+ *
+ * Allocations are identified by their address. An address is only reused
+ * after it has been freed, so a replay can match each free to it's allocation
+ * by keeping track of which addresses are live.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <TraceRecorder.hpp>
+#include <cstdio>
+#include <chrono>
+#include <stdint.h>
+
+EMMA_INLINE emma::TraceRecorder::TraceRecorder(emma::BaseAllocator& allocator, std::FILE* trace_file) :
+emma::BaseAllocator(allocator.get_memory_location(), allocator.get_memory_maxsize()),
+m_allocator(allocator), m_file(trace_file), m_start(std::chrono::steady_clock::now()),
+m_record_count(0), m_buffered(0)
+{/* Params    : (1) The allocator which makes the allocations
+ *              (2) File the trace is written to, opened for writing in binary
+ *  On Success: Writes the start of the trace, and is ready for immediate use.
+ *  On failure: Works as usual, but nothing is recorded
+ *  Fails if  : The file is NULL */
+
+	if (this->m_file != NULL)
+		std::fwrite(emma::TRACE_MAGIC, sizeof(emma::TRACE_MAGIC), 1, this->m_file);
+}
+
+EMMA_INLINE emma::TraceRecorder::~TraceRecorder()
+{
+	flush();
+}
+
+
+EMMA_INLINE void* emma::TraceRecorder::allocate_raw_ptr(std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation we want to make
+ *              (2) Alignment of the allocation, must be a power of two
+ *  On success: Same as the wrapped allocator. Failed allocations are recorded too.
+ *  On failure: Same as the wrapped allocator */
+
+	void* ptr = this->m_allocator.allocate_raw_ptr(data_size, alignment);
+	record(emma::TraceRecord::ALLOCATE, ptr, data_size, alignment);
+	return ptr;
+}
+
+EMMA_INLINE void emma::TraceRecorder::free_raw_ptr(void *data)
+{/* Params    : (1) Data which has been previously allocated
+ *  On success: Same as the wrapped allocator
+ *  Fails if  : Data is NULL, nothing is recorded then */
+
+	if (data == NULL)
+		return;
+
+	this->m_allocator.free_raw_ptr(data);
+	record(emma::TraceRecord::FREE, data, 0, 1);
+}
+
+EMMA_INLINE std::size_t emma::TraceRecorder::usable_size(void* ptr)
+{
+	return this->m_allocator.usable_size(ptr);
+}
+
+EMMA_INLINE emma::Stats emma::TraceRecorder::get_stats() const
+{
+	return this->m_allocator.get_stats();
+}
+
+
+EMMA_INLINE void emma::TraceRecorder::flush()
+{/* On success: Writes every buffered record into the file
+ *  Fails if  : The file is NULL or can't be written to. The records are dropped. */
+
+	if (this->m_file != NULL && this->m_buffered > 0)
+	{
+		std::fwrite(this->m_buffer, sizeof(emma::TraceRecord), this->m_buffered, this->m_file);
+		std::fflush(this->m_file);
+	}
+	this->m_buffered = 0;
+}
+
+EMMA_INLINE void emma::TraceRecorder::record(emma::TraceRecord::Operation operation, void* ptr,
+std::size_t data_size, std::size_t alignment)
+{/* Params    : (1) What was done
+ *              (2) The allocation, NULL if it failed
+ *              (3) Size asked for, 0 for frees
+ *              (4) Alignment asked for
+ *  On success: Buffers the record, and writes the buffer into the file once it's full
+ *  Fails if  : Cannot fail */
+
+	if (this->m_file == NULL)
+		return;
+
+	uint64_t time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(\
+		std::chrono::steady_clock::now() - this->m_start).count());
+	this->m_buffer[this->m_buffered++] = emma::TraceRecord(time,\
+		static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)), operation, data_size, alignment);
+	++this->m_record_count;
+
+	if (this->m_buffered == BUFFER_SIZE)
+		flush();
+}
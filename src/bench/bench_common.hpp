@@ -0,0 +1,129 @@
+/* [ SHARED PARTS OF THE BENCHMARKS ]
+ *
+ *   The glibc malloc baseline, the operations every workload is made of &
+ *   the JSON/CSV writers, for both 'make bench' & 'make bench_threads'.
+ *   A fix to any of them is a fix to both tools.
+ *
+ *   Each tool turns it's results into rows of named fields, the writers
+ *   only know how to lay those out. Every row must have the same fields.
+*/
+
+#ifndef BENCH_COMMON_HPP
+# define BENCH_COMMON_HPP
+
+# include <EMMA.hpp>
+# include <malloc.h>
+# include <stdint.h>
+# include <stdlib.h>
+# include <cstdio>
+# include <ctime>
+# include <string>
+# include <vector>
+
+class MallocAllocator final : public emma::BaseAllocator // The baseline
+{
+	public:
+		MallocAllocator() : emma::BaseAllocator(NULL, 0) {}
+		~MallocAllocator() {}
+
+		using emma::BaseAllocator::allocate_raw_ptr;
+		void*	allocate_raw_ptr(std::size_t data_size, std::size_t alignment) override
+		{
+			if (alignment <= alignof(std::max_align_t))
+				return malloc(data_size);
+			void* ptr = NULL;
+			return (posix_memalign(&ptr, alignment, data_size) == 0 ? ptr : NULL);
+		}
+
+		void		free_raw_ptr(void* data) override { free(data); }
+		std::size_t	usable_size(void* ptr) override { return malloc_usable_size(ptr); }
+};
+
+class BenchOperation
+{
+	public:
+		uint32_t	slot;
+		uint32_t	size; // 0 frees the slot
+};
+
+
+/* [ OUTPUT ] */
+
+class BenchField // One value of a result, as it's written to each file
+{
+	public:
+		const char*	name;
+		std::string	csv;
+		std::string	json;
+};
+
+typedef std::vector<BenchField>	BenchRow;
+
+static inline BenchField bench_text(const char* name, const std::string& text)
+{
+	return BenchField{name, text, "\"" + text + "\""};
+}
+
+template <class T>
+static inline BenchField bench_number(const char* name, const char* format, T value)
+{
+	char text[64];
+	std::snprintf(text, sizeof(text), format, value);
+	return BenchField{name, text, text};
+}
+
+static inline BenchField bench_null_if_zero(const char* name, std::size_t value)
+{/* For values that aren't known, 0 in the CSV & null in the JSON */
+
+	BenchField field = bench_number(name, "%zu", value);
+	if (value == 0)
+		field.json = "null";
+	return field;
+}
+
+static bool write_csv(const std::string& path, const std::vector<BenchRow>& rows)
+{
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == NULL)
+		return false;
+
+	for (std::size_t i = 0; !rows.empty() && i < rows[0].size(); ++i)
+		std::fprintf(file, "%s%s", rows[0][i].name, i + 1 < rows[0].size() ? "," : "\n");
+	for (const BenchRow& row : rows)
+	{
+		for (std::size_t i = 0; i < row.size(); ++i)
+			std::fprintf(file, "%s%s", row[i].csv.c_str(), i + 1 < row.size() ? "," : "\n");
+	}
+	std::fclose(file);
+	return true;
+}
+
+static bool write_json(const std::string& path, const BenchRow& header, const std::vector<BenchRow>& rows)
+{/* The date & the compiler come first, then the header's fields & the results */
+
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == NULL)
+		return false;
+
+	char date[32];
+	std::time_t now = std::time(NULL);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	std::fprintf(file, "{\n  \"date\": \"%s\",\n  \"compiler\": \"%s\",\n", date, __VERSION__);
+	for (const BenchField& field : header)
+		std::fprintf(file, "  \"%s\": %s,\n", field.name, field.json.c_str());
+	std::fprintf(file, "  \"results\": [\n");
+	for (std::size_t i = 0; i < rows.size(); ++i)
+	{
+		std::fprintf(file, "    { ");
+		for (std::size_t j = 0; j < rows[i].size(); ++j)
+			std::fprintf(file, "\"%s\": %s%s", rows[i][j].name, rows[i][j].json.c_str(),
+				j + 1 < rows[i].size() ? ", " : " }");
+		std::fprintf(file, i + 1 < rows.size() ? ",\n" : "\n");
+	}
+	std::fprintf(file, "  ]\n}\n");
+	std::fclose(file);
+	return true;
+}
+
+#endif
@@ -0,0 +1,361 @@
+/* [ BENCHMARK SUITE ]
+ *
+ *   Runs the same set of workloads against every general purpose allocator
+ *   & glibc's malloc, and writes the results as JSON & CSV, so that they can
+ *   be compared between releases. Built & run by 'make bench'.
+ *
+ *   ./build/emma_bench [output path without extension] [workload]
+ *
+ *   Workloads:
+ *     random_sizes       Random frees & allocations of 8 B - 4 KiB, log-uniform
+ *     producer_consumer  Messages of 32 - 512 B made in bursts, freed oldest first
+ *     fragmentation      Long churn of small & large blocks, some of them long lived
+ *     larson             Larson-style, a random slot is freed & refilled each round
+ *
+ *   The workloads are single threaded, so that every allocator can run them.
+ *
+ *   Each workload is generated once, from a fixed seed, into a list of
+ *   operations. Every allocator then runs the same list, so the random number
+ *   generator isn't timed. The list is timed as a whole, not call by call,
+ *   so that reading the timer doesn't add to the result.
+ *
+ *   Every allocator runs each workload once to warm up, & then BENCH_REPEATS
+ *   times. The median & the best run are reported. The warm up also records the
+ *   failures & the peak footprint, which is the distance from the start of the
+ *   heap to the end of the furthest allocation. It isn't known for malloc.
+ *
+ *   Arena & Stack aren't included, as they can't free in any order.
+ *   Pool's blocks are made as large as the largest size of the workload.
+ *
+ *   Linux only, the heap is reserved with mmap so that untouched pages are free.
+*/
+
+#include <EMMA.hpp>
+#include "bench_common.hpp"
+#include <sys/mman.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+
+#define BENCH_REPEATS 5
+#define BENCH_HEAP_SIZE (std::size_t(1) << 28)
+
+static const char*	g_allocator_names[] = {
+	"freelist", "slab", "sharedfreelist", "threadcache", "pool", "tlsf", "buddy", "malloc" };
+
+class BenchHeap // Owns the allocator, & the shared heap behind it if it has one
+{
+	public:
+		std::unique_ptr<emma::allocators::SharedFreeList>	shared_heap;
+		std::unique_ptr<emma::BaseAllocator>				allocator;
+};
+
+static void make_heap(BenchHeap& heap, const std::string& name, void* memory, std::size_t max_size)
+{
+	if (name == "freelist")
+		heap.allocator.reset(new emma::allocators::FreeList(memory, BENCH_HEAP_SIZE));
+	else if (name == "slab")
+		heap.allocator.reset(new emma::allocators::Slab(memory, BENCH_HEAP_SIZE));
+	else if (name == "sharedfreelist")
+		heap.allocator.reset(new emma::allocators::SharedFreeList(memory, BENCH_HEAP_SIZE));
+	else if (name == "threadcache")
+	{
+		heap.shared_heap.reset(new emma::allocators::SharedFreeList(memory, BENCH_HEAP_SIZE));
+		heap.allocator.reset(new emma::allocators::ThreadCache(*heap.shared_heap));
+	}
+	else if (name == "pool")
+		heap.allocator.reset(new emma::allocators::Pool(memory, BENCH_HEAP_SIZE, max_size));
+	else if (name == "buddy")
+		heap.allocator.reset(new emma::allocators::Buddy(memory, BENCH_HEAP_SIZE));
+	else if (name == "tlsf")
+		heap.allocator.reset(new emma::allocators::TLSF(memory, BENCH_HEAP_SIZE));
+	else
+		heap.allocator.reset(new MallocAllocator());
+}
+
+
+/* [ WORKLOADS ] */
+
+class Workload
+{
+	public:
+		Workload(const char* workload_name) : name(workload_name), slot_count(0), max_size(0) {}
+
+		const char*	name;
+		std::vector<BenchOperation>	operations;
+		std::size_t	slot_count;
+		std::size_t	max_size;
+
+		void	allocate(uint32_t slot, uint32_t size)
+		{
+			operations.push_back(BenchOperation{slot, size});
+			max_size = std::max(max_size, static_cast<std::size_t>(size));
+		}
+		void	free(uint32_t slot) { operations.push_back(BenchOperation{slot, 0}); }
+};
+
+static uint32_t random_between(std::mt19937& rng, uint32_t min, uint32_t max)
+{
+	return min + static_cast<uint32_t>(rng() % (max - min + 1));
+}
+
+static uint32_t random_log_uniform(std::mt19937& rng, uint32_t min, uint32_t max)
+{/* Small sizes are as likely as large ones, per power of two */
+
+	std::uniform_real_distribution<double> exponent(std::log2(min), std::log2(max));
+	return static_cast<uint32_t>(std::pow(2.0, exponent(rng)));
+}
+
+static Workload make_random_sizes()
+{
+	Workload workload("random_sizes");
+	workload.slot_count = 1000;
+	std::vector<bool> live(workload.slot_count, false);
+	std::mt19937 rng(1);
+
+	for (int i = 0; i < 1000000; ++i)
+	{
+		uint32_t slot = static_cast<uint32_t>(rng() % workload.slot_count);
+		if (live[slot])
+			workload.free(slot);
+		else
+			workload.allocate(slot, random_log_uniform(rng, 8, 4096));
+		live[slot] = !live[slot];
+	}
+	return workload;
+}
+
+static Workload make_producer_consumer()
+{/* A queue of up to 'slot_count' messages. The producer & consumer take
+    turns, each handling a burst of messages at a time. */
+
+	Workload workload("producer_consumer");
+	workload.slot_count = 4096;
+	std::mt19937 rng(2);
+	uint32_t head = 0, tail = 0, queued = 0;
+
+	while (workload.operations.size() < 1000000)
+	{
+		uint32_t burst = random_between(rng, 1, 64);
+		for (uint32_t i = 0; i < burst && queued < workload.slot_count; ++i, ++queued)
+		{
+			workload.allocate(head, random_between(rng, 32, 512));
+			head = (head + 1) % workload.slot_count;
+		}
+		burst = random_between(rng, 1, 64);
+		for (uint32_t i = 0; i < burst && queued > 0; ++i, --queued)
+		{
+			workload.free(tail);
+			tail = (tail + 1) % workload.slot_count;
+		}
+	}
+	return workload;
+}
+
+static Workload make_fragmentation()
+{/* 4 out of 5 blocks are small, the rest large. The first tenth of the slots
+    are long lived, they are only freed on one visit out of 50. */
+
+	Workload workload("fragmentation");
+	workload.slot_count = 20000;
+	std::vector<bool> live(workload.slot_count, false);
+	std::mt19937 rng(3);
+
+	while (workload.operations.size() < 2000000)
+	{
+		uint32_t slot = static_cast<uint32_t>(rng() % workload.slot_count);
+		if (live[slot])
+		{
+			if (slot < workload.slot_count / 10 && rng() % 50 != 0)
+				continue;
+			workload.free(slot);
+		}
+		else if (rng() % 5 != 0)
+			workload.allocate(slot, random_between(rng, 16, 128));
+		else
+			workload.allocate(slot, random_between(rng, 512, 8192));
+		live[slot] = !live[slot];
+	}
+	return workload;
+}
+
+static Workload make_larson()
+{/* Every slot is filled, then each round frees a random slot & fills it again */
+
+	Workload workload("larson");
+	workload.slot_count = 5000;
+	std::mt19937 rng(4);
+
+	for (uint32_t slot = 0; slot < workload.slot_count; ++slot)
+		workload.allocate(slot, random_between(rng, 8, 1000));
+	for (int i = 0; i < 1000000; ++i)
+	{
+		uint32_t slot = static_cast<uint32_t>(rng() % workload.slot_count);
+		workload.free(slot);
+		workload.allocate(slot, random_between(rng, 8, 1000));
+	}
+	return workload;
+}
+
+
+/* [ RUNNING ] */
+
+class BenchResult
+{
+	public:
+		std::string	workload;
+		std::string	allocator;
+		std::size_t	operations;
+		double		median_ns_per_op;
+		double		best_ns_per_op;
+		std::size_t	failures;
+		std::size_t	peak_footprint; // 0 if it isn't known
+};
+
+static double run_timed(emma::BaseAllocator& allocator, const Workload& workload, std::vector<void*>& slots)
+{/* Returns the nanoseconds the whole workload took. What's left is freed after,
+    so freed slots are set to NULL. */
+
+	auto begin = std::chrono::steady_clock::now();
+	for (const BenchOperation& operation : workload.operations)
+	{
+		if (operation.size == 0)
+		{
+			allocator.free_raw_ptr(slots[operation.slot]);
+			slots[operation.slot] = NULL;
+		}
+		else
+			slots[operation.slot] = allocator.allocate_raw_ptr(operation.size);
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+	return elapsed.count();
+}
+
+static void run_warm_up(emma::BaseAllocator& allocator, const Workload& workload,
+std::vector<void*>& slots, void* memory, BenchResult& result)
+{/* Same as run_timed(), but counts the failures & measures the footprint */
+
+	uint8_t* start = static_cast<uint8_t*>(memory);
+	for (const BenchOperation& operation : workload.operations)
+	{
+		if (operation.size == 0)
+		{
+			allocator.free_raw_ptr(slots[operation.slot]);
+			slots[operation.slot] = NULL;
+			continue;
+		}
+		uint8_t* ptr = static_cast<uint8_t*>(allocator.allocate_raw_ptr(operation.size));
+		slots[operation.slot] = ptr;
+		if (ptr == NULL)
+			++result.failures;
+		else if (ptr >= start && ptr < start + BENCH_HEAP_SIZE)
+			result.peak_footprint = std::max(result.peak_footprint,
+				static_cast<std::size_t>(ptr + operation.size - start));
+	}
+}
+
+static BenchResult run_workload(const Workload& workload, const std::string& name, void* memory)
+{
+	BenchResult result;
+	result.workload = workload.name;
+	result.allocator = name;
+	result.operations = workload.operations.size();
+	result.failures = 0;
+	result.peak_footprint = 0;
+
+	std::vector<double> times;
+	for (int run = 0; run <= BENCH_REPEATS; ++run)
+	{
+		BenchHeap heap;
+		make_heap(heap, name, memory, workload.max_size);
+		std::vector<void*> slots(workload.slot_count, NULL);
+
+		if (run == 0)
+			run_warm_up(*heap.allocator, workload, slots, memory, result);
+		else
+			times.push_back(run_timed(*heap.allocator, workload, slots));
+
+		for (void* ptr : slots) // Failed allocations left NULLs, which are skipped
+			heap.allocator->free_raw_ptr(ptr);
+		std::fill(slots.begin(), slots.end(), static_cast<void*>(NULL));
+	}
+
+	std::sort(times.begin(), times.end());
+	result.median_ns_per_op = times[times.size() / 2] / static_cast<double>(result.operations);
+	result.best_ns_per_op = times[0] / static_cast<double>(result.operations);
+	return result;
+}
+
+
+/* [ OUTPUT ] */
+
+static BenchRow to_row(const BenchResult& result)
+{
+	return BenchRow{
+		bench_text("workload", result.workload),
+		bench_text("allocator", result.allocator),
+		bench_number("operations", "%zu", result.operations),
+		bench_number("median_ns_per_op", "%.2f", result.median_ns_per_op),
+		bench_number("best_ns_per_op", "%.2f", result.best_ns_per_op),
+		bench_number("ops_per_second", "%.0f", 1e9 / result.median_ns_per_op),
+		bench_number("failures", "%zu", result.failures),
+		bench_null_if_zero("peak_footprint", result.peak_footprint) };
+}
+
+int main(int argc, char** argv)
+{
+	std::string output = argc >= 2 ? argv[1] : "bench_results";
+
+	void* memory = mmap(NULL, BENCH_HEAP_SIZE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		std::fprintf(stderr, "%s: can't reserve %zu bytes for the heap\n", argv[0], BENCH_HEAP_SIZE);
+		return 1;
+	}
+
+	Workload (*const workload_makers[])() = {
+		make_random_sizes, make_producer_consumer, make_fragmentation, make_larson };
+
+	std::vector<BenchResult> results;
+	for (Workload (*make_workload)() : workload_makers)
+	{
+		Workload workload = make_workload();
+		if (argc >= 3 && std::strcmp(argv[2], workload.name) != 0)
+			continue;
+
+		std::printf("%s: %zu operations, sizes up to %zu bytes\n",
+			workload.name, workload.operations.size(), workload.max_size);
+		std::printf("  %-15s %12s %10s %10s %9s %16s\n", "allocator", "ops/sec",
+			"median ns", "best ns", "failures", "peak footprint");
+		for (const char* name : g_allocator_names)
+		{
+			BenchResult result = run_workload(workload, name, memory);
+			std::printf("  %-15s %12.0f %10.2f %10.2f %9zu %16zu\n", name, 1e9 / result.median_ns_per_op,
+				result.median_ns_per_op, result.best_ns_per_op, result.failures, result.peak_footprint);
+			results.push_back(result);
+		}
+		std::printf("\n");
+	}
+	munmap(memory, BENCH_HEAP_SIZE);
+
+	std::vector<BenchRow> rows;
+	for (const BenchResult& result : results)
+		rows.push_back(to_row(result));
+	BenchRow header{ bench_number("repeats", "%d", BENCH_REPEATS) };
+	if (!write_json(output + ".json", header, rows) || !write_csv(output + ".csv", rows))
+	{
+		std::fprintf(stderr, "%s: can't write the results to %s.json/.csv\n", argv[0], output.c_str());
+		return 1;
+	}
+	std::printf("Results written to %s.json & %s.csv\n", output.c_str(), output.c_str());
+	return 0;
+}
@@ -0,0 +1,390 @@
+/* [ THREAD SCALING BENCHMARK ]
+ *
+ *   Runs the same workload on 1 to N threads at once, to see how well the
+ *   allocators scale with the thread count. Built & run by 'make bench_threads'.
+ *
+ *   ./build/emma_bench_threads [max threads] [output path without extension] [setup]
+ *
+ *   The max is the amount of hardware threads by default. The thread counts
+ *   are the powers of two below it, and the max itself.
+ *
+ *   Setups:
+ *     freelist         A FreeList per thread. The FreeList's are next to each
+ *                      other in one array, so they may share cache lines.
+ *     freelist_padded  Same, but every FreeList has cache lines of it's own
+ *     tlsf             A TLSF per thread, next to each other like freelist
+ *     sharedfreelist   Every thread shares one SharedFreeList
+ *     threadcache      A ThreadCache per thread, over one SharedFreeList
+ *     pool             Every thread shares one Pool, which is lock-free
+ *     malloc           glibc's malloc, for the baseline
+ *
+ *   Per thread heaps are slices of one region, next to each other.
+ *   Shared heaps are as large as all of the slices together.
+ *
+ *   Every thread runs it's own Larson-style list of operations, made from
+ *   it's own seed before the threads start. Each allocation is written over
+ *   as a whole, so that memory bandwidth is part of the result. The threads
+ *   wait for each other before starting, & each one times itself.
+ *
+ *   Threads are pinned to a CPU each, in order, so that where the memory ends
+ *   up is the same from run to run. A heap is first touched by the thread
+ *   that uses it, which matters on machines with more than one NUMA node.
+ *
+ *   Reported, for every setup & thread count:
+ *     ops/sec             Operations of all threads, over the slowest thread's time
+ *     ops/sec per thread  Average of what every thread did on it's own
+ *     efficiency          ops/sec compared to 1 thread times the thread count.
+ *                         1.0 scales perfectly, 1/threads doesn't scale at all.
+ *
+ *   Every thread count runs BENCH_REPEATS times, the median ops/sec is kept.
+ *   Results are also written as JSON & CSV, like 'make bench'.
+ *
+ *   A new concurrent allocator is benchmarked by adding a setup for it to
+ *   g_setups & make_heaps(). Linux only, because of mmap & the pinning.
+*/
+
+#include <EMMA.hpp>
+#include "bench_common.hpp"
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#define BENCH_REPEATS 3
+#define BENCH_OPERATIONS 1000000 // Per thread
+#define BENCH_SLOTS 1000 // Allocations live at once per thread
+#define BENCH_MAX_SIZE 1000 // Allocations are 8 bytes to this
+#define BENCH_SLICE_SIZE (std::size_t(1) << 24) // Memory per thread
+#define BENCH_CACHE_LINE 128 // Two lines, some CPUs fetch them in pairs
+
+class BenchSetup
+{
+	public:
+		const char*	name;
+		bool		shared; // One heap for every thread
+};
+
+static const BenchSetup	g_setups[] = {
+	{ "freelist", false }, { "freelist_padded", false }, { "tlsf", false },
+	{ "sharedfreelist", true }, { "threadcache", true }, { "pool", true }, { "malloc", true } };
+
+/* [ HEAPS ] */
+
+class BenchHeaps
+{/* Per thread allocators are made into one array, 'stride' bytes apart,
+    so that the layout is up to the setup. Shared ones are only made once. */
+
+	public:
+		BenchHeaps() : storage(NULL), stride(0), count(0) {}
+		~BenchHeaps()
+		{
+			for (std::size_t i = 0; i < count; ++i)
+				get(i)->~BaseAllocator();
+			std::free(storage);
+		}
+
+		uint8_t*	storage;
+		std::size_t	stride;
+		std::size_t	count;
+		std::unique_ptr<emma::allocators::SharedFreeList>	shared_heap; // Under the ThreadCache's
+		std::unique_ptr<emma::BaseAllocator>				shared;
+
+		emma::BaseAllocator*	get(std::size_t index)
+		{
+			return reinterpret_cast<emma::BaseAllocator*>(storage + index * stride);
+		}
+};
+
+static void make_per_thread(BenchHeaps& heaps, std::size_t stride, unsigned int thread_count)
+{/* The allocators are only constructed in the threads, so that they first
+    touch their own memory. Here the array is only reserved. */
+
+	heaps.stride = stride;
+	heaps.storage = static_cast<uint8_t*>(std::aligned_alloc(BENCH_CACHE_LINE,
+		(thread_count * stride + BENCH_CACHE_LINE - 1) / BENCH_CACHE_LINE * BENCH_CACHE_LINE));
+}
+
+static void make_heaps(BenchHeaps& heaps, const std::string& name, void* memory, unsigned int thread_count)
+{
+	std::size_t shared_size = BENCH_SLICE_SIZE * thread_count;
+
+	if (name == "freelist")
+		make_per_thread(heaps, sizeof(emma::allocators::FreeList), thread_count);
+	else if (name == "freelist_padded")
+		make_per_thread(heaps, (sizeof(emma::allocators::FreeList) + BENCH_CACHE_LINE - 1)
+			/ BENCH_CACHE_LINE * BENCH_CACHE_LINE, thread_count);
+	else if (name == "tlsf")
+		make_per_thread(heaps, sizeof(emma::allocators::TLSF), thread_count);
+	else if (name == "sharedfreelist")
+		heaps.shared.reset(new emma::allocators::SharedFreeList(memory, shared_size));
+	else if (name == "threadcache")
+		heaps.shared_heap.reset(new emma::allocators::SharedFreeList(memory, shared_size));
+	else if (name == "pool")
+		heaps.shared.reset(new emma::allocators::Pool(memory, shared_size, BENCH_MAX_SIZE));
+	else
+		heaps.shared.reset(new MallocAllocator());
+}
+
+static emma::BaseAllocator* make_thread_heap(BenchHeaps& heaps, const std::string& name,
+void* memory, unsigned int thread_index)
+{/* Constructs the allocator of a per thread setup, in the thread itself */
+
+	void* slice = static_cast<uint8_t*>(memory) + thread_index * BENCH_SLICE_SIZE;
+	void* placement = heaps.storage + thread_index * heaps.stride;
+
+	if (name == "tlsf")
+		return new(placement) emma::allocators::TLSF(slice, BENCH_SLICE_SIZE);
+	return new(placement) emma::allocators::FreeList(slice, BENCH_SLICE_SIZE);
+}
+
+
+/* [ RUNNING ] */
+
+static std::vector<BenchOperation> make_operations(unsigned int seed)
+{/* Every slot is filled, then each round frees a random slot & fills it again */
+
+	std::vector<BenchOperation> operations;
+	std::mt19937 rng(seed);
+
+	for (uint32_t slot = 0; slot < BENCH_SLOTS; ++slot)
+		operations.push_back(BenchOperation{slot, 8 + static_cast<uint32_t>(rng() % (BENCH_MAX_SIZE - 7))});
+	while (operations.size() < BENCH_OPERATIONS)
+	{
+		uint32_t slot = static_cast<uint32_t>(rng() % BENCH_SLOTS);
+		operations.push_back(BenchOperation{slot, 0});
+		operations.push_back(BenchOperation{slot, 8 + static_cast<uint32_t>(rng() % (BENCH_MAX_SIZE - 7))});
+	}
+	return operations;
+}
+
+class BenchThread
+{
+	public:
+		const std::vector<BenchOperation>*	operations;
+		unsigned int	index;
+		double			seconds;
+		std::size_t		failures;
+};
+
+class BenchRun // Shared by every thread of one run
+{
+	public:
+		BenchRun(BenchHeaps& bench_heaps, const std::string& setup_name, void* bench_memory, unsigned int threads) :
+		heaps(bench_heaps), name(setup_name), memory(bench_memory), thread_count(threads), ready(0) {}
+
+		BenchHeaps&			heaps;
+		const std::string&	name;
+		void*				memory;
+		unsigned int		thread_count;
+		std::atomic<unsigned int>	ready;
+};
+
+static void pin_to_cpu(unsigned int index)
+{/* Best effort, the benchmark still runs if it isn't allowed */
+
+	unsigned int cpu_count = std::max(std::thread::hardware_concurrency(), 1u);
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(index % cpu_count, &cpus);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+static void bench_thread(BenchRun* run, BenchThread* thread)
+{
+	pin_to_cpu(thread->index);
+
+	std::unique_ptr<emma::allocators::ThreadCache> cache;
+	emma::BaseAllocator* allocator = run->heaps.shared.get();
+	if (run->heaps.shared_heap != NULL)
+	{
+		cache.reset(new emma::allocators::ThreadCache(*run->heaps.shared_heap));
+		allocator = cache.get();
+	}
+	else if (allocator == NULL)
+		allocator = make_thread_heap(run->heaps, run->name, run->memory, thread->index);
+
+	std::vector<uint8_t*> slots(BENCH_SLOTS, NULL);
+	std::size_t failures = 0;
+
+	run->ready.fetch_add(1);
+	while (run->ready.load() < run->thread_count)
+		std::this_thread::yield();
+
+	auto begin = std::chrono::steady_clock::now();
+	for (const BenchOperation& operation : *thread->operations)
+	{
+		if (operation.size == 0)
+		{
+			allocator->free_raw_ptr(slots[operation.slot]);
+			slots[operation.slot] = NULL;
+			continue;
+		}
+		uint8_t* ptr = static_cast<uint8_t*>(allocator->allocate_raw_ptr(operation.size));
+		slots[operation.slot] = ptr;
+		if (ptr == NULL)
+			++failures;
+		else
+			std::memset(ptr, static_cast<int>(operation.slot), operation.size);
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+	for (uint8_t* ptr : slots)
+		allocator->free_raw_ptr(ptr);
+	thread->seconds = elapsed.count();
+	thread->failures = failures;
+}
+
+class BenchResult
+{
+	public:
+		std::string		setup;
+		unsigned int	threads;
+		double			ops_per_second;
+		double			ops_per_second_per_thread;
+		double			efficiency;
+		std::size_t		failures;
+};
+
+static BenchResult run_setup(const BenchSetup& setup, unsigned int thread_count,
+const std::vector<std::vector<BenchOperation>>& operations, void* memory)
+{
+	BenchResult result;
+	result.setup = setup.name;
+	result.threads = thread_count;
+	result.failures = 0;
+
+	std::vector<std::pair<double, double>> runs; // Total & per thread ops/sec
+	for (int repeat = 0; repeat < BENCH_REPEATS; ++repeat)
+	{
+		BenchHeaps heaps;
+		make_heaps(heaps, setup.name, memory, thread_count);
+		std::string name = setup.name;
+		BenchRun run(heaps, name, memory, thread_count);
+
+		std::vector<BenchThread> bench_threads(thread_count);
+		std::vector<std::thread> threads;
+		for (unsigned int i = 0; i < thread_count; ++i)
+		{
+			bench_threads[i] = BenchThread{&operations[i], i, 0.0, 0};
+			threads.emplace_back(bench_thread, &run, &bench_threads[i]);
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		if (!setup.shared)
+			heaps.count = thread_count; // Every thread made it's allocator
+
+		double slowest = 0.0, per_thread = 0.0;
+		std::size_t total_operations = 0;
+		for (const BenchThread& thread : bench_threads)
+		{
+			slowest = std::max(slowest, thread.seconds);
+			per_thread += static_cast<double>(thread.operations->size()) / std::max(thread.seconds, 1e-9);
+			total_operations += thread.operations->size();
+			result.failures += thread.failures;
+		}
+		runs.push_back(std::make_pair(static_cast<double>(total_operations) / std::max(slowest, 1e-9),
+			per_thread / thread_count));
+	}
+
+	std::sort(runs.begin(), runs.end());
+	result.ops_per_second = runs[runs.size() / 2].first;
+	result.ops_per_second_per_thread = runs[runs.size() / 2].second;
+	result.efficiency = 1.0;
+	return result;
+}
+
+
+/* [ OUTPUT ] */
+
+static BenchRow to_row(const BenchResult& result)
+{
+	return BenchRow{
+		bench_text("setup", result.setup),
+		bench_number("threads", "%u", result.threads),
+		bench_number("ops_per_second", "%.0f", result.ops_per_second),
+		bench_number("ops_per_second_per_thread", "%.0f", result.ops_per_second_per_thread),
+		bench_number("efficiency", "%.3f", result.efficiency),
+		bench_number("failures", "%zu", result.failures) };
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	if (argc >= 2)
+		max_threads = static_cast<unsigned int>(std::strtoul(argv[1], NULL, 10));
+	std::string output = argc >= 3 ? argv[2] : "bench_threads_results";
+	if (max_threads == 0 || max_threads > 1024)
+	{
+		std::fprintf(stderr, "Usage: %s [max threads, 1-1024] [output path] [setup]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<unsigned int> thread_counts;
+	for (unsigned int count = 1; count < max_threads; count *= 2)
+		thread_counts.push_back(count);
+	thread_counts.push_back(max_threads);
+
+	std::size_t memory_size = BENCH_SLICE_SIZE * max_threads;
+	void* memory = mmap(NULL, memory_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		std::fprintf(stderr, "%s: can't reserve %zu bytes for the heaps\n", argv[0], memory_size);
+		return 1;
+	}
+
+	std::vector<std::vector<BenchOperation>> operations;
+	for (unsigned int i = 0; i < max_threads; ++i)
+		operations.push_back(make_operations(i + 1));
+
+	std::printf("%u operations per thread, up to %u threads, %u hardware threads\n\n",
+		BENCH_OPERATIONS, max_threads, std::thread::hardware_concurrency());
+
+	std::vector<BenchResult> results;
+	for (const BenchSetup& setup : g_setups)
+	{
+		if (argc >= 4 && std::strcmp(argv[3], setup.name) != 0)
+			continue;
+
+		std::printf("%s:\n  %7s %14s %20s %10s %9s\n", setup.name, "threads", "ops/sec",
+			"ops/sec per thread", "efficiency", "failures");
+		double single_thread = 0.0;
+		for (unsigned int thread_count : thread_counts)
+		{
+			BenchResult result = run_setup(setup, thread_count, operations, memory);
+			if (thread_count == 1)
+				single_thread = result.ops_per_second;
+			result.efficiency = result.ops_per_second / (single_thread * thread_count);
+
+			std::printf("  %7u %14.0f %20.0f %10.3f %9zu\n", thread_count, result.ops_per_second,
+				result.ops_per_second_per_thread, result.efficiency, result.failures);
+			results.push_back(result);
+		}
+		std::printf("\n");
+	}
+	munmap(memory, memory_size);
+
+	std::vector<BenchRow> rows;
+	for (const BenchResult& result : results)
+		rows.push_back(to_row(result));
+	BenchRow header{ bench_number("hardware_threads", "%u", std::thread::hardware_concurrency()),
+		bench_number("repeats", "%d", BENCH_REPEATS) };
+	if (!write_json(output + ".json", header, rows) || !write_csv(output + ".csv", rows))
+	{
+		std::fprintf(stderr, "%s: can't write the results to %s.json/.csv\n", argv[0], output.c_str());
+		return 1;
+	}
+	std::printf("Results written to %s.json & %s.csv\n", output.c_str(), output.c_str());
+	return 0;
+}
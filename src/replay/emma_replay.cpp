@@ -0,0 +1,276 @@
+/* [ TRACE REPLAY TOOL ]
+ *
+ *   Replays a trace recorded by emma::TraceRecorder against the allocators,
+ *   so that they can be compared on a real workload instead of a toy loop.
+ *   Built into build/emma_replay by 'make emma_replay'.
+ *
+ *   ./build/emma_replay <trace file> [allocator] [heap size]
+ *
+ *   The allocator is freelist, slab, sharedfreelist, buddy, tlsf or arena,
+ *   and every one of them if it isn't given. The heap size is in bytes, by
+ *   default 4 times the most bytes that were ever live in the trace.
+ *
+ *   Each allocator replays the trace twice, from a fresh heap each time.
+ *   The first run is timed as a whole, for the throughput. The second times
+ *   every call on it's own, for the latency percentiles & the footprint.
+ *   The timer is read twice per call there, which is included in the latency.
+ *
+ *   Linux only, the heap is reserved with mmap so that untouched pages are free.
+*/
+
+#include <EMMA.hpp>
+#include <sys/mman.h>
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <iterator>
+
+static const char*	g_allocator_names[] = { "freelist", "slab", "sharedfreelist", "buddy", "tlsf", "arena" };
+
+class ReplayStep // One record, with the allocation's address swapped to a slot
+{
+	public:
+		std::size_t	size; // 0 for frees
+		std::size_t	alignment;
+		std::size_t	slot; // Index of the live allocation
+};
+
+class ReplayTrace
+{
+	public:
+		ReplayTrace() : slot_count(0), allocations(0), frees(0), skipped(0), peak_live_bytes(0) {}
+
+		std::vector<ReplayStep>	steps;
+		std::size_t	slot_count; // Most allocations that were ever live at once
+		std::size_t	allocations;
+		std::size_t	frees;
+		std::size_t	skipped; // Failed allocations & frees of unknown allocations
+		std::size_t	peak_live_bytes;
+};
+
+class ReplayResult
+{
+	public:
+		double		ops_per_second;
+		uint64_t	latency_percentiles[5]; // 50, 90, 99, 99.9 & 100 (max)
+		std::size_t	peak_footprint; // From the start of the heap to the last byte used
+		std::size_t	failures;
+};
+
+static bool load_trace(const char* path, ReplayTrace& trace)
+{/* Reads the records & gives each live allocation a slot, so that the replay
+    doesn't have to look the addresses up. Slots of freed allocations are reused. */
+
+	std::FILE* file = std::fopen(path, "rb");
+	if (file == NULL)
+		return false;
+
+	char magic[sizeof(emma::TRACE_MAGIC)];
+	if (std::fread(magic, sizeof(magic), 1, file) != 1
+		|| std::memcmp(magic, emma::TRACE_MAGIC, sizeof(magic)) != 0)
+	{
+		std::fclose(file);
+		return false;
+	}
+
+	std::unordered_map<uint64_t, std::pair<std::size_t, std::size_t>> live; // Id -> slot & size
+	std::vector<std::size_t> free_slots;
+	std::size_t live_bytes = 0;
+
+	emma::TraceRecord record;
+	while (std::fread(&record, sizeof(record), 1, file) == 1)
+	{
+		if (record.get_operation() == emma::TraceRecord::ALLOCATE && record.id != 0)
+		{
+			std::size_t slot = trace.slot_count;
+			if (!free_slots.empty())
+			{
+				slot = free_slots.back();
+				free_slots.pop_back();
+			}
+			else
+				++trace.slot_count;
+
+			live[record.id] = std::make_pair(slot, record.get_size());
+			live_bytes += record.get_size();
+			trace.peak_live_bytes = std::max(trace.peak_live_bytes, live_bytes);
+			trace.steps.push_back(ReplayStep{record.get_size(), record.get_alignment(), slot});
+			++trace.allocations;
+			continue;
+		}
+
+		auto found = live.find(record.id);
+		if (record.get_operation() != emma::TraceRecord::FREE || found == live.end())
+		{
+			++trace.skipped;
+			continue;
+		}
+		trace.steps.push_back(ReplayStep{0, 1, found->second.first});
+		free_slots.push_back(found->second.first);
+		live_bytes -= found->second.second;
+		live.erase(found);
+		++trace.frees;
+	}
+	std::fclose(file);
+	return true;
+}
+
+static std::unique_ptr<emma::BaseAllocator> make_allocator(const std::string& name, void* memory, std::size_t size)
+{
+	if (name == "freelist")
+		return std::unique_ptr<emma::BaseAllocator>(new emma::allocators::FreeList(memory, size));
+	if (name == "slab")
+		return std::unique_ptr<emma::BaseAllocator>(new emma::allocators::Slab(memory, size));
+	if (name == "sharedfreelist")
+		return std::unique_ptr<emma::BaseAllocator>(new emma::allocators::SharedFreeList(memory, size));
+	if (name == "buddy")
+		return std::unique_ptr<emma::BaseAllocator>(new emma::allocators::Buddy(memory, size));
+	if (name == "tlsf")
+		return std::unique_ptr<emma::BaseAllocator>(new emma::allocators::TLSF(memory, size));
+	if (name == "arena")
+		return std::unique_ptr<emma::BaseAllocator>(new emma::allocators::Arena(memory, size));
+	return NULL;
+}
+
+static void replay_untimed_steps(emma::BaseAllocator& allocator, std::vector<void*>& slots,
+const std::vector<ReplayStep>& steps)
+{
+	for (const ReplayStep& step : steps)
+	{
+		if (step.size == 0)
+		{
+			allocator.free_raw_ptr(slots[step.slot]);
+			slots[step.slot] = NULL;
+		}
+		else
+			slots[step.slot] = allocator.allocate_raw_ptr(step.size, step.alignment);
+	}
+}
+
+static bool replay(const std::string& name, const ReplayTrace& trace, std::size_t heap_size, ReplayResult& result)
+{/* Replays the trace twice, see the top of the file. Returns false if the
+    allocator can't be made */
+
+	void* memory = mmap(NULL, heap_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (memory == MAP_FAILED)
+		return false;
+
+	std::vector<void*> slots(trace.slot_count, NULL);
+	{
+		std::unique_ptr<emma::BaseAllocator> allocator = make_allocator(name, memory, heap_size);
+		if (allocator == NULL)
+		{
+			munmap(memory, heap_size);
+			return false;
+		}
+
+		auto begin = std::chrono::steady_clock::now();
+		replay_untimed_steps(*allocator, slots, trace.steps);
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - begin;
+		result.ops_per_second = static_cast<double>(trace.steps.size()) / std::max(seconds.count(), 1e-9);
+	}
+
+	std::fill(slots.begin(), slots.end(), static_cast<void*>(NULL));
+	std::vector<uint64_t> latencies(trace.steps.size());
+	result.peak_footprint = 0;
+	result.failures = 0;
+	{
+		std::unique_ptr<emma::BaseAllocator> allocator = make_allocator(name, memory, heap_size);
+		uint8_t* start = static_cast<uint8_t*>(memory);
+
+		for (std::size_t i = 0; i < trace.steps.size(); ++i)
+		{
+			const ReplayStep& step = trace.steps[i];
+			void* ptr = NULL;
+
+			auto begin = std::chrono::steady_clock::now();
+			if (step.size == 0)
+				allocator->free_raw_ptr(slots[step.slot]);
+			else
+				ptr = allocator->allocate_raw_ptr(step.size, step.alignment);
+			auto end = std::chrono::steady_clock::now();
+			latencies[i] = static_cast<uint64_t>(\
+				std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+
+			slots[step.slot] = ptr;
+			if (step.size != 0 && ptr == NULL)
+				++result.failures;
+			else if (ptr != NULL)
+				result.peak_footprint = std::max(result.peak_footprint,\
+					static_cast<std::size_t>(static_cast<uint8_t*>(ptr) + step.size - start));
+		}
+	}
+	munmap(memory, heap_size);
+
+	std::sort(latencies.begin(), latencies.end());
+	const double percentiles[5] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+	for (int i = 0; i < 5; ++i)
+	{
+		std::size_t index = static_cast<std::size_t>(percentiles[i] * static_cast<double>(latencies.size()));
+		result.latency_percentiles[i] = latencies.empty() ? 0 : latencies[std::min(index, latencies.size() - 1)];
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2 || argc > 4)
+	{
+		std::fprintf(stderr, "Usage: %s <trace file> [allocator] [heap size]\n", argv[0]);
+		std::fprintf(stderr, "Allocators: freelist, slab, sharedfreelist, buddy, tlsf, arena. All by default\n");
+		return 1;
+	}
+
+	if (argc >= 3 && std::find_if(std::begin(g_allocator_names), std::end(g_allocator_names),
+		[&](const char* name) { return std::strcmp(argv[2], name) == 0; }) == std::end(g_allocator_names))
+	{
+		std::fprintf(stderr, "%s: unknown allocator %s\n", argv[0], argv[2]);
+		return 1;
+	}
+
+	ReplayTrace trace;
+	if (!load_trace(argv[1], trace))
+	{
+		std::fprintf(stderr, "%s: can't read a trace from %s\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	std::size_t heap_size = std::max(trace.peak_live_bytes * 4, std::size_t(1) << 20);
+	if (argc == 4)
+		heap_size = static_cast<std::size_t>(std::strtoull(argv[3], NULL, 10));
+
+	std::printf("%s: %zu allocations, %zu frees, %zu records skipped, peak of %zu bytes live\n",
+		argv[1], trace.allocations, trace.frees, trace.skipped, trace.peak_live_bytes);
+	std::printf("Heap of %zu bytes, latencies in nanoseconds\n\n", heap_size);
+	std::printf("%-15s %14s %8s %8s %8s %8s %10s %16s %9s\n", "allocator", "ops/sec",
+		"p50", "p90", "p99", "p99.9", "max", "peak footprint", "failures");
+
+	for (const char* name : g_allocator_names)
+	{
+		if (argc >= 3 && std::strcmp(argv[2], name) != 0)
+			continue;
+
+		ReplayResult result;
+		if (!replay(name, trace, heap_size, result))
+		{
+			std::fprintf(stderr, "%s: can't make a %s heap of %zu bytes\n", argv[0], name, heap_size);
+			return 1;
+		}
+		std::printf("%-15s %14.0f %8lu %8lu %8lu %8lu %10lu %16zu %9zu\n", name, result.ops_per_second,
+			static_cast<unsigned long>(result.latency_percentiles[0]),
+			static_cast<unsigned long>(result.latency_percentiles[1]),
+			static_cast<unsigned long>(result.latency_percentiles[2]),
+			static_cast<unsigned long>(result.latency_percentiles[3]),
+			static_cast<unsigned long>(result.latency_percentiles[4]),
+			result.peak_footprint, result.failures);
+	}
+	return 0;
+}
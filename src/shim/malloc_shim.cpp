@@ -0,0 +1,381 @@
+/* [ MALLOC SHIM FILE ]
+ *
+ * Replaces the C allocation functions & the global operator new/delete of a
+ * whole program, without changing it's code. Built into build/libEMMA.so
+ * by 'make shared', and loaded in front of the C library with:
+ *
+ *   LD_PRELOAD=/path/to/libEMMA.so ./any_program
+ *
+ * Every allocation comes from one allocator (FreeList by default), over one
+ * large region reserved with mmap the first time anything is allocated.
+ * The region is only reserved, pages are backed by the system when touched,
+ * so RSS only grows with what the program actually uses.
+ *
+ * The allocators aren't thread safe, so every call takes the same lock.
+ * The lock is also held across fork(), so that the child gets a usable heap.
+ *
+ * Can be customized at compile time with -D:
+ *   EMMA_SHIM_ALLOCATOR   Any allocator constructed with (memory, size).
+ *                         FreeList, Slab, TLSF or Buddy.
+ *   EMMA_SHIM_HEAP_SIZE   Bytes reserved for the heap.
+ *
+ * The size can also be given at run time, in bytes, with the environment
+ * variable EMMA_SHIM_HEAP_SIZE.
+ *
+ * If the environment variable EMMA_SHIM_TRACE is set to a path, every
+ * allocation & free is also recorded into a trace file there, which can be
+ * replayed with 'make emma_replay'. See TraceRecorder.hpp. Only the process
+ * which was started with it is traced, not the processes it forks or runs.
+ *
+ * Linux only, as mmap, pthread_atfork & LD_PRELOAD are.
+ *
+ */
+
+#include <EMMA.hpp>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <new>
+
+#ifndef EMMA_SHIM_ALLOCATOR
+# define EMMA_SHIM_ALLOCATOR emma::allocators::FreeList
+#endif
+
+#ifndef EMMA_SHIM_HEAP_SIZE
+# define EMMA_SHIM_HEAP_SIZE (std::size_t(16) << 30)
+#endif
+
+typedef emma::Allocator<EMMA_SHIM_ALLOCATOR>	ShimHeap;
+
+// What malloc() promises, enough for any type
+static constexpr std::size_t	DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+// Never destroyed, so that frees from other destructors at exit still work
+alignas(ShimHeap) static unsigned char	g_heap_storage[sizeof(ShimHeap)];
+static ShimHeap*		g_heap = NULL;
+static uint8_t*			g_heap_start = NULL;
+static uint8_t*			g_heap_end = NULL;
+static pthread_mutex_t	g_heap_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Only made if EMMA_SHIM_TRACE is set. Records, then calls the heap.
+alignas(emma::TraceRecorder) static unsigned char	g_trace_storage[sizeof(emma::TraceRecorder)];
+static emma::TraceRecorder*	g_trace = NULL;
+
+class ShimLock // Holds the lock for it's lifetime
+{
+	public:
+		ShimLock() { pthread_mutex_lock(&g_heap_mutex); }
+		~ShimLock() { pthread_mutex_unlock(&g_heap_mutex); }
+};
+
+static void lock_before_fork() { pthread_mutex_lock(&g_heap_mutex); }
+static void unlock_after_fork() { pthread_mutex_unlock(&g_heap_mutex); }
+
+static void unlock_in_child()
+{/* The child would write into the same file as the parent, so it stops.
+    It's records which weren't written yet are simply dropped. */
+
+	g_trace = NULL;
+	pthread_mutex_unlock(&g_heap_mutex);
+}
+
+__attribute__((constructor))
+static void register_fork_handlers()
+{/* Runs when the library is loaded, outside of any allocation */
+
+	pthread_atfork(lock_before_fork, unlock_after_fork, unlock_in_child);
+}
+
+static std::size_t get_heap_size()
+{/* Size from the environment if it's there & valid, the default otherwise */
+
+	const char* size_from_env = getenv("EMMA_SHIM_HEAP_SIZE");
+	if (size_from_env != NULL)
+	{
+		char* end = NULL;
+		unsigned long long size = strtoull(size_from_env, &end, 10);
+		if (end != size_from_env && *end == '\0' && size > 0)
+			return static_cast<std::size_t>(size);
+	}
+	return EMMA_SHIM_HEAP_SIZE;
+}
+
+static ShimHeap* get_heap()
+{/* Returns the heap, which is made on the first call. The lock must be held.
+    Returns NULL if the region can't be reserved. */
+
+	if (g_heap != NULL)
+		return g_heap;
+
+	std::size_t size = get_heap_size();
+	void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (memory == MAP_FAILED)
+		return NULL;
+
+	g_heap_start = static_cast<uint8_t*>(memory);
+	g_heap_end = g_heap_start + size;
+	g_heap = new(static_cast<void*>(g_heap_storage)) ShimHeap(memory, size);
+	return g_heap;
+}
+
+__attribute__((constructor))
+static void start_tracing()
+{/* Runs when the library is loaded, if EMMA_SHIM_TRACE is set.
+    Allocations made before this, by other libraries, aren't recorded. */
+
+	const char* path = getenv("EMMA_SHIM_TRACE");
+	if (path == NULL)
+		return;
+
+	// Allocates from the heap itself, so the lock can't be held yet.
+	// Unbuffered, so that writing never allocates. The recorder buffers instead.
+	std::FILE* file = std::fopen(path, "wb");
+	if (file == NULL)
+		return;
+	std::setvbuf(file, NULL, _IONBF, 0);
+
+	// Programs started by this one would open the same file again, & overwrite it
+	unsetenv("EMMA_SHIM_TRACE");
+
+	ShimLock lock;
+	ShimHeap* heap = get_heap();
+	if (heap != NULL)
+		g_trace = new(static_cast<void*>(g_trace_storage)) emma::TraceRecorder(heap->get_policy(), file);
+}
+
+__attribute__((destructor))
+static void stop_tracing()
+{/* Runs at exit. Frees by destructors that run after this aren't recorded */
+
+	ShimLock lock;
+	if (g_trace != NULL)
+		g_trace->flush();
+	g_trace = NULL;
+}
+
+static inline bool heap_owns(void* ptr)
+{/* Memory from anywhere else can't be freed or resized by us */
+
+	return (static_cast<uint8_t*>(ptr) >= g_heap_start && static_cast<uint8_t*>(ptr) < g_heap_end);
+}
+
+static inline bool alignment_is_invalid(std::size_t alignment)
+{
+	return (alignment == 0 || (alignment & (alignment - 1)) != 0);
+}
+
+static void* shim_allocate(std::size_t size, std::size_t alignment)
+{/* Params    : (1) Size of the allocation, 0 is allowed
+ *              (2) Alignment, must be a power of two
+ *  On success: Returns an aligned pointer, unique even if size is 0
+ *  On failure: Returns NULL & sets errno to ENOMEM
+ *  Fails if  : The heap is out of memory, or couldn't be reserved */
+
+	if (alignment < DEFAULT_ALIGNMENT)
+		alignment = DEFAULT_ALIGNMENT;
+
+	void* ptr = NULL;
+	{
+		ShimLock lock;
+		ShimHeap* heap = get_heap();
+		if (g_trace != NULL)
+			ptr = g_trace->allocate_raw_ptr(size == 0 ? 1 : size, alignment);
+		else if (heap != NULL)
+			ptr = heap->allocate_raw_ptr(size == 0 ? 1 : size, alignment);
+	}
+	if (ptr == NULL)
+		errno = ENOMEM;
+	return ptr;
+}
+
+static void shim_free(void* ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	ShimLock lock;
+	if (heap_owns(ptr) && g_trace != NULL)
+		g_trace->free_raw_ptr(ptr);
+	else if (heap_owns(ptr))
+		g_heap->free_raw_ptr(ptr);
+}
+
+static void* shim_new(std::size_t size, std::size_t alignment)
+{/* Same as shim_allocate(), except that it calls the new handler until
+    it succeeds, and throws std::bad_alloc if there isn't one. */
+
+	for (;;)
+	{
+		void* ptr = shim_allocate(size, alignment);
+		if (ptr != NULL)
+			return ptr;
+
+		std::new_handler handler = std::get_new_handler();
+		if (handler == NULL)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+static void* shim_new_nothrow(std::size_t size, std::size_t alignment) noexcept
+{
+	try
+		{ return shim_new(size, alignment); }
+	catch (...)
+		{ return NULL; }
+}
+
+
+/* [ C FUNCTIONS ] */
+
+extern "C"
+{
+	void* malloc(std::size_t size)
+	{
+		return shim_allocate(size, DEFAULT_ALIGNMENT);
+	}
+
+	void free(void* ptr)
+	{
+		shim_free(ptr);
+	}
+
+	void* calloc(std::size_t count, std::size_t size)
+	{
+		if (size != 0 && count > SIZE_MAX / size)
+		{
+			errno = ENOMEM;
+			return NULL;
+		}
+
+		void* ptr = shim_allocate(count * size, DEFAULT_ALIGNMENT);
+		if (ptr != NULL)
+			std::memset(ptr, 0, count * size);
+		return ptr;
+	}
+
+	void* realloc(void* ptr, std::size_t size)
+	{
+		if (ptr == NULL)
+			return shim_allocate(size, DEFAULT_ALIGNMENT);
+		if (size == 0)
+		{
+			shim_free(ptr);
+			return NULL;
+		}
+
+		void* new_ptr = NULL;
+		{
+			ShimLock lock;
+			if (heap_owns(ptr) && g_trace != NULL)
+				new_ptr = g_trace->reallocate_raw_ptr(ptr, size, DEFAULT_ALIGNMENT);
+			else if (heap_owns(ptr))
+				new_ptr = g_heap->reallocate_raw_ptr(ptr, size, DEFAULT_ALIGNMENT);
+		}
+		if (new_ptr == NULL)
+			errno = ENOMEM; // The old data stays where it was
+		return new_ptr;
+	}
+
+	int posix_memalign(void** out_ptr, std::size_t alignment, std::size_t size)
+	{
+		if (alignment_is_invalid(alignment) || alignment % sizeof(void*) != 0)
+			return EINVAL;
+
+		void* ptr = shim_allocate(size, alignment);
+		if (ptr == NULL)
+			return ENOMEM;
+		*out_ptr = ptr;
+		return 0;
+	}
+
+	void* aligned_alloc(std::size_t alignment, std::size_t size)
+	{
+		if (alignment_is_invalid(alignment))
+		{
+			errno = EINVAL;
+			return NULL;
+		}
+		return shim_allocate(size, alignment);
+	}
+
+	// Obsolete, but still used. Mixing them with the C library's would crash.
+	void* memalign(std::size_t alignment, std::size_t size)
+	{
+		return aligned_alloc(alignment, size);
+	}
+
+	void* valloc(std::size_t size)
+	{
+		return shim_allocate(size, static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+	}
+
+	void* pvalloc(std::size_t size)
+	{
+		std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+		return shim_allocate((size + page_size - 1) / page_size * page_size, page_size);
+	}
+
+	std::size_t malloc_usable_size(void* ptr)
+	{
+		if (ptr == NULL)
+			return 0;
+
+		ShimLock lock;
+		return (heap_owns(ptr) ? g_heap->usable_size(ptr) : 0);
+	}
+}
+
+
+/* [ GLOBAL OPERATOR NEW & DELETE ] */
+
+void* operator new(std::size_t size)
+	{ return shim_new(size, DEFAULT_ALIGNMENT); }
+void* operator new[](std::size_t size)
+	{ return shim_new(size, DEFAULT_ALIGNMENT); }
+void* operator new(std::size_t size, std::align_val_t alignment)
+	{ return shim_new(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment)
+	{ return shim_new(size, static_cast<std::size_t>(alignment)); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+	{ return shim_new_nothrow(size, DEFAULT_ALIGNMENT); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+	{ return shim_new_nothrow(size, DEFAULT_ALIGNMENT); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+	{ return shim_new_nothrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+	{ return shim_new_nothrow(size, static_cast<std::size_t>(alignment)); }
+
+// The size & alignment aren't needed, every allocation knows it's own
+void operator delete(void* ptr) noexcept
+	{ shim_free(ptr); }
+void operator delete[](void* ptr) noexcept
+	{ shim_free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept
+	{ shim_free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept
+	{ shim_free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept
+	{ shim_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept
+	{ shim_free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+	{ shim_free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+	{ shim_free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+	{ shim_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+	{ shim_free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+	{ shim_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+	{ shim_free(ptr); }
@@ -1,42 +1,100 @@
 
 /* [ TESTS OF ALIGNMENT ]
  *   
- *   This is a very simple test that tests if an object is aligned or not.
- *   Very short one.
+ *   Tests that classes are aligned to alignof() of the class,
+ *   and that raw pointers are aligned to whatever alignment was asked for.
+ *   This is done for every allocator that takes any size.
+ *
+ *   Also counts how many large classes fit in the memory, since a class
+ *   shouldn't need more padding than it's alignment.
  *
  *   This file is included directly in the main tester file.
 */
 
 #include <stdint.h>
 
-void alignment_tests()
+class alignas(64) OverAlignedClass
 {
-	emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+	public:
+		OverAlignedClass(int i) : m_number(i) {}
+		~OverAlignedClass() {}
+	private:
+		int		m_number;
+};
 
-	LargeClass* l1 = EMMA.allocate_class<LargeClass>(42);
-	LargeClass* l2 = EMMA.allocate_class<LargeClass>(42);
-	LargeClass* l3 = EMMA.allocate_class<LargeClass>(42);
+static bool is_aligned(void* ptr, std::size_t alignment)
+{
+	return (reinterpret_cast<uintptr_t>(ptr) % alignment == 0);
+}
 
-	assert(l1 != NULL);
-	assert(l2 != NULL);
-	assert(l3 != NULL);
+static void alignment_test_allocator(emma::BaseAllocator& EMMA, const char* name)
+{
+	std::cout << "- " << name << std::endl;
 
-	std::size_t align1 = sizeof(LargeClass) + (reinterpret_cast<uintptr_t>(l1) % sizeof(LargeClass));
-	std::size_t align2 = sizeof(LargeClass) + (reinterpret_cast<uintptr_t>(l2) % sizeof(LargeClass));
-	std::size_t align3 = sizeof(LargeClass) + (reinterpret_cast<uintptr_t>(l3) % sizeof(LargeClass));
+	for (int i = 0; i < 3; ++i)
+	{
+		LargeClass* large = EMMA.allocate_class<LargeClass>(42);
+		SmallClass* small = EMMA.allocate_class<SmallClass>(42);
+		OverAlignedClass* over_aligned = EMMA.allocate_class<OverAlignedClass>(42);
+		assert(large != NULL && small != NULL && over_aligned != NULL);
+		assert(is_aligned(large, alignof(LargeClass)));
+		assert(is_aligned(small, alignof(SmallClass)));
+		assert(is_aligned(over_aligned, alignof(OverAlignedClass)));
+	}
 
-	std::cout << "Allocated 3 classes with a size of: " << sizeof(LargeClass) <<  "\n\n";
-	std::cout << "Class 1 location is   : " << l1 << std::endl;
-	std::cout << "Class 1's alignment is: " << align1 << "\n" << std::endl;
-	assert(align1 == sizeof(LargeClass));
+	for (std::size_t alignment = 1; alignment <= 4096; alignment <<= 1)
+	{
+		void* ptr = EMMA.allocate_raw_ptr(1 + alignment % 77, alignment);
+		assert(ptr != NULL);
+		assert(is_aligned(ptr, alignment));
+		EMMA.free_raw_ptr(ptr);
+	}
+	assert(EMMA.allocate_raw_ptr(8, 3) == NULL);
+	std::cout << "  Classes were aligned to alignof(), raw pointers from 1 to 4096" << std::endl;
+}
 
-	std::cout << "Class 2 location is   : " << l2 << std::endl;
-	std::cout << "Class 2's alignment is: " << align2 << "\n" << std::endl;
-	assert(align2 == sizeof(LargeClass));
+void alignment_tests()
+{
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		std::size_t count = 0;
+		while (EMMA.allocate_class<LargeClass>(42) != NULL)
+			++count;
+		std::cout << "Fit " << count << " classes with a size of " << sizeof(LargeClass)
+		<< " in a " << MEMSIZE << " byte free list\n" << std::endl;
+		assert(count > MEMSIZE / (sizeof(LargeClass) + 2 * sizeof(std::size_t))); // At most two words of overhead
+	}
 
-	std::cout << "Class 3 location is   : " << l3 << std::endl;
-	std::cout << "Class 3's alignment is: " << align3 << "\n" << std::endl;
-	assert(align3 == sizeof(LargeClass));
+	std::cout << "Testing every allocator:" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		alignment_test_allocator(EMMA, "FreeList");
+	}
+	{
+		emma::allocators::Slab	EMMA(g_emmas_memory, MEMSIZE);
+		alignment_test_allocator(EMMA, "Slab");
+	}
+	{
+		emma::allocators::TLSF	EMMA(g_emmas_memory, MEMSIZE);
+		alignment_test_allocator(EMMA, "TLSF");
+	}
+	{
+		emma::allocators::Buddy	EMMA(g_emmas_memory, MEMSIZE);
+		alignment_test_allocator(EMMA, "Buddy");
+	}
+	{
+		emma::allocators::Arena	EMMA(g_emmas_memory, MEMSIZE);
+		alignment_test_allocator(EMMA, "Arena");
+	}
+	{
+		emma::allocators::Stack	EMMA(g_emmas_memory, MEMSIZE);
+		alignment_test_allocator(EMMA, "Stack");
+	}
+	{
+		emma::allocators::SharedFreeList	shared_heap(g_emmas_memory, MEMSIZE);
+		emma::allocators::ThreadCache		EMMA(shared_heap);
+		alignment_test_allocator(EMMA, "ThreadCache");
+	}
 
 	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
 	<< C_GREEN << " - all classes were in alignment \n" << C_END << std::endl;
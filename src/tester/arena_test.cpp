@@ -0,0 +1,103 @@
+/* [ TESTS OF THE ARENA ALLOCATOR ]
+ *
+ *   Allocates until the arena is full, resets it and checks that the memory
+ *   is handed out again from the start.
+ *
+ *   Then checks that reset() destroys registered classes in the reverse
+ *   order of construction, and skips the ones already freed.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <stdint.h>
+
+static std::vector<int> g_arena_destroyed;
+
+class ArenaTracked
+{
+	public:
+		ArenaTracked(int id) : m_id(id) {}
+		~ArenaTracked() { g_arena_destroyed.push_back(m_id); }
+	private:
+		int		m_id;
+		char	payload[20];
+};
+
+class ArenaPlain
+{
+	public:
+		int		a;
+		double	b;
+};
+
+static void arena_test_reset()
+{
+	emma::allocators::Arena	EMMA(g_emmas_memory, 4096);
+
+	std::cout << "1. Allocating until the arena is full" << std::endl;
+	void* first = EMMA.allocate_raw_ptr(sizeof(LargeClass));
+	assert(first != NULL);
+	std::size_t count = 1;
+	void* ptr;
+	while ((ptr = EMMA.allocate_raw_ptr(sizeof(LargeClass))) != NULL)
+	{
+		assert(reinterpret_cast<uintptr_t>(ptr) % alignof(LargeClass) == 0);
+		EMMA.free_raw_ptr(ptr); // Does nothing, the arena should still fill up
+		++count;
+	}
+	assert(count == 4096 / sizeof(LargeClass));
+	std::cout << "-  Fit " << count << " large classes" << std::endl;
+
+	std::cout << "2. Resetting and allocating again" << std::endl;
+	EMMA.reset();
+	assert(EMMA.allocate_raw_ptr(sizeof(LargeClass)) == first);
+
+	char* chr = static_cast<char*>(EMMA.allocate_raw_ptr(1));
+	ArenaPlain* plain = EMMA.allocate_class<ArenaPlain>();
+	void* aligned = EMMA.allocate_raw_ptr(24, 256);
+	assert(chr != NULL && plain != NULL && aligned != NULL);
+	assert(reinterpret_cast<uintptr_t>(plain) % alignof(ArenaPlain) == 0);
+	assert(reinterpret_cast<uintptr_t>(aligned) % 256 == 0);
+	std::cout << "-  Memory was handed out from the start again" << std::endl;
+}
+
+static void arena_test_destructors()
+{
+	g_arena_destroyed.clear();
+	{
+		emma::allocators::Arena	EMMA(g_emmas_memory, 4096);
+
+		std::cout << "3. Registering 5 classes, freeing the 2nd one by hand" << std::endl;
+		ArenaTracked* tracked[5];
+		for (int i = 0; i < 5; ++i)
+		{
+			tracked[i] = EMMA.allocate_class<ArenaTracked>(i);
+			assert(tracked[i] != NULL);
+			assert(reinterpret_cast<uintptr_t>(tracked[i]) % alignof(ArenaTracked) == 0);
+			EMMA.allocate_raw_ptr(1 + i); // Mess up the alignment in between
+		}
+		EMMA.free_class(tracked[1]);
+		assert(g_arena_destroyed.size() == 1 && g_arena_destroyed[0] == 1);
+
+		EMMA.reset();
+		std::vector<int> expected = {1, 4, 3, 2, 0};
+		assert(g_arena_destroyed == expected);
+		std::cout << "-  Destroyed in reverse order on reset" << std::endl;
+
+		std::cout << "4. Destroying the arena itself" << std::endl;
+		g_arena_destroyed.clear();
+		EMMA.allocate_class<ArenaTracked>(7);
+	}
+	assert(g_arena_destroyed.size() == 1 && g_arena_destroyed[0] == 7);
+	std::cout << "-  Registered classes were destroyed with the arena" << std::endl;
+}
+
+void arena_tests()
+{
+	arena_test_reset();
+	arena_test_destructors();
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - reset freed everything and destroyed classes in reverse order\n" << C_END << std::endl;
+}
@@ -0,0 +1,127 @@
+/* [ TESTS OF ARRAYS & ARGUMENT FORWARDING ]
+ *
+ *   Tests that arrays are constructed & destroyed element by element,
+ *   that they keep their size, and that their memory is given back.
+ *   Also tests that allocate_class() forwards it's arguments, so that
+ *   move-only arguments work and nothing gets copied on the way.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <memory>
+#include <utility>
+#include <stdint.h>
+
+class ArrayTestCounter // Counts the constructions & destructions of itself
+{
+	public:
+		ArrayTestCounter(int i) : m_number(i) { ++s_constructed; }
+		ArrayTestCounter(const ArrayTestCounter& other) : m_number(other.m_number) { ++s_copied; }
+		~ArrayTestCounter() { ++s_destroyed; }
+		int getNumber() const { return m_number; }
+
+		static int	s_constructed;
+		static int	s_copied;
+		static int	s_destroyed;
+	private:
+		int		m_number;
+};
+int	ArrayTestCounter::s_constructed = 0;
+int	ArrayTestCounter::s_copied = 0;
+int	ArrayTestCounter::s_destroyed = 0;
+
+class ArrayTestHolder // Only takes it's arguments by reference or by moving them
+{
+	public:
+		ArrayTestHolder(const ArrayTestCounter& counter, std::unique_ptr<int>&& owned) :
+		m_number(counter.getNumber()), m_owned(std::move(owned)) {}
+		~ArrayTestHolder() {}
+		int getNumber() { return m_number + *m_owned; }
+	private:
+		int						m_number;
+		std::unique_ptr<int>	m_owned;
+};
+
+static std::size_t array_test_largest_allocation(emma::BaseAllocator& EMMA)
+{
+	std::size_t low = 1, high = MEMSIZE;
+	while (low < high)
+	{
+		std::size_t middle = (low + high + 1) / 2;
+		void* ptr = EMMA.allocate_raw_ptr(middle);
+		if (ptr != NULL)
+		{
+			EMMA.free_raw_ptr(ptr);
+			low = middle;
+		}
+		else
+			high = middle - 1;
+	}
+	return low;
+}
+
+void array_tests()
+{
+	emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+	std::size_t largest = array_test_largest_allocation(EMMA);
+
+	std::cout << "1. An array of 1000 classes, made from the same argument" << std::endl;
+	ArrayTestCounter* counters = EMMA.allocate_array<ArrayTestCounter>(1000, 42);
+	assert(counters != NULL);
+	assert(emma::BaseAllocator::get_array_size(counters) == 1000);
+	for (int i = 0; i < 1000; ++i)
+		{ assert(counters[i].getNumber() == 42); }
+	assert(ArrayTestCounter::s_constructed == 1000 && ArrayTestCounter::s_copied == 0);
+	EMMA.free_array(counters);
+	assert(ArrayTestCounter::s_destroyed == 1000);
+	assert(array_test_largest_allocation(EMMA) == largest);
+	std::cout << "-  1000 constructed, 1000 destroyed, no copies, memory given back" << std::endl;
+
+	std::cout << "2. Arrays of trivial types" << std::endl;
+	int* zeroes = EMMA.allocate_array<int>(5000);
+	double* halves = EMMA.allocate_array<double>(5000, 0.5);
+	assert(zeroes != NULL && halves != NULL);
+	for (int i = 0; i < 5000; ++i)
+		{ assert(zeroes[i] == 0 && halves[i] == 0.5); }
+	EMMA.free_array(zeroes);
+	EMMA.free_array(halves);
+	assert(EMMA.allocate_array<int>(0) == NULL);
+	assert(EMMA.allocate_array<LargeClass>(SIZE_MAX / 8, 42) == NULL);
+	std::cout << "-  Default constructed to zero, and filled with the argument" << std::endl;
+
+	std::cout << "3. Over-aligned arrays" << std::endl;
+	for (std::size_t count = 1; count < 20; ++count)
+	{
+		OverAlignedClass* array = EMMA.allocate_array<OverAlignedClass>(count, 42);
+		assert(array != NULL && reinterpret_cast<uintptr_t>(array) % alignof(OverAlignedClass) == 0);
+		assert(emma::BaseAllocator::get_array_size(array) == count);
+		EMMA.free_array(array);
+	}
+	assert(array_test_largest_allocation(EMMA) == largest);
+	std::cout << "-  Every element was aligned to " << alignof(OverAlignedClass) << std::endl;
+
+	std::cout << "4. Forwarding arguments to allocate_class()" << std::endl;
+	ArrayTestCounter counter(7);
+	ArrayTestHolder* holder = EMMA.allocate_class<ArrayTestHolder>(counter, std::make_unique<int>(35));
+	assert(holder != NULL && holder->getNumber() == 42);
+	assert(ArrayTestCounter::s_copied == 0);
+	EMMA.free_class(holder);
+	std::cout << "-  A move-only argument was moved in, the other one was never copied" << std::endl;
+
+	std::cout << "5. Arrays in an arena are destroyed by reset()" << std::endl;
+	{
+		emma::allocators::Arena	arena(g_emmas_memory, MEMSIZE);
+		int destroyed_before = ArrayTestCounter::s_destroyed;
+		ArrayTestCounter* freed = arena.allocate_array<ArrayTestCounter>(10, 1);
+		ArrayTestCounter* kept = arena.allocate_array<ArrayTestCounter>(20, 2);
+		assert(freed != NULL && kept != NULL && kept[19].getNumber() == 2);
+		arena.free_array(freed);
+		assert(ArrayTestCounter::s_destroyed == destroyed_before + 10);
+		arena.reset();
+		assert(ArrayTestCounter::s_destroyed == destroyed_before + 30);
+	}
+	std::cout << "-  Every element was destroyed exactly once" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - arrays were built & destroyed correctly, and nothing was copied \n" << C_END << std::endl;
+}
@@ -11,9 +11,11 @@
 // Failed allocations are only checked for after the benchmark, for a more true time.
 // N HAS TO BE a multiple of 5
 // Most classes aren't freed but it's fine we just overwrite them anyway
+template <class Allocator>
 static std::chrono::duration<double> allocate_N_classes(int N)
 {
-	emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+	Allocator	allocator(g_emmas_memory, MEMSIZE);
+	emma::BaseAllocator&	EMMA = allocator;
 	static	SmallClass* ptr_array[1000];
 
 	std::chrono::duration<double> total_time = std::chrono::duration<double>::zero();
@@ -49,9 +51,11 @@ static std::chrono::duration<double> allocate_N_classes(int N)
 // Simulates a worst case scenario
 // Stores pointers to be freed later in a given array
 // N HAS TO BE a multiple of 5
+template <class Allocator>
 static std::chrono::duration<double> deallocate_N_classes(int N)
 {
-	emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+	Allocator	allocator(g_emmas_memory, MEMSIZE);
+	emma::BaseAllocator&	EMMA = allocator;
 	static	SmallClass* ptr_array[1000];
 
 	std::chrono::duration<double> total_time = std::chrono::duration<double>::zero();
@@ -95,12 +99,13 @@ static void print_time(std::chrono::duration<double> &time)
 }
 
 // To deallocate is how from how many allocations we want to use
+template <class Allocator>
 static void run_one_deallocation_test(int to_deallocate, int iterations)
 {
 	std::chrono::duration<double> total_time = std::chrono::duration<double>::zero();
 	for (int i = 0; i < iterations; ++i)
 	{
-		total_time += deallocate_N_classes(to_deallocate);
+		total_time += deallocate_N_classes<Allocator>(to_deallocate);
 	}
 	total_time /= static_cast<double>(iterations);
 	print_time(total_time);
@@ -108,63 +113,235 @@ static void run_one_deallocation_test(int to_deallocate, int iterations)
 
 // toskip is the amount we want to skip, to run is the time we actually count.
 // For example, allocations N=10 to N=100 would have skip=10, run=90
+template <class Allocator>
 static void run_one_allocation_test(int to_skip, int to_run, int iterations)
 {
 	std::chrono::duration<double> total_time = std::chrono::duration<double>::zero();
 	for (int i = 0; i < iterations; ++i)
 	{
 		if (to_skip != 0)
-			allocate_N_classes(to_skip);
-		total_time += allocate_N_classes(to_run);
+			allocate_N_classes<Allocator>(to_skip);
+		total_time += allocate_N_classes<Allocator>(to_run);
 	}
 	total_time /= static_cast<double>(iterations);
 	print_time(total_time);
 }
 
-void benchmark_tests()
+template <class Allocator>
+static void run_benchmarks()
 {
 
 	std::cout << FG_YELLOW << " - Realistic Allocations - " << C_END << std::endl;
 	std::cout << "N represents the amount of existing allocations\n" << std::endl;
 
 	std::cout << " - Time per 10 allocations between N=0 to N=10 -" << std::endl;
-	run_one_allocation_test(0, 10, 1000000);
+	run_one_allocation_test<Allocator>(0, 10, 1000000);
 
 	std::cout << " - Time per 10 allocations between N=10 to N=100 -" << std::endl;
-	run_one_allocation_test(10, 90, 200000);
+	run_one_allocation_test<Allocator>(10, 90, 200000);
 
 	std::cout << " - Time per 10 allocations between N=100 to N=200 -" << std::endl;
-	run_one_allocation_test(100, 100, 150000);
+	run_one_allocation_test<Allocator>(100, 100, 150000);
 
 	std::cout << " - Time per 10 allocations between N=200 to N=300 -" << std::endl;
-	run_one_allocation_test(200, 100, 100000);
+	run_one_allocation_test<Allocator>(200, 100, 100000);
 
 	std::cout << " - Time per 10 allocations between N=300 to N=400 -" << std::endl;
-	run_one_allocation_test(300, 100, 50000);
+	run_one_allocation_test<Allocator>(300, 100, 50000);
 
 	std::cout << " - Time per 10 allocations between N=400 to N=500 -" << std::endl;
-	run_one_allocation_test(300, 100, 30000);
+	run_one_allocation_test<Allocator>(300, 100, 30000);
 
 
 	std::cout << FG_YELLOW << "\n - Realistic Deallocations - " << C_END << std::endl;
 	std::cout << "N represents the amount of existing allocations\n" << std::endl;
 
 	std::cout << " - Time per 10 deallocations from N=10 to N=0 -" << std::endl;
-	run_one_deallocation_test(10, 1000000);
+	run_one_deallocation_test<Allocator>(10, 1000000);
 
 	std::cout << " - Time per 10 deallocations from N=100 to N=0 -" << std::endl;
-	run_one_deallocation_test(100, 150000);
+	run_one_deallocation_test<Allocator>(100, 150000);
 
 	std::cout << " - Time per 10 deallocations from N=200 to N=0 -" << std::endl;
-	run_one_deallocation_test(200, 150000);
+	run_one_deallocation_test<Allocator>(200, 150000);
 
 	std::cout << " - Time per 10 deallocations from N=300 to N=0 -" << std::endl;
-	run_one_deallocation_test(300, 100000);
+	run_one_deallocation_test<Allocator>(300, 100000);
 
 	std::cout << " - Time per 10 deallocations from N=400 to N=0 -" << std::endl;
-	run_one_deallocation_test(400, 50000);
+	run_one_deallocation_test<Allocator>(400, 50000);
 
 	std::cout << " - Time per 10 deallocations from N=500 to N=0 -" << std::endl;
-	run_one_deallocation_test(500, 50000);
+	run_one_deallocation_test<Allocator>(500, 50000);
+
+}
+
+// Returns the AVERAGE time per call of the pattern above, allocating 5, freeing 2 & allocating 2 again.
+// The whole loop is timed once & divided by the amount of calls, frees & allocations alike.
+// N HAS TO BE a multiple of 5
+static std::chrono::duration<double> allocate_free_2_N_classes(bool deferred_coalescing, int N)
+{
+	emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE, deferred_coalescing);
+	static	SmallClass* ptr_array[1000];
 
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < N; i += 5)
+	{
+		ptr_array[i + 0] = EMMA.allocate_class<SmallClass>(42);
+		ptr_array[i + 1] = EMMA.allocate_class<SmallClass>(42);
+		ptr_array[i + 2] = EMMA.allocate_class<SmallClass>(42);
+		ptr_array[i + 3] = EMMA.allocate_class<SmallClass>(42);
+		ptr_array[i + 4] = EMMA.allocate_class<SmallClass>(42);
+		EMMA.free_class<SmallClass>(ptr_array[i + 2]);
+		EMMA.free_class<SmallClass>(ptr_array[i + 4]);
+		ptr_array[i + 2] = EMMA.allocate_class<SmallClass>(42);
+		ptr_array[i + 4] = EMMA.allocate_class<SmallClass>(42);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	for (int i = 0; i < N; ++i)
+		{ assert(ptr_array[i] != NULL); }
+	return (std::chrono::duration_cast<std::chrono::duration<double>>(end - begin) / static_cast<double>(N / 5 * 9));
+}
+
+static void run_deferred_benchmark(int N, int iterations)
+{
+	std::chrono::duration<double> immediate = std::chrono::duration<double>::zero();
+	std::chrono::duration<double> deferred = std::chrono::duration<double>::zero();
+	for (int i = 0; i < iterations; ++i)
+	{
+		immediate += allocate_free_2_N_classes(false, N);
+		deferred += allocate_free_2_N_classes(true, N);
+	}
+	immediate /= static_cast<double>(iterations);
+	deferred /= static_cast<double>(iterations);
+	std::cout << " - Coalescing right away -" << std::endl;
+	print_time(immediate);
+	std::cout << " - Deferred coalescing -" << std::endl;
+	print_time(deferred);
+}
+
+// Returns time PER ALLOCATION + FREE of one class.
+// Never inlined, so a BaseAllocator& really is called through the vtable,
+// where emma::Allocator<Policy> knows exactly which function it calls.
+template <class FrontEnd>
+__attribute__((noinline))
+static std::chrono::duration<double> allocate_and_free_N_classes(FrontEnd& EMMA, int N)
+{
+	static	SmallClass* ptr_array[100];
+
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < N; i += 100)
+	{
+		for (int j = 0; j < 100; ++j)
+			ptr_array[j] = EMMA.template allocate_class<SmallClass>(42);
+		for (int j = 0; j < 100; j += 2) // Every other first, so they don't just merge back
+			EMMA.free_class(ptr_array[j]);
+		for (int j = 1; j < 100; j += 2)
+			EMMA.free_class(ptr_array[j]);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	assert(ptr_array[99] != NULL);
+	return (std::chrono::duration_cast<std::chrono::duration<double>>(end - begin) / static_cast<double>(N));
+}
+
+// Same workload through both front-ends of the same allocator
+template <class Policy>
+static void run_dispatch_benchmark(int N)
+{
+	std::chrono::duration<double> time;
+	{
+		Policy	allocator(g_emmas_memory, MEMSIZE);
+		emma::BaseAllocator&	EMMA = allocator;
+		allocate_and_free_N_classes(EMMA, N / 10); // Warm up
+		time = allocate_and_free_N_classes(EMMA, N);
+		std::cout << " - Virtual, through BaseAllocator& -" << std::endl;
+		print_time(time);
+	}
+	{
+		emma::Allocator<Policy>	EMMA(g_emmas_memory, MEMSIZE);
+		allocate_and_free_N_classes(EMMA, N / 10);
+		time = allocate_and_free_N_classes(EMMA, N);
+		std::cout << " - Static, through emma::Allocator<Policy> -" << std::endl;
+		print_time(time);
+	}
+}
+
+// Returns time PER ROUND of filling & emptying a few containers.
+// A vector that keeps growing, and a hash map of strings which is half erased.
+static std::chrono::duration<double> pmr_containers_round(std::pmr::memory_resource* resource)
+{
+	auto begin = std::chrono::high_resolution_clock::now();
+	{
+		std::pmr::vector<int> numbers(resource);
+		for (int i = 0; i < 500; ++i)
+			numbers.push_back(i);
+
+		std::pmr::unordered_map<int, std::pmr::string> names(resource);
+		for (int i = 0; i < 200; ++i)
+			names.emplace(i, std::pmr::string(40, 'a' + i % 26));
+		for (int i = 0; i < 200; i += 2)
+			names.erase(i);
+		assert(numbers.back() == 499 && names.size() == 100);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return (std::chrono::duration_cast<std::chrono::duration<double>>(end - begin));
+}
+
+// A monotonic buffer never reuses memory, so it gets a fresh one every round
+static void run_pmr_benchmark(std::pmr::memory_resource* resource, const char* name, int rounds)
+{
+	std::chrono::duration<double> total_time = std::chrono::duration<double>::zero();
+	for (int i = 0; i < rounds; ++i)
+	{
+		if (resource != NULL)
+			total_time += pmr_containers_round(resource);
+		else
+		{
+			std::pmr::monotonic_buffer_resource buffer(g_emmas_memory, MEMSIZE, std::pmr::null_memory_resource());
+			total_time += pmr_containers_round(&buffer);
+		}
+	}
+	total_time /= static_cast<double>(rounds);
+	std::cout << " - " << name << " -" << std::endl;
+	print_time(total_time);
+}
+
+template <class Policy>
+static void run_emma_pmr_benchmark(const char* name, int rounds)
+{
+	Policy	allocator(g_emmas_memory, MEMSIZE);
+	emma::MemoryResource	resource(allocator);
+	run_pmr_benchmark(&resource, name, rounds);
+}
+
+void benchmark_tests()
+{
+	std::cout << FG_BLACK << BG_YELLOW << " Free List " << C_END << "\n" << std::endl;
+	run_benchmarks<emma::allocators::FreeList>();
+
+	std::cout << "\n" << FG_BLACK << BG_YELLOW << " Slab " << C_END << "\n" << std::endl;
+	run_benchmarks<emma::allocators::Slab>();
+
+	std::cout << "\n" << FG_BLACK << BG_YELLOW << " TLSF " << C_END << "\n" << std::endl;
+	run_benchmarks<emma::allocators::TLSF>();
+
+	std::cout << "\n" << FG_BLACK << BG_YELLOW << " Deferred coalescing " << C_END << "\n" << std::endl;
+	std::cout << FG_YELLOW << " - Average time per call, allocating 5, freeing 2 & allocating 2 again, Free List - " << C_END << std::endl;
+	run_deferred_benchmark(500, 100000);
+
+	std::cout << "\n" << FG_BLACK << BG_YELLOW << " Virtual vs static dispatch " << C_END << "\n" << std::endl;
+	std::cout << FG_YELLOW << " - Time per allocation + free, Free List - " << C_END << std::endl;
+	run_dispatch_benchmark<emma::allocators::FreeList>(10000000);
+	std::cout << FG_YELLOW << " - Time per allocation + free, TLSF - " << C_END << std::endl;
+	run_dispatch_benchmark<emma::allocators::TLSF>(10000000);
+
+	std::cout << "\n" << FG_BLACK << BG_YELLOW << " std::pmr containers " << C_END << "\n" << std::endl;
+	std::cout << FG_YELLOW << " - Time per round of a vector & a hash map of strings - " << C_END << std::endl;
+	run_pmr_benchmark(std::pmr::new_delete_resource(), "std::pmr::new_delete_resource", 20000);
+	run_pmr_benchmark(NULL, "std::pmr::monotonic_buffer_resource", 20000);
+	run_emma_pmr_benchmark<emma::allocators::FreeList>("emma::MemoryResource, Free List", 20000);
+	run_emma_pmr_benchmark<emma::allocators::Slab>("emma::MemoryResource, Slab", 20000);
+	run_emma_pmr_benchmark<emma::allocators::TLSF>("emma::MemoryResource, TLSF", 20000);
 }
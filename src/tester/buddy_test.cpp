@@ -0,0 +1,77 @@
+/* [ TESTS OF THE BUDDY ALLOCATOR ]
+ *
+ *   Splits the memory down to the smallest blocks, frees them in a random
+ *   order and checks that they were all merged back into the largest blocks.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <stdint.h>
+#include <cstring>
+
+static std::size_t buddy_test_largest_block(emma::allocators::Buddy& EMMA)
+{
+	std::size_t size = std::size_t(1) << 62;
+	void* ptr;
+	while (size >= emma::allocators::Buddy::MIN_BLOCK_SIZE)
+	{
+		if ((ptr = EMMA.allocate_raw_ptr(size)) != NULL)
+		{
+			EMMA.free_raw_ptr(ptr);
+			return size;
+		}
+		size >>= 1;
+	}
+	return 0;
+}
+
+void buddy_tests()
+{
+	emma::allocators::Buddy	EMMA(g_emmas_memory, MEMSIZE);
+	std::size_t largest = buddy_test_largest_block(EMMA);
+	assert(largest != 0);
+
+	std::cout << "1. Allocating the smallest blocks until the memory runs out" << std::endl;
+	std::vector<uint8_t*> blocks;
+	uint8_t* ptr;
+	while ((ptr = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(1))) != NULL)
+	{
+		assert(reinterpret_cast<uintptr_t>(ptr) % emma::allocators::Buddy::MIN_BLOCK_SIZE == 0);
+		std::memset(ptr, static_cast<int>(blocks.size() & 0xFF), emma::allocators::Buddy::MIN_BLOCK_SIZE);
+		blocks.push_back(ptr);
+	}
+	for (std::size_t i = 0; i < blocks.size(); ++i)
+		{ assert(blocks[i][0] == (i & 0xFF) && blocks[i][15] == (i & 0xFF)); }
+	std::cout << "-  Got " << blocks.size() << " blocks, none of them overlapping" << std::endl;
+
+	std::cout << "2. Freeing them in a random order" << std::endl;
+	std::shuffle(blocks.begin(), blocks.end(), std::mt19937(42));
+	for (uint8_t* block : blocks)
+		EMMA.free_raw_ptr(block);
+	assert(buddy_test_largest_block(EMMA) == largest);
+	std::cout << "-  All blocks merged back, largest block is " << largest << " bytes" << std::endl;
+
+	std::cout << "3. Allocating mixed sizes and freeing them in a random order" << std::endl;
+	std::mt19937 rng(1234);
+	std::vector<void*> mixed;
+	for (int round = 0; round < 4; ++round)
+	{
+		void* mixed_ptr;
+		while ((mixed_ptr = EMMA.allocate_raw_ptr(1 + rng() % 3000)) != NULL)
+			mixed.push_back(mixed_ptr);
+		std::shuffle(mixed.begin(), mixed.end(), rng);
+		for (std::size_t i = 0; i < mixed.size() / 2; ++i)
+			EMMA.free_raw_ptr(mixed[i]);
+		mixed.erase(mixed.begin(), mixed.begin() + mixed.size() / 2);
+	}
+	for (void* mixed_ptr : mixed)
+		EMMA.free_raw_ptr(mixed_ptr);
+	assert(buddy_test_largest_block(EMMA) == largest);
+	std::cout << "-  All blocks merged back again" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - blocks were split and merged back correctly\n" << C_END << std::endl;
+}
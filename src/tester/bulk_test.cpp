@@ -0,0 +1,112 @@
+/* [ TESTS OF BULK ALLOCATION ]
+ *
+ *   Tests that the free list carves a bulk allocation out of one free block,
+ *   one allocation right after another, and that freeing them in bulk merges
+ *   all of the memory back together.
+ *   Then tests the typed wrappers with every allocator that takes any size.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <stdint.h>
+
+#define BULK_TEST_COUNT 500
+
+static std::size_t bulk_test_largest_allocation(emma::BaseAllocator& EMMA)
+{
+	std::size_t low = 1, high = MEMSIZE;
+	while (low < high)
+	{
+		std::size_t middle = (low + high + 1) / 2;
+		void* ptr = EMMA.allocate_raw_ptr(middle);
+		if (ptr != NULL)
+		{
+			EMMA.free_raw_ptr(ptr);
+			low = middle;
+		}
+		else
+			high = middle - 1;
+	}
+	return low;
+}
+
+static void bulk_test_classes(emma::BaseAllocator& EMMA, const char* name)
+{
+	std::cout << "- " << name << std::endl;
+
+	std::vector<LargeClass*> classes(BULK_TEST_COUNT / 5);
+	std::size_t made = EMMA.allocate_class_bulk<LargeClass>(classes.size(), classes.data(), 42);
+	assert(made == classes.size());
+	for (LargeClass* ptr : classes)
+	{
+		assert(ptr != NULL && ptr->getNumber() == 42);
+		assert(reinterpret_cast<uintptr_t>(ptr) % alignof(LargeClass) == 0);
+	}
+	EMMA.free_class_bulk<LargeClass>(classes.data(), classes.size());
+	std::cout << "  " << made << " classes constructed & freed in bulk" << std::endl;
+}
+
+void bulk_tests()
+{
+	emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+	std::size_t largest = bulk_test_largest_allocation(EMMA);
+	std::vector<void*> ptrs(BULK_TEST_COUNT);
+
+	std::cout << "1. Allocating " << BULK_TEST_COUNT << " blocks of 48 bytes at once" << std::endl;
+	assert(EMMA.allocate_bulk(48, ptrs.size(), ptrs.data()) == ptrs.size());
+	for (std::size_t i = 1; i < ptrs.size(); ++i)
+		{ assert(ptrs[i] > ptrs[i - 1]); }
+	for (void* ptr : ptrs)
+		{ assert(EMMA.usable_size(ptr) >= 48); }
+	std::cout << "-  Every block was carved right after the previous one" << std::endl;
+
+	std::cout << "2. Freeing all of them at once, in a random order" << std::endl;
+	std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937(42));
+	EMMA.free_bulk(ptrs.data(), ptrs.size());
+	assert(bulk_test_largest_allocation(EMMA) == largest);
+	std::cout << "-  Memory merged back into a single block of " << largest << " bytes" << std::endl;
+
+	std::cout << "3. Freeing every other block in bulk, then the rest" << std::endl;
+	assert(EMMA.allocate_bulk(100, ptrs.size(), ptrs.data(), 64) == ptrs.size());
+	for (void* ptr : ptrs)
+		{ assert(reinterpret_cast<uintptr_t>(ptr) % 64 == 0); }
+	std::vector<void*> every_other;
+	for (std::size_t i = 0; i < ptrs.size(); i += 2)
+	{
+		every_other.push_back(ptrs[i]);
+		ptrs[i] = NULL; // NULLs are skipped
+	}
+	EMMA.free_bulk(every_other.data(), every_other.size());
+	EMMA.free_bulk(ptrs.data(), ptrs.size());
+	assert(bulk_test_largest_allocation(EMMA) == largest);
+	std::cout << "-  Memory merged back into a single block of " << largest << " bytes" << std::endl;
+
+	std::cout << "4. Running out of memory" << std::endl;
+	std::size_t count = EMMA.allocate_bulk(1000, ptrs.size(), ptrs.data());
+	assert(count > 0 && count < ptrs.size());
+	EMMA.free_bulk(ptrs.data(), count);
+	assert(bulk_test_largest_allocation(EMMA) == largest);
+	std::cout << "-  Made " << count << " of " << ptrs.size() << " blocks, which were freed again" << std::endl;
+
+	std::cout << "5. Classes in bulk" << std::endl;
+	bulk_test_classes(EMMA, "FreeList");
+	{
+		emma::allocators::TLSF	tlsf(g_emmas_memory, MEMSIZE);
+		bulk_test_classes(tlsf, "TLSF");
+	}
+	{
+		emma::allocators::Buddy	buddy(g_emmas_memory, MEMSIZE);
+		bulk_test_classes(buddy, "Buddy");
+	}
+	{
+		emma::allocators::SharedFreeList	shared_heap(g_emmas_memory, MEMSIZE);
+		emma::allocators::ThreadCache		cache(shared_heap);
+		bulk_test_classes(cache, "ThreadCache");
+	}
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - bulk allocations were carved in one piece, and merged back \n" << C_END << std::endl;
+}
@@ -0,0 +1,139 @@
+/* [ TESTS OF THE RED-BLACK TREE'S CHAINS ]
+ *
+ *   Tests the nodes of the same value, which are chained behind the one in
+ *   the tree. The head, the middle & the tail of a chain are removed, and
+ *   after every removal the whole tree is checked & best fits searched.
+ *   'make test_compact' runs the same with the compact node layout.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <stdint.h>
+
+#define CHAIN_TEST_NODES 64
+#define CHAIN_TEST_VALUE 1000
+
+typedef emma::RedBlackTree::Node	ChainTestNode;
+
+static std::size_t chain_test_check_subtree(const ChainTestNode* node, const ChainTestNode* parent,
+	std::size_t low, std::size_t high, std::size_t& node_count)
+{/* Checks the order, colors, links & chains below the node. Returns it's black height. */
+
+	if (node == NULL)
+		return 1;
+	assert(!node->is_chained() && node->get_parent() == parent);
+	assert(node->value >= low && node->value <= high);
+	if (node->get_color() == ChainTestNode::RED)
+	{
+		assert(node->get_left() == NULL || node->get_left()->get_color() == ChainTestNode::BLACK);
+		assert(node->get_right() == NULL || node->get_right()->get_color() == ChainTestNode::BLACK);
+	}
+
+	// Each chained node points back to the one before it
+	++node_count;
+	for (const ChainTestNode* chained = node; chained->get_same() != NULL; chained = chained->get_same())
+	{
+		assert(chained->get_same()->is_chained() && chained->get_same()->get_parent() == chained);
+		assert(chained->get_same()->value == node->value);
+		++node_count;
+	}
+
+	std::size_t left = chain_test_check_subtree(node->get_left(), node, low, node->value - 1, node_count);
+	std::size_t right = chain_test_check_subtree(node->get_right(), node, node->value + 1, high, node_count);
+	assert(left == right);
+	return left + (node->get_color() == ChainTestNode::BLACK);
+}
+
+static void chain_test_check_tree(emma::RedBlackTree& tree, ChainTestNode* any_node, std::size_t expected_count)
+{/* Finds the root from any node still in the tree, and checks the whole tree */
+
+	ChainTestNode* root = any_node;
+	while (root->is_chained())
+		root = root->get_parent();
+	while (root->get_parent() != NULL)
+		root = root->get_parent();
+	assert(root->get_color() == ChainTestNode::BLACK);
+
+	std::size_t node_count = 0;
+	chain_test_check_subtree(root, NULL, 0, std::numeric_limits<std::size_t>::max(), node_count);
+	assert(node_count == expected_count);
+
+	std::size_t measured_count, value_sum, largest, height;
+	tree.measure(measured_count, value_sum, largest, height);
+	assert(measured_count == expected_count);
+}
+
+void chain_tests()
+{
+	// The nodes are kept in our memory, so that compact links can reach each other
+	ChainTestNode* chained = static_cast<ChainTestNode*>(g_emmas_memory);
+	ChainTestNode* others = chained + CHAIN_TEST_NODES;
+	emma::RedBlackTree tree;
+
+	std::cout << "1. Inserting " << CHAIN_TEST_NODES << " nodes of the same value, between others" << std::endl;
+	for (std::size_t i = 0; i < CHAIN_TEST_NODES; ++i)
+	{
+		tree.insert_node(new(&others[i]) ChainTestNode(CHAIN_TEST_VALUE - 10 * (CHAIN_TEST_NODES - i)));
+		tree.insert_node(new(&chained[i]) ChainTestNode(CHAIN_TEST_VALUE));
+	}
+	tree.insert_node(new(&others[CHAIN_TEST_NODES]) ChainTestNode(CHAIN_TEST_VALUE + 10));
+	std::size_t count = CHAIN_TEST_NODES * 2 + 1;
+	chain_test_check_tree(tree, &others[0], count);
+
+	// Only one of them is in the tree, the rest are chained behind it
+	std::size_t in_tree = 0;
+	for (std::size_t i = 0; i < CHAIN_TEST_NODES; ++i)
+		in_tree += !chained[i].is_chained();
+	assert(in_tree == 1);
+	assert(tree.search_best_fit(CHAIN_TEST_VALUE - 5)->value == CHAIN_TEST_VALUE);
+	assert(tree.search_best_fit(CHAIN_TEST_VALUE)->is_chained());
+	assert(tree.search_best_fit(CHAIN_TEST_VALUE + 1) == &others[CHAIN_TEST_NODES]);
+	std::cout << "-  One of them is in the tree, the rest are chained behind it" << std::endl;
+
+	std::cout << "2. Removing the head, the middle & the tail of the chain" << std::endl;
+	std::vector<ChainTestNode*> left_in_chain;
+	for (std::size_t i = 0; i < CHAIN_TEST_NODES; ++i)
+		left_in_chain.push_back(&chained[i]);
+	for (int kind = 0; kind < 3; ++kind)
+	{
+		ChainTestNode* target = NULL;
+		for (ChainTestNode* node : left_in_chain)
+		{
+			bool is_head = !node->is_chained();
+			bool is_tail = node->is_chained() && node->get_same() == NULL;
+			bool is_middle = node->is_chained() && node->get_same() != NULL;
+			if ((kind == 0 && is_head) || (kind == 1 && is_middle) || (kind == 2 && is_tail))
+				target = node;
+		}
+		assert(target != NULL);
+		tree.remove_node(target);
+		left_in_chain.erase(std::find(left_in_chain.begin(), left_in_chain.end(), target));
+		chain_test_check_tree(tree, &others[0], --count);
+		assert(tree.search_best_fit(CHAIN_TEST_VALUE)->value == CHAIN_TEST_VALUE);
+		assert(tree.search_best_fit(CHAIN_TEST_VALUE)->is_chained());
+	}
+	std::cout << "-  The tree stayed valid, and the chain was still found" << std::endl;
+
+	std::cout << "3. Removing the rest of the chain in a random order" << std::endl;
+	std::mt19937 rng(22);
+	std::shuffle(left_in_chain.begin(), left_in_chain.end(), rng);
+	while (!left_in_chain.empty())
+	{
+		assert(tree.search_best_fit(CHAIN_TEST_VALUE - 5)->value == CHAIN_TEST_VALUE);
+		tree.remove_node(left_in_chain.back());
+		left_in_chain.pop_back();
+		chain_test_check_tree(tree, &others[0], --count);
+	}
+	assert(tree.search_best_fit(CHAIN_TEST_VALUE - 5) == &others[CHAIN_TEST_NODES]);
+	assert(tree.search_best_fit(CHAIN_TEST_VALUE - 15)->value == CHAIN_TEST_VALUE - 10);
+	assert(tree.search_largest() == &others[CHAIN_TEST_NODES]);
+	std::cout << "-  Every removal left a valid tree, with the right best fits" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - chained nodes were removed without breaking the tree \n" << C_END << std::endl;
+}
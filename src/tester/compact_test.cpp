@@ -0,0 +1,99 @@
+/* [ TESTS OF THE COMPACT FREELIST ]
+ *
+ *   Tests the FreeList's per allocation overhead. With EMMA_COMPACT_FREELIST
+ *   enabled, the headers & nodes have to be as small as promised, and the
+ *   links between them have to survive a long run of random calls.
+ *   'make test_compact' enables it, otherwise the sizes are only printed.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <random>
+#include <cstring>
+#include <stdint.h>
+
+#define COMPACT_TEST_ROUNDS 20000
+
+void compact_tests()
+{
+	typedef emma::allocators::FreeList	FreeList;
+
+	std::cout << "1. Size of headers & nodes" << std::endl;
+	std::cout << "  Header " << sizeof(FreeList::Header) << " bytes, node "
+	<< sizeof(emma::RedBlackTree::Node) << " bytes, smallest block "
+	<< FreeList::MIN_BLOCK_SIZE << " bytes" << std::endl;
+	# if EMMA_COMPACT_FREELIST
+	assert(sizeof(FreeList::Header) == 4 && sizeof(emma::RedBlackTree::Node) == 20);
+	assert(FreeList::MIN_BLOCK_SIZE == 28);
+	std::cout << "-  Compact" << std::endl;
+	# else
+	std::cout << "-  Not compact, see 'make test_compact'" << std::endl;
+	# endif
+
+	std::cout << "2. Filling the memory with 4 byte allocations" << std::endl;
+	{
+		FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		std::vector<void*> ptrs;
+		for (void* ptr = EMMA.allocate_raw_ptr(4); ptr != NULL; ptr = EMMA.allocate_raw_ptr(4))
+			ptrs.push_back(ptr);
+
+		// Every allocation takes exactly a smallest block, there is no padding
+		std::cout << "  " << ptrs.size() << " allocations fit in " << MEMSIZE << " bytes" << std::endl;
+		assert(ptrs.size() >= MEMSIZE / FreeList::MIN_BLOCK_SIZE - 1);
+		for (void* ptr : ptrs)
+			EMMA.free_raw_ptr(ptr);
+		assert(EMMA.get_stats().free_block_count == 1);
+	}
+	std::cout << "-  They all fit, and merged back into one block" << std::endl;
+
+	std::cout << "3. Random allocations, frees & reallocations" << std::endl;
+	{
+		FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		std::vector<std::pair<uint8_t*, std::size_t>> ptrs;
+		std::mt19937 rng(20);
+
+		// Each allocation is filled with a byte of it's own, if a link was
+		// ever wrong blocks would overlap & the bytes would get mixed up
+		for (int i = 0; i < COMPACT_TEST_ROUNDS; ++i)
+		{
+			unsigned int action = ptrs.empty() ? 0 : rng() % 3;
+			if (action == 0)
+			{
+				std::size_t size = 1 + rng() % 300;
+				uint8_t* ptr = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(size, std::size_t(1) << (rng() % 7)));
+				if (ptr == NULL)
+					continue;
+				std::memset(ptr, static_cast<int>(size), size);
+				ptrs.push_back(std::make_pair(ptr, size));
+				continue;
+			}
+
+			std::size_t index = rng() % ptrs.size();
+			uint8_t* ptr = ptrs[index].first;
+			std::size_t size = ptrs[index].second;
+			assert(ptr[0] == static_cast<uint8_t>(size) && ptr[size - 1] == static_cast<uint8_t>(size));
+			if (action == 1)
+			{
+				EMMA.free_raw_ptr(ptr);
+				ptrs[index] = ptrs.back();
+				ptrs.pop_back();
+				continue;
+			}
+
+			std::size_t new_size = 1 + rng() % 600;
+			ptr = static_cast<uint8_t*>(EMMA.reallocate_raw_ptr(ptr, new_size));
+			if (ptr == NULL)
+				continue;
+			std::memset(ptr, static_cast<int>(new_size), new_size);
+			ptrs[index] = std::make_pair(ptr, new_size);
+		}
+		for (const std::pair<uint8_t*, std::size_t>& ptr : ptrs)
+			EMMA.free_raw_ptr(ptr.first);
+		assert(EMMA.get_stats().free_block_count == 1);
+	}
+	std::cout << "-  No allocation was overwritten, and everything merged back" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - the FreeList's overhead is as expected \n" << C_END << std::endl;
+}
@@ -0,0 +1,160 @@
+/* [ TESTS OF DEFERRED COALESCING ]
+ *
+ *   Tests the FreeList's deferred coalescing. A freed block should be handed
+ *   right back to the next allocation of about the same size, and every
+ *   waiting block should still be merged back once there are too many,
+ *   an allocation misses or consolidate() is called. With EMMA_COMPACT_FREELIST
+ *   ('make test_compact'), the waiting blocks' data is only aligned to 4 bytes.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <random>
+#include <cstring>
+#include <stdint.h>
+
+#define DEFERRED_TEST_ROUNDS 20000
+
+void deferred_tests()
+{
+	typedef emma::allocators::FreeList	FreeList;
+
+	std::cout << "1. Freeing & allocating the same size again" << std::endl;
+	{
+		FreeList	EMMA(g_emmas_memory, MEMSIZE, true);
+		void* first = EMMA.allocate_raw_ptr(100);
+		void* blocker = EMMA.allocate_raw_ptr(100);
+		assert(first != NULL && blocker != NULL);
+
+		EMMA.free_raw_ptr(first);
+		assert(EMMA.consolidate(0) == 1); // It wasn't merged with anything
+		assert(EMMA.get_stats().free_block_count == 2); // But it's counted as free
+		assert(EMMA.allocate_raw_ptr(90) == first);
+		EMMA.free_raw_ptr(first);
+		assert(EMMA.allocate_raw_ptr(100) == first);
+
+		EMMA.free_raw_ptr(first);
+		EMMA.free_raw_ptr(blocker);
+		assert(EMMA.consolidate() == 0 && EMMA.get_stats().free_block_count == 1);
+	}
+	std::cout << "-  The freed block was reused, and merged back on consolidate()" << std::endl;
+
+	std::cout << "2. Consolidating a few blocks at a time" << std::endl;
+	{
+		FreeList	EMMA(g_emmas_memory, MEMSIZE, true);
+		std::vector<void*> ptrs;
+		for (int i = 0; i < 20; ++i)
+			ptrs.push_back(EMMA.allocate_raw_ptr(64));
+		for (void* ptr : ptrs)
+			EMMA.free_raw_ptr(ptr);
+		assert(EMMA.consolidate(0) == 20);
+		emma::Stats waiting = EMMA.get_stats();
+		assert(waiting.free_block_count == 21);
+		assert(EMMA.get_fragmentation().free_block_count == 1); // The heap walk sees them as used
+		assert(EMMA.consolidate(5) == 15);
+		assert(EMMA.consolidate() == 0 && EMMA.get_stats().free_block_count == 1);
+		assert(EMMA.get_stats().free_bytes > waiting.free_bytes); // The headers between them are free too
+	}
+	std::cout << "-  20 blocks waited, 5 & then the rest were merged back" << std::endl;
+
+	std::cout << "3. Too many freed blocks, and an allocation that misses" << std::endl;
+	{
+		FreeList	EMMA(g_emmas_memory, MEMSIZE, true);
+		std::vector<void*> ptrs;
+		for (std::size_t i = 0; i < FreeList::QUICK_LIST_CAPACITY + 10; ++i)
+			ptrs.push_back(EMMA.allocate_raw_ptr(64));
+		for (void* ptr : ptrs)
+			EMMA.free_raw_ptr(ptr);
+		assert(EMMA.consolidate(0) == 10); // Overflowed once, then 10 more
+
+		void* large = EMMA.allocate_raw_ptr(4000);
+		assert(large != NULL && EMMA.consolidate(0) == 0);
+		EMMA.free_raw_ptr(large);
+		assert(EMMA.consolidate() == 0 && EMMA.get_stats().free_block_count == 1);
+	}
+	std::cout << "-  Both merged every waiting block back" << std::endl;
+
+	std::cout << "4. Random allocations, frees & reallocations" << std::endl;
+	{
+		FreeList	EMMA(g_emmas_memory, MEMSIZE, true);
+		std::vector<std::pair<uint8_t*, std::size_t>> ptrs;
+		std::mt19937 rng(24);
+
+		// Each allocation is filled with a byte of it's own, if a waiting block
+		// was ever handed out twice the bytes would get mixed up
+		for (int i = 0; i < DEFERRED_TEST_ROUNDS; ++i)
+		{
+			unsigned int action = ptrs.empty() ? 0 : rng() % 3;
+			if (action == 0)
+			{
+				std::size_t size = 1 + rng() % 300;
+				uint8_t* ptr = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(size, std::size_t(1) << (rng() % 7)));
+				if (ptr == NULL)
+					continue;
+				std::memset(ptr, static_cast<int>(size), size);
+				ptrs.push_back(std::make_pair(ptr, size));
+				continue;
+			}
+
+			std::size_t index = rng() % ptrs.size();
+			uint8_t* ptr = ptrs[index].first;
+			std::size_t size = ptrs[index].second;
+			assert(ptr[0] == static_cast<uint8_t>(size) && ptr[size - 1] == static_cast<uint8_t>(size));
+			if (action == 1)
+			{
+				EMMA.free_raw_ptr(ptr);
+				ptrs[index] = ptrs.back();
+				ptrs.pop_back();
+				continue;
+			}
+
+			std::size_t new_size = 1 + rng() % 600;
+			ptr = static_cast<uint8_t*>(EMMA.reallocate_raw_ptr(ptr, new_size));
+			if (ptr == NULL)
+				continue;
+			std::memset(ptr, static_cast<int>(new_size), new_size);
+			ptrs[index] = std::make_pair(ptr, new_size);
+		}
+		for (const std::pair<uint8_t*, std::size_t>& ptr : ptrs)
+			EMMA.free_raw_ptr(ptr.first);
+		assert(EMMA.consolidate() == 0 && EMMA.get_stats().free_block_count == 1);
+	}
+	std::cout << "-  No allocation was overwritten, and everything merged back" << std::endl;
+
+	std::cout << "5. Freeing & reusing 4 byte allocations" << std::endl;
+	{
+		FreeList	EMMA(g_emmas_memory, MEMSIZE, true);
+		std::vector<void*> ptrs;
+		std::size_t unaligned = 0; // To 8 bytes, only possible with EMMA_COMPACT_FREELIST
+		for (std::size_t i = 0; i < FreeList::QUICK_LIST_CAPACITY * 2; ++i)
+		{
+			ptrs.push_back(EMMA.allocate_raw_ptr(4, 4));
+			assert(ptrs.back() != NULL);
+			unaligned += reinterpret_cast<uintptr_t>(ptrs.back()) % 8 != 0;
+		}
+		# if EMMA_COMPACT_FREELIST
+		assert(unaligned > 0);
+		# endif
+
+		// The waiting blocks are linked through their data, which may be unaligned
+		for (std::size_t round = 0; round < 3; ++round)
+		{
+			for (std::size_t i = 0; i < ptrs.size(); i += 2)
+				EMMA.free_raw_ptr(ptrs[i]);
+			for (std::size_t i = 0; i < ptrs.size(); i += 2)
+			{
+				ptrs[i] = EMMA.allocate_raw_ptr(4, 4);
+				assert(ptrs[i] != NULL);
+			}
+		}
+		for (void* ptr : ptrs)
+			EMMA.free_raw_ptr(ptr);
+		assert(EMMA.consolidate() == 0 && EMMA.get_stats().free_block_count == 1);
+		std::cout << "  " << unaligned << " of " << ptrs.size() << " weren't aligned to 8 bytes" << std::endl;
+	}
+	std::cout << "-  Every waiting block was found again, and merged back" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - freed blocks were reused & merged back later \n" << C_END << std::endl;
+}
@@ -0,0 +1,135 @@
+/* [ TESTS OF THE HEAP WALKER ]
+ *
+ *   Tests that FreeList's walk_heap() visits every block once, that the
+ *   blocks cover the whole memory without gaps, and that they agree with
+ *   the tree. Also tests the fragmentation report & the dump of the heap.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <stdint.h>
+
+#define HEAP_WALK_TEST_ROUNDS 2000
+
+static void heap_walk_test_check(emma::allocators::FreeList& EMMA, const std::vector<void*>& ptrs)
+{/* Walks the heap & checks it against the live pointers & the stats */
+
+	uintptr_t	position = reinterpret_cast<uintptr_t>(g_emmas_memory);
+	std::size_t	free_blocks = 0, free_bytes = 0, used_blocks = 0;
+
+	emma::allocators::FreeList::BlockInfo block;
+	while (EMMA.walk_heap(block))
+	{
+		// Each block starts right where the last one ended
+		assert(reinterpret_cast<uintptr_t>(block.address) == position + block.padding);
+		position += block.padding + block.size;
+		if (block.is_free)
+		{
+			++free_blocks;
+			free_bytes += block.size - sizeof(emma::allocators::FreeList::Header);
+		}
+		else
+			++used_blocks;
+	}
+	assert(position == reinterpret_cast<uintptr_t>(g_emmas_memory) + MEMSIZE);
+	assert(used_blocks == ptrs.size());
+
+	emma::Stats stats = EMMA.get_stats();
+	assert(free_blocks == stats.free_block_count && free_bytes == stats.free_bytes);
+
+	emma::allocators::FreeList::Fragmentation report = EMMA.get_fragmentation();
+	std::size_t histogram_total = 0;
+	for (std::size_t bucket = 0; bucket < emma::allocators::FreeList::HISTOGRAM_SIZE; ++bucket)
+		histogram_total += report.free_size_histogram[bucket];
+	assert(histogram_total == free_blocks && report.block_count == free_blocks + used_blocks);
+	assert(report.used_bytes + report.free_bytes + report.header_bytes + report.padding_bytes == MEMSIZE);
+	assert(report.largest_free_block == stats.largest_free_block);
+}
+
+void heap_walk_tests()
+{
+	std::cout << "1. Walking a new heap" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		heap_walk_test_check(EMMA, std::vector<void*>());
+		emma::allocators::FreeList::Fragmentation report = EMMA.get_fragmentation();
+		assert(report.block_count == 1 && report.external_ratio == 0.0);
+	}
+	std::cout << "-  One free block, covering the whole memory" << std::endl;
+
+	std::cout << "2. Walking after random allocations, frees & reallocations" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+
+		// The gap in front of the first block becomes a free block of it's own
+		std::vector<void*> ptrs;
+		ptrs.push_back(EMMA.allocate_raw_ptr(100, 4096));
+		assert(EMMA.get_fragmentation().free_block_count == 2);
+		heap_walk_test_check(EMMA, ptrs);
+
+		std::mt19937 rng(7);
+		for (int i = 0; i < HEAP_WALK_TEST_ROUNDS; ++i)
+		{
+			unsigned int action = ptrs.empty() ? 0 : rng() % 3;
+			if (action == 0)
+			{
+				void* ptr = EMMA.allocate_raw_ptr(1 + rng() % 500, std::size_t(1) << (rng() % 8));
+				if (ptr != NULL)
+					ptrs.push_back(ptr);
+			}
+			else if (action == 1)
+			{
+				std::size_t index = rng() % ptrs.size();
+				EMMA.free_raw_ptr(ptrs[index]);
+				ptrs[index] = ptrs.back();
+				ptrs.pop_back();
+			}
+			else
+			{
+				std::size_t index = rng() % ptrs.size();
+				void* ptr = EMMA.reallocate_raw_ptr(ptrs[index], 1 + rng() % 800);
+				if (ptr != NULL)
+					ptrs[index] = ptr;
+			}
+			heap_walk_test_check(EMMA, ptrs);
+		}
+		for (void* ptr : ptrs)
+			EMMA.free_raw_ptr(ptr);
+		heap_walk_test_check(EMMA, std::vector<void*>());
+	}
+	std::cout << "-  The blocks covered the memory & matched the tree every step" << std::endl;
+
+	std::cout << "3. Fragmentation report & dump" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		std::vector<void*> ptrs;
+		for (int i = 0; i < 100; ++i)
+			ptrs.push_back(EMMA.allocate_raw_ptr(64));
+		for (int i = 0; i < 100; i += 2)
+			EMMA.free_raw_ptr(ptrs[i]);
+
+		emma::allocators::FreeList::Fragmentation report = EMMA.get_fragmentation();
+		assert(report.block_count == 101 && report.free_block_count == 51);
+		assert(report.external_ratio > 0.0 && report.external_ratio < 1.0);
+		std::cout << "  " << report.free_block_count << " free blocks, external fragmentation "
+		<< report.external_ratio << std::endl;
+
+		// One CSV row per block, after the column names
+		std::FILE* file = std::tmpfile();
+		assert(file != NULL);
+		EMMA.dump_heap(file, true);
+		std::rewind(file);
+		std::size_t lines = 0;
+		for (int c = std::fgetc(file); c != EOF; c = std::fgetc(file))
+			lines += (c == '\n');
+		std::fclose(file);
+		assert(lines == report.block_count + 1);
+	}
+	std::cout << "-  Fragmentation was measured, & every block was dumped" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - the walk covered the whole heap \n" << C_END << std::endl;
+}
@@ -43,6 +43,26 @@ void*	g_emmas_memory;
 // Simplifies our compilation and inclusions
 #include "determinism_test.cpp"
 #include "alignment_test.cpp"
+#include "slab_test.cpp"
+#include "thread_cache_test.cpp"
+#include "pool_test.cpp"
+#include "arena_test.cpp"
+#include "stack_test.cpp"
+#include "buddy_test.cpp"
+#include "tlsf_test.cpp"
+#include "realloc_test.cpp"
+#include "bulk_test.cpp"
+#include "array_test.cpp"
+#include "static_allocator_test.cpp"
+#include "std_adapter_test.cpp"
+#include "stats_test.cpp"
+#include "heap_walk_test.cpp"
+#include "compact_test.cpp"
+#include "chain_test.cpp"
+#include "small_bin_test.cpp"
+#include "deferred_test.cpp"
+#include "persistent_test.cpp"
+#include "trace_test.cpp"
 #include "benchmarks.cpp"
 
 int main()
@@ -66,11 +86,212 @@ int main()
 	std::cout << "\n" << std::endl;
 	std::cout << FG_BLACK << BG_CYAN << " [ Alignment tests ] " << C_END << std::endl;
 	static std::string description_alignment = \
-	"This tests the alignment of the variables. They should all be naturally aligned.\n";
+	"This tests the alignment of the variables. Classes should be aligned to alignof(),\n"
+	"and raw pointers to the alignment that was asked for.\n";
 	std::cout << C_CYAN << description_determinism << C_END << std::endl;
 
 	alignment_tests();
 
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Slab tests ] " << C_END << std::endl;
+	static std::string description_slab = \
+	"This tests the slab allocator. Small classes should come from the slabs,\n"
+	"freed classes should be reused right away and large classes should still work.\n";
+	std::cout << C_CYAN << description_slab << C_END << std::endl;
+
+	slab_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Multi-threaded tests ] " << C_END << std::endl;
+	static std::string description_threads = \
+	"This tests threads sharing one heap, each through their own ThreadCache.\n"
+	"Throughput is compared against threads locking the shared heap on every call.\n";
+	std::cout << C_CYAN << description_threads << C_END << std::endl;
+
+	thread_cache_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Pool tests ] " << C_END << std::endl;
+	static std::string description_pool = \
+	"This tests the lock-free pool. Every block should be handed out exactly once,\n"
+	"even while producer & consumer threads allocate and free at the same time.\n";
+	std::cout << C_CYAN << description_pool << C_END << std::endl;
+
+	pool_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Arena tests ] " << C_END << std::endl;
+	static std::string description_arena = \
+	"This tests the arena. A reset should free everything at once,\n"
+	"and destroy the registered classes in the reverse order of construction.\n";
+	std::cout << C_CYAN << description_arena << C_END << std::endl;
+
+	arena_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Stack tests ] " << C_END << std::endl;
+	static std::string description_stack = \
+	"This tests the stack. Freeing in reverse order or going back to a marker\n"
+	"should give back exactly the memory allocated after it, even in nested scopes.\n";
+	std::cout << C_CYAN << description_stack << C_END << std::endl;
+
+	stack_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Buddy tests ] " << C_END << std::endl;
+	static std::string description_buddy = \
+	"This tests the buddy allocator. Blocks should be split as needed,\n"
+	"and freeing everything should merge the blocks back together.\n";
+	std::cout << C_CYAN << description_buddy << C_END << std::endl;
+
+	buddy_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ TLSF tests ] " << C_END << std::endl;
+	static std::string description_tlsf = \
+	"This tests the TLSF allocator. Random allocations should never overlap,\n"
+	"and freeing everything should merge the memory back into a single block.\n";
+	std::cout << C_CYAN << description_tlsf << C_END << std::endl;
+
+	tlsf_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Reallocation tests ] " << C_END << std::endl;
+	static std::string description_realloc = \
+	"This tests resizing allocations. The free list & TLSF should resize in place\n"
+	"when there is room, and every allocator should keep the data when moving it.\n";
+	std::cout << C_CYAN << description_realloc << C_END << std::endl;
+
+	realloc_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Bulk allocation tests ] " << C_END << std::endl;
+	static std::string description_bulk = \
+	"This tests allocating & freeing many blocks at once. The free list should carve\n"
+	"them out of one free block, and merge them back together when they are freed.\n";
+	std::cout << C_CYAN << description_bulk << C_END << std::endl;
+
+	bulk_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Array tests ] " << C_END << std::endl;
+	static std::string description_array = \
+	"This tests allocating arrays of classes, and forwarding arguments to constructors.\n"
+	"Every element should be built & destroyed once, and no argument should be copied.\n";
+	std::cout << C_CYAN << description_array << C_END << std::endl;
+
+	array_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Static front-end tests ] " << C_END << std::endl;
+	static std::string description_static = \
+	"This tests emma::Allocator<Policy>, which calls the allocator without the vtable.\n"
+	"It should behave exactly the same as calling the allocator through a BaseAllocator&.\n";
+	std::cout << C_CYAN << description_static << C_END << std::endl;
+
+	static_allocator_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Standard library adapter tests ] " << C_END << std::endl;
+	static std::string description_std_adapter = \
+	"This tests standard containers using emma::StdAllocator<T> & emma::MemoryResource.\n"
+	"All of their memory should come from the heap, aligned to what they asked for.\n";
+	std::cout << C_CYAN << description_std_adapter << C_END << std::endl;
+
+	std_adapter_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Statistics tests ] " << C_END << std::endl;
+	static std::string description_stats = \
+	"This tests get_stats(). The free blocks it measures should match the heap,\n"
+	"and with EMMA_ENABLE_STATS, the counters should match every allocation made.\n";
+	std::cout << C_CYAN << description_stats << C_END << std::endl;
+
+	stats_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Heap walker tests ] " << C_END << std::endl;
+	static std::string description_heap_walk = \
+	"This tests walking the blocks of a FreeList. Every block should be visited once,\n"
+	"together they should cover the whole memory, and the free ones should match the tree.\n";
+	std::cout << C_CYAN << description_heap_walk << C_END << std::endl;
+
+	heap_walk_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Compact FreeList tests ] " << C_END << std::endl;
+	static std::string description_compact = \
+	"This tests the overhead of each FreeList allocation. With EMMA_COMPACT_FREELIST,\n"
+	"headers & nodes should be smaller, so that more small allocations fit in the same memory.\n";
+	std::cout << C_CYAN << description_compact << C_END << std::endl;
+
+	compact_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Red-black tree chain tests ] " << C_END << std::endl;
+	static std::string description_chain = \
+	"This tests the nodes of the same value, chained behind one in the red-black tree.\n"
+	"Removing any of them should leave a valid tree, where best fits are still found.\n";
+	std::cout << C_CYAN << description_chain << C_END << std::endl;
+
+	chain_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Small bin tests ] " << C_END << std::endl;
+	static std::string description_small_bin = \
+	"This tests the FreeList's exact size bins around SMALL_BIN_MAX_SIZE. Free blocks\n"
+	"should go into a bin or the tree by their size, and be found again from either.\n";
+	std::cout << C_CYAN << description_small_bin << C_END << std::endl;
+
+	small_bin_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Deferred coalescing tests ] " << C_END << std::endl;
+	static std::string description_deferred = \
+	"This tests a FreeList with deferred coalescing. Freed blocks should be reused as they are,\n"
+	"and still be merged back into one block once consolidated.\n";
+	std::cout << C_CYAN << description_deferred << C_END << std::endl;
+
+	deferred_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Persistent heap tests ] " << C_END << std::endl;
+	static std::string description_persistent = \
+	"This tests a FreeList inside an mmap'd file. The heap should open again with every\n"
+	"allocation & root intact, even from a copy at another address.\n";
+	std::cout << C_CYAN << description_persistent << C_END << std::endl;
+
+	persistent_tests();
+
+	// Throw the title + description in the terminal
+	std::cout << "\n" << std::endl;
+	std::cout << FG_BLACK << BG_CYAN << " [ Trace recording tests ] " << C_END << std::endl;
+	static std::string description_trace = \
+	"This tests TraceRecorder. Every allocation & free should be in the trace,\n"
+	"in the same order, so that 'make emma_replay' can replay it against any allocator.\n";
+	std::cout << C_CYAN << description_trace << C_END << std::endl;
+
+	trace_tests();
+
 	// Throw the title + description in the terminal
 	std::cout << "\n" << std::endl;
 	std::cout << FG_BLACK << BG_CYAN << " [ Benchmarking test ] " << C_END << std::endl;
@@ -0,0 +1,146 @@
+/* [ TESTS OF THE PERSISTENT FREELIST ]
+ *
+ *   Tests a FreeList inside an mmap'd file. After the file is unmapped &
+ *   mapped again, or the region is copied somewhere else, the heap has to
+ *   open with every allocation & root where it was left. A region with a
+ *   broken superblock must not open at all.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define PERSISTENT_TEST_ALLOCATIONS 200
+
+void persistent_tests()
+{
+	typedef emma::allocators::FreeList	FreeList;
+
+	char path[] = "/tmp/emma_persistent_XXXXXX";
+	int fd = mkstemp(path);
+	assert(fd != -1 && ftruncate(fd, MEMSIZE) == 0);
+
+	std::cout << "1. Creating a heap in a mapped file" << std::endl;
+	std::vector<std::pair<std::size_t, std::size_t>> offsets; // Of the allocations from the region's start, & sizes
+	emma::Stats stats_before;
+	{
+		void* region = mmap(NULL, MEMSIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		assert(region != MAP_FAILED);
+		FreeList	EMMA(FreeList::CREATE_PERSISTENT, region, MEMSIZE);
+		assert(FreeList::has_persistent_heap(region, MEMSIZE));
+
+		// Every other allocation is freed, so the heap has free blocks to rebuild.
+		// Some are aligned to 256 bytes, leaving gaps in front of them.
+		for (int i = 0; i < PERSISTENT_TEST_ALLOCATIONS; ++i)
+		{
+			std::size_t size = 1 + i * 7 % 500;
+			uint8_t* ptr = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(size, i % 10 == 0 ? 256 : 1));
+			assert(ptr != NULL);
+			std::memset(ptr, static_cast<int>(size), size);
+			if (i % 2 == 1)
+				EMMA.free_raw_ptr(ptr);
+			else
+				offsets.push_back(std::make_pair(static_cast<std::size_t>(ptr - static_cast<uint8_t*>(region)), size));
+		}
+		assert(EMMA.set_root("first", static_cast<uint8_t*>(region) + offsets.front().first));
+		assert(EMMA.set_root("last", static_cast<uint8_t*>(region) + offsets.back().first));
+		assert(EMMA.set_root("removed", static_cast<uint8_t*>(region) + offsets.back().first));
+		assert(EMMA.set_root("removed", NULL));
+		assert(!EMMA.set_root("outside", g_emmas_memory));
+		stats_before = EMMA.get_stats();
+		assert(munmap(region, MEMSIZE) == 0);
+	}
+	std::cout << "-  " << offsets.size() << " allocations & 2 roots were left in the file" << std::endl;
+
+	std::cout << "2. Opening the heap again from the file" << std::endl;
+	{
+		void* region = mmap(NULL, MEMSIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		assert(region != MAP_FAILED);
+		FreeList	EMMA(FreeList::OPEN_EXISTING, region, MEMSIZE);
+		assert(EMMA.get_root("first") == static_cast<uint8_t*>(region) + offsets.front().first);
+		assert(EMMA.get_root("last") == static_cast<uint8_t*>(region) + offsets.back().first);
+		assert(EMMA.get_root("removed") == NULL);
+
+		for (const std::pair<std::size_t, std::size_t>& offset : offsets)
+		{
+			uint8_t* ptr = static_cast<uint8_t*>(region) + offset.first;
+			assert(EMMA.usable_size(ptr) >= offset.second);
+			assert(ptr[0] == static_cast<uint8_t>(offset.second) && ptr[offset.second - 1] == ptr[0]);
+		}
+		assert(EMMA.get_stats().free_block_count == stats_before.free_block_count);
+		assert(EMMA.get_stats().free_bytes == stats_before.free_bytes);
+
+		// The region keeps the heap as it was, so copy it before freeing everything
+		std::vector<uint8_t> copy(static_cast<uint8_t*>(region), static_cast<uint8_t*>(region) + MEMSIZE);
+		for (const std::pair<std::size_t, std::size_t>& offset : offsets)
+			EMMA.free_raw_ptr(static_cast<uint8_t*>(region) + offset.first);
+		assert(EMMA.get_stats().free_block_count == 1);
+		std::memcpy(region, copy.data(), MEMSIZE);
+		assert(munmap(region, MEMSIZE) == 0);
+	}
+	std::cout << "-  Every allocation & root was still there" << std::endl;
+
+	std::cout << "3. Opening a copy of the heap at another address" << std::endl;
+	{
+		void* region = mmap(NULL, MEMSIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		assert(region != MAP_FAILED);
+
+		// The region was page aligned, so the copy has to be too
+		std::size_t max_alignment = FreeList::PERSISTENT_MAX_ALIGNMENT;
+		uint8_t* copy = static_cast<uint8_t*>(std::aligned_alloc(max_alignment, MEMSIZE + max_alignment));
+		assert(copy != NULL);
+		std::memcpy(copy + 8, region, MEMSIZE);
+		assert(!FreeList::has_persistent_heap(copy + 8, MEMSIZE));
+		FreeList	MISALIGNED(FreeList::OPEN_EXISTING, copy + 8, MEMSIZE);
+		assert(MISALIGNED.allocate_raw_ptr(16) == NULL);
+
+		std::memcpy(copy, region, MEMSIZE);
+		FreeList	EMMA(FreeList::OPEN_EXISTING, copy, MEMSIZE);
+		assert(EMMA.get_root("first") == copy + offsets.front().first);
+
+		FreeList::BlockInfo block;
+		std::size_t used_blocks = 0;
+		while (EMMA.walk_heap(block))
+			used_blocks += !block.is_free;
+		assert(used_blocks == offsets.size());
+
+		for (const std::pair<std::size_t, std::size_t>& offset : offsets)
+			EMMA.free_raw_ptr(copy + offset.first);
+		assert(EMMA.get_stats().free_block_count == 1);
+		assert(munmap(region, MEMSIZE) == 0);
+		std::free(copy);
+	}
+	std::cout << "-  The copy opened & merged back into one block, but not at a lesser alignment" << std::endl;
+
+	std::cout << "4. Opening regions that don't hold a heap" << std::endl;
+	{
+		std::memset(g_emmas_memory, 0, MEMSIZE);
+		assert(!FreeList::has_persistent_heap(g_emmas_memory, MEMSIZE));
+		FreeList	EMPTY(FreeList::OPEN_EXISTING, g_emmas_memory, MEMSIZE);
+		assert(EMPTY.allocate_raw_ptr(16) == NULL);
+
+		// A valid superblock, but the first block's size goes past the end
+		{
+			FreeList	EMMA(FreeList::CREATE_PERSISTENT, g_emmas_memory, MEMSIZE);
+			assert(EMMA.allocate_raw_ptr(100) != NULL);
+		}
+		assert(FreeList::has_persistent_heap(g_emmas_memory, MEMSIZE));
+		assert(!FreeList::has_persistent_heap(g_emmas_memory, MEMSIZE - 8));
+		*reinterpret_cast<FreeList::Header::Tag*>(static_cast<uint8_t*>(g_emmas_memory)
+			+ sizeof(FreeList::PersistentSuperblock)) = MEMSIZE;
+		FreeList	BROKEN(FreeList::OPEN_EXISTING, g_emmas_memory, MEMSIZE);
+		assert(BROKEN.allocate_raw_ptr(16) == NULL && BROKEN.get_root("first") == NULL);
+	}
+	std::cout << "-  Neither one opened" << std::endl;
+
+	close(fd);
+	unlink(path);
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - the heap was reopened as it was left \n" << C_END << std::endl;
+}
@@ -0,0 +1,138 @@
+/* [ TESTS OF THE POOL ALLOCATOR ]
+ *
+ *   First tests that every block of the pool can be allocated exactly once.
+ *
+ *   Then producer threads allocate messages from one pool, while consumer
+ *   threads free them at the same time. The pool is kept small on purpose,
+ *   so that the same blocks are recycled constantly. Any ABA problem in the
+ *   lock-free stack would hand out one block twice, which the checks catch.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <stdint.h>
+
+#define POOL_TEST_MESSAGES  200000
+#define POOL_TEST_THREADS   2 // Producers, and as many consumers
+
+class PoolMessage
+{
+	public:
+		PoolMessage(int id) : m_id(id), m_check(~id) {}
+		~PoolMessage() {}
+		bool isValid() { return (m_check == ~m_id); }
+	private:
+		int		m_id;
+		int		m_check;
+		char	payload[48];
+};
+
+static void pool_test_single_thread()
+{
+	emma::allocators::Pool	EMMA(g_emmas_memory, 4096, sizeof(PoolMessage));
+	std::vector<PoolMessage*>	messages;
+
+	std::cout << "1. Allocating until the pool runs out of blocks" << std::endl;
+	PoolMessage* message;
+	while ((message = EMMA.allocate_class<PoolMessage>(42)) != NULL)
+	{
+		assert(reinterpret_cast<uintptr_t>(message) % alignof(PoolMessage) == 0);
+		messages.push_back(message);
+	}
+	assert(messages.size() == EMMA.get_block_count());
+	std::cout << "-  Got all " << messages.size() << " blocks" << std::endl;
+
+	std::cout << "2. Freeing all blocks and allocating them again" << std::endl;
+	for (PoolMessage* ptr : messages)
+		EMMA.free_class(ptr);
+	for (std::size_t i = 0; i < messages.size(); ++i)
+		{ assert(EMMA.allocate_class<PoolMessage>(42) != NULL); }
+	assert(EMMA.allocate_class<PoolMessage>(42) == NULL);
+	std::cout << "-  Got all " << messages.size() << " blocks again" << std::endl;
+}
+
+static void pool_test_producer(emma::allocators::Pool* pool, std::mutex* queue_mutex,
+std::deque<PoolMessage*>* queue, int first_id)
+{
+	for (int i = 0; i < POOL_TEST_MESSAGES; ++i)
+	{
+		PoolMessage* message;
+		while ((message = pool->allocate_class<PoolMessage>(first_id + i)) == NULL)
+			std::this_thread::yield(); // Pool is empty, wait for the consumers
+
+		std::lock_guard<std::mutex> lock(*queue_mutex);
+		queue->push_back(message);
+	}
+}
+
+static void pool_test_consumer(emma::allocators::Pool* pool, std::mutex* queue_mutex,
+std::deque<PoolMessage*>* queue, std::atomic<int>* consumed, bool* success)
+{
+	*success = true;
+	while (consumed->load() < POOL_TEST_MESSAGES * POOL_TEST_THREADS)
+	{
+		PoolMessage* message = NULL;
+		{
+			std::lock_guard<std::mutex> lock(*queue_mutex);
+			if (!queue->empty())
+			{
+				message = queue->front();
+				queue->pop_front();
+			}
+		}
+		if (message == NULL)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		if (!message->isValid())
+			*success = false;
+		pool->free_class(message);
+		++(*consumed);
+	}
+}
+
+static void pool_test_multi_thread()
+{
+	emma::allocators::Pool	EMMA(g_emmas_memory, 64 * sizeof(PoolMessage), sizeof(PoolMessage));
+	std::mutex					queue_mutex;
+	std::deque<PoolMessage*>	queue;
+	std::atomic<int>			consumed(0);
+	std::vector<std::thread>	threads;
+	bool	success[POOL_TEST_THREADS];
+
+	std::cout << "3. " << POOL_TEST_THREADS << " producers & " << POOL_TEST_THREADS
+	<< " consumers passing " << POOL_TEST_MESSAGES * POOL_TEST_THREADS
+	<< " messages through a pool of " << EMMA.get_block_count() << " blocks" << std::endl;
+
+	for (int i = 0; i < POOL_TEST_THREADS; ++i)
+	{
+		threads.emplace_back(pool_test_producer, &EMMA, &queue_mutex, &queue, i * POOL_TEST_MESSAGES);
+		threads.emplace_back(pool_test_consumer, &EMMA, &queue_mutex, &queue, &consumed, &success[i]);
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	for (int i = 0; i < POOL_TEST_THREADS; ++i)
+		{ assert(success[i]); }
+
+	// Everything was freed, so every block should be available again
+	std::size_t available = 0;
+	while (EMMA.allocate_raw_ptr(sizeof(PoolMessage)) != NULL)
+		++available;
+	assert(available == EMMA.get_block_count());
+	std::cout << "-  All messages arrived intact, and all blocks were returned" << std::endl;
+}
+
+void pool_tests()
+{
+	pool_test_single_thread();
+	pool_test_multi_thread();
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - every block was handed out exactly once\n" << C_END << std::endl;
+}
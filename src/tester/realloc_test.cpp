@@ -0,0 +1,192 @@
+/* [ TESTS OF REALLOCATION ]
+ *
+ *   Tests that the free list & TLSF resize in place when the block on their
+ *   right is free, and give the tail back when shrinking.
+ *   Then reallocates random sizes with every allocator that takes any size,
+ *   checking that the data survives every move and usable_size() is honest.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <random>
+#include <stdint.h>
+#include <cstring>
+
+#define REALLOC_TEST_ROUNDS 50000
+
+class ReallocTestAllocation
+{
+	public:
+		uint8_t*	ptr;
+		std::size_t	size;
+		uint8_t		pattern;
+};
+
+static bool realloc_test_pattern_holds(uint8_t* ptr, std::size_t size, uint8_t pattern)
+{
+	for (std::size_t i = 0; i < size; ++i)
+		if (ptr[i] != pattern)
+			return false;
+	return true;
+}
+
+static void realloc_test_in_place(emma::BaseAllocator& EMMA, const char* name)
+{
+	std::cout << "- " << name << std::endl;
+
+	// Grows into the free block on it's right
+	uint8_t* first = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(100));
+	uint8_t* second = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(1000));
+	uint8_t* third = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(100));
+	uint8_t* blocker = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(100)); // Keeps third from growing
+	assert(first != NULL && second != NULL && third != NULL && blocker != NULL);
+	std::memset(first, 1, 100);
+	EMMA.free_raw_ptr(second);
+	assert(EMMA.reallocate_raw_ptr(first, 800) == first);
+	assert(EMMA.usable_size(first) >= 800);
+	assert(realloc_test_pattern_holds(first, 100, 1));
+	std::cout << "  Grew 100 -> 800 bytes in place" << std::endl;
+
+	// Shrinking gives the tail back, which the next allocation can use
+	assert(EMMA.reallocate_raw_ptr(first, 50) == first);
+	assert(realloc_test_pattern_holds(first, 50, 1));
+	uint8_t* tail = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(500));
+	assert(tail > first && tail < third);
+	std::cout << "  Shrank 800 -> 50 bytes in place, and the tail was reused" << std::endl;
+
+	// No room on the right, so it has to move
+	std::memset(third, 3, 100);
+	uint8_t* moved = static_cast<uint8_t*>(EMMA.reallocate_raw_ptr(third, 4000));
+	assert(moved != NULL && moved != third);
+	assert(realloc_test_pattern_holds(moved, 100, 3));
+	std::cout << "  Moved 100 -> 4000 bytes, and the data came along" << std::endl;
+
+	EMMA.free_raw_ptr(first);
+	EMMA.free_raw_ptr(tail);
+	EMMA.free_raw_ptr(moved);
+	assert(EMMA.reallocate_raw_ptr(blocker, 0) == NULL); // Same as freeing it
+}
+
+static void realloc_test_random(emma::BaseAllocator& EMMA, const char* name)
+{
+	std::cout << "- " << name << std::endl;
+
+	std::mt19937 rng(42);
+	std::vector<ReallocTestAllocation> allocations;
+	for (int i = 0; i < REALLOC_TEST_ROUNDS; ++i)
+	{
+		unsigned int action = allocations.empty() ? 0 : rng() % 4;
+		std::size_t new_size = (rng() % 8 == 0) ? 1 + rng() % 4000 : 1 + rng() % 200;
+		if (action == 0)
+		{
+			ReallocTestAllocation allocation;
+			allocation.size = new_size;
+			allocation.pattern = static_cast<uint8_t>(i);
+			allocation.ptr = static_cast<uint8_t*>(EMMA.reallocate_raw_ptr(NULL, new_size));
+			if (allocation.ptr == NULL)
+				continue;
+			std::memset(allocation.ptr, allocation.pattern, allocation.size);
+			allocations.push_back(allocation);
+			continue;
+		}
+
+		std::size_t index = rng() % allocations.size();
+		ReallocTestAllocation& allocation = allocations[index];
+		assert(EMMA.usable_size(allocation.ptr) >= allocation.size);
+		assert(realloc_test_pattern_holds(allocation.ptr, allocation.size, allocation.pattern));
+		if (action == 1)
+		{
+			EMMA.free_raw_ptr(allocation.ptr);
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+			continue;
+		}
+
+		uint8_t* ptr = static_cast<uint8_t*>(EMMA.reallocate_raw_ptr(allocation.ptr, new_size));
+		if (ptr == NULL)
+			continue; // Out of memory, the old data must still be there
+		std::size_t kept = allocation.size < new_size ? allocation.size : new_size;
+		assert(realloc_test_pattern_holds(ptr, kept, allocation.pattern));
+		std::memset(ptr, allocation.pattern, new_size);
+		allocation.ptr = ptr;
+		allocation.size = new_size;
+	}
+
+	for (ReallocTestAllocation& allocation : allocations)
+	{
+		assert(realloc_test_pattern_holds(allocation.ptr, allocation.size, allocation.pattern));
+		EMMA.free_raw_ptr(allocation.ptr);
+	}
+	std::cout << "  " << REALLOC_TEST_ROUNDS << " random reallocations kept their data" << std::endl;
+}
+
+static void realloc_test_newest_only(emma::BaseAllocator& EMMA, const char* name)
+{
+	std::cout << "- " << name << std::endl;
+
+	uint8_t* older = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(100));
+	uint8_t* newest = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(100));
+	assert(older != NULL && newest != NULL);
+	std::memset(older, 1, 100);
+	std::memset(newest, 2, 100);
+
+	assert(EMMA.usable_size(older) == 0);
+	assert(EMMA.usable_size(newest) == 100);
+	assert(EMMA.reallocate_raw_ptr(newest, 5000) == newest);
+	assert(EMMA.usable_size(newest) == 5000);
+	assert(EMMA.reallocate_raw_ptr(newest, 10) == newest);
+	assert(realloc_test_pattern_holds(newest, 10, 2));
+
+	uint8_t* moved = static_cast<uint8_t*>(EMMA.reallocate_raw_ptr(older, 200));
+	assert(moved > newest);
+	assert(realloc_test_pattern_holds(moved, 100, 1));
+	std::cout << "  The newest allocation was resized in place, an older one was moved" << std::endl;
+}
+
+void realloc_tests()
+{
+	std::cout << "1. Resizing in place" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		realloc_test_in_place(EMMA, "FreeList");
+	}
+	{
+		emma::allocators::TLSF	EMMA(g_emmas_memory, MEMSIZE);
+		realloc_test_in_place(EMMA, "TLSF");
+	}
+	{
+		emma::allocators::Arena	EMMA(g_emmas_memory, MEMSIZE);
+		realloc_test_newest_only(EMMA, "Arena");
+	}
+	{
+		emma::allocators::Stack	EMMA(g_emmas_memory, MEMSIZE);
+		realloc_test_newest_only(EMMA, "Stack");
+	}
+
+	std::cout << "2. Random reallocations" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		realloc_test_random(EMMA, "FreeList");
+	}
+	{
+		emma::allocators::Slab	EMMA(g_emmas_memory, MEMSIZE);
+		realloc_test_random(EMMA, "Slab");
+	}
+	{
+		emma::allocators::TLSF	EMMA(g_emmas_memory, MEMSIZE);
+		realloc_test_random(EMMA, "TLSF");
+	}
+	{
+		emma::allocators::Buddy	EMMA(g_emmas_memory, MEMSIZE);
+		realloc_test_random(EMMA, "Buddy");
+	}
+	{
+		emma::allocators::SharedFreeList	shared_heap(g_emmas_memory, MEMSIZE);
+		emma::allocators::ThreadCache		EMMA(shared_heap);
+		realloc_test_random(EMMA, "ThreadCache");
+	}
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - data survived every reallocation \n" << C_END << std::endl;
+}
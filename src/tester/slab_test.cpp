@@ -0,0 +1,56 @@
+/* [ TESTS OF THE SLAB ALLOCATOR ]
+ *
+ *   Tests that small objects come from the slabs, and are reused in O(1).
+ *   Also tests that large allocations still work through the free list.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <stdint.h>
+
+void slab_tests()
+{
+	emma::allocators::Slab	EMMA(g_emmas_memory, MEMSIZE);
+	static SmallClass*	ptr_array[1000];
+
+	std::cout << "1. Allocating 1000 small classes" << std::endl;
+	for (int i = 0; i < 1000; ++i)
+	{
+		ptr_array[i] = EMMA.allocate_class<SmallClass>(i);
+		assert(ptr_array[i] != NULL);
+		assert(ptr_array[i]->getNumber() == i);
+
+		// Rounded up to the smallest size class, which is naturally aligned
+		assert(reinterpret_cast<uintptr_t>(ptr_array[i])
+			% emma::allocators::Slab::MIN_CLASS_SIZE == 0);
+	}
+	for (int i = 0; i < 1000; ++i)
+		{ assert(ptr_array[i]->getNumber() == i); }
+	std::cout << "-  All classes were constructed & kept their values" << std::endl;
+
+	std::cout << "2. Freeing one class and allocating it again" << std::endl;
+	SmallClass* freed = ptr_array[500];
+	EMMA.free_class(ptr_array[500]);
+	ptr_array[500] = EMMA.allocate_class<SmallClass>(500);
+	assert(ptr_array[500] == freed);
+	std::cout << "-  The freed object was reused right away" << std::endl;
+
+	std::cout << "3. Allocating a large class next to the small ones" << std::endl;
+	LargeClass* large = EMMA.allocate_class<LargeClass>(42);
+	assert(large != NULL);
+	assert(large->getNumber() == 42);
+	EMMA.free_class(large);
+	std::cout << "-  Allocation succesful" << std::endl;
+
+	std::cout << "4. Deallocating all classes" << std::endl;
+	for (int i = 0; i < 1000; ++i)
+		EMMA.free_class(ptr_array[i]);
+
+	// Free objects are reused last in, first out
+	SmallClass* again = EMMA.allocate_class<SmallClass>(42);
+	assert(again == ptr_array[999]);
+	EMMA.free_class(again);
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - small & large classes allocated and reused correctly\n" << C_END << std::endl;
+}
@@ -0,0 +1,123 @@
+/* [ TESTS OF THE FREELIST'S SMALL BINS ]
+ *
+ *   Tests the exact size bins around SMALL_BIN_MAX_SIZE, the largest block
+ *   kept in a bin instead of the tree. Free blocks just below, at & just above
+ *   it are made between used blocks, and have to be found in the right place.
+ *   'make test_compact' runs the same with the compact sizes.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <stdint.h>
+
+typedef emma::allocators::FreeList	SmallBinTestFreeList;
+
+#define SMALL_BIN_TEST_ALIGN sizeof(SmallBinTestFreeList::Header)
+
+static void* small_bin_test_allocate_block(SmallBinTestFreeList& EMMA, std::size_t block_size)
+{/* Allocates data that takes exactly a block of this size, header included */
+
+	return EMMA.allocate_raw_ptr(block_size - SMALL_BIN_TEST_ALIGN, SMALL_BIN_TEST_ALIGN);
+}
+
+static std::vector<void*> small_bin_test_make_blocks(SmallBinTestFreeList& EMMA,
+	const std::vector<std::size_t>& block_sizes)
+{/* Makes a used block of each size, with other used blocks between them,
+    and uses up the rest of the memory. Returns the data of the blocks. */
+
+	std::vector<void*> ptrs;
+	for (std::size_t block_size : block_sizes)
+	{
+		ptrs.push_back(small_bin_test_allocate_block(EMMA, block_size));
+		assert(ptrs.back() != NULL);
+		assert(small_bin_test_allocate_block(EMMA, SmallBinTestFreeList::MIN_BLOCK_SIZE) != NULL);
+	}
+	assert(EMMA.allocate_raw_ptr(EMMA.get_stats().largest_free_block, SMALL_BIN_TEST_ALIGN) != NULL);
+	assert(EMMA.get_stats().free_block_count == 0);
+	return ptrs;
+}
+
+static void small_bin_test_expect(SmallBinTestFreeList& EMMA, std::size_t free_blocks, std::size_t in_tree)
+{/* Checks how many free blocks there are, & if some of them are in the tree */
+
+	emma::Stats stats = EMMA.get_stats();
+	assert(stats.free_block_count == free_blocks);
+	assert(stats.tree_depth == in_tree);
+}
+
+void small_bin_tests()
+{
+	const std::size_t MAX = SmallBinTestFreeList::SMALL_BIN_MAX_SIZE;
+	const std::size_t ALIGN = SMALL_BIN_TEST_ALIGN;
+	const std::size_t MIN = SmallBinTestFreeList::MIN_BLOCK_SIZE;
+
+	std::cout << "1. Freeing blocks of " << MAX - ALIGN << ", " << MAX << " & " << MAX + ALIGN << " bytes" << std::endl;
+	# if EMMA_COMPACT_FREELIST
+	assert(MAX == 280);
+	# else
+	assert(MAX == 568);
+	# endif
+	{
+		SmallBinTestFreeList	EMMA(g_emmas_memory, MEMSIZE);
+		std::vector<void*> ptrs = small_bin_test_make_blocks(EMMA, {MAX - ALIGN, MAX, MAX + ALIGN});
+
+		// Only the last one is too large for a bin, & goes into the tree
+		EMMA.free_raw_ptr(ptrs[0]);
+		small_bin_test_expect(EMMA, 1, 0);
+		EMMA.free_raw_ptr(ptrs[1]);
+		small_bin_test_expect(EMMA, 2, 0);
+		assert(EMMA.get_stats().largest_free_block == MAX - ALIGN);
+		EMMA.free_raw_ptr(ptrs[2]);
+		small_bin_test_expect(EMMA, 3, 1);
+		assert(EMMA.get_stats().largest_free_block == MAX);
+	}
+	std::cout << "-  Blocks up to " << MAX << " bytes went into bins, the larger one into the tree" << std::endl;
+
+	std::cout << "2. Allocating when the exact bin is empty" << std::endl;
+	{
+		SmallBinTestFreeList	EMMA(g_emmas_memory, MEMSIZE);
+		std::vector<void*> ptrs = small_bin_test_make_blocks(EMMA, {MAX - ALIGN, MAX, MAX + ALIGN});
+		for (void* ptr : ptrs)
+			EMMA.free_raw_ptr(ptr);
+
+		// The bitmap finds the next bin that isn't empty, the tree only after the bins
+		assert(small_bin_test_allocate_block(EMMA, MAX - 2 * ALIGN) == ptrs[0]);
+		small_bin_test_expect(EMMA, 2, 1);
+		assert(small_bin_test_allocate_block(EMMA, MAX - ALIGN) == ptrs[1]);
+		small_bin_test_expect(EMMA, 1, 1);
+		assert(small_bin_test_allocate_block(EMMA, MAX - ALIGN) == ptrs[2]);
+		small_bin_test_expect(EMMA, 0, 0);
+	}
+	std::cout << "-  The smallest larger bin was used, then the tree" << std::endl;
+
+	std::cout << "3. Splitting blocks, with the rest just at & above " << MAX << " bytes" << std::endl;
+	{
+		SmallBinTestFreeList	EMMA(g_emmas_memory, MEMSIZE);
+		std::vector<void*> ptrs = small_bin_test_make_blocks(EMMA, {MIN + MAX, MIN + MAX + ALIGN, MAX});
+		for (void* ptr : ptrs)
+			EMMA.free_raw_ptr(ptr);
+		small_bin_test_expect(EMMA, 3, 2);
+
+		// The bin of MAX bytes is taken first, & it's rest goes into a smaller bin
+		assert(small_bin_test_allocate_block(EMMA, MIN) == ptrs[2]);
+		small_bin_test_expect(EMMA, 3, 2);
+		assert(small_bin_test_allocate_block(EMMA, MAX - MIN) == static_cast<uint8_t*>(ptrs[2]) + MIN);
+		small_bin_test_expect(EMMA, 2, 2);
+
+		// The rest of MAX bytes is binned, the rest of MAX + ALIGN stays in the tree
+		assert(small_bin_test_allocate_block(EMMA, MIN) == ptrs[0]);
+		small_bin_test_expect(EMMA, 2, 1);
+		assert(EMMA.get_stats().largest_free_block == MIN + MAX);
+		assert(small_bin_test_allocate_block(EMMA, MAX) == static_cast<uint8_t*>(ptrs[0]) + MIN);
+		small_bin_test_expect(EMMA, 1, 1);
+		assert(small_bin_test_allocate_block(EMMA, MIN) == ptrs[1]);
+		small_bin_test_expect(EMMA, 1, 1);
+		assert(small_bin_test_allocate_block(EMMA, MAX + ALIGN) == static_cast<uint8_t*>(ptrs[1]) + MIN);
+		small_bin_test_expect(EMMA, 0, 0);
+	}
+	std::cout << "-  Every rest was put where it belongs, & found again" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - free blocks were binned on the right side of " << MAX << " bytes \n" << C_END << std::endl;
+}
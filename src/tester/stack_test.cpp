@@ -0,0 +1,80 @@
+/* [ TESTS OF THE STACK ALLOCATOR ]
+ *
+ *   Frees in reverse order and checks that the top goes back exactly
+ *   to where it was. Then does the same with markers & nested scopes.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <stdint.h>
+
+static void stack_test_lifo()
+{
+	emma::allocators::Stack	EMMA(g_emmas_memory, 4096);
+
+	std::cout << "1. Allocating classes of different sizes & freeing them in reverse" << std::endl;
+	emma::allocators::Stack::Marker start = EMMA.get_marker();
+	char* chr = static_cast<char*>(EMMA.allocate_raw_ptr(1));
+	LargeClass* large = EMMA.allocate_class<LargeClass>(42);
+	emma::allocators::Stack::Marker after_large = EMMA.get_marker();
+	SmallClass* small = EMMA.allocate_class<SmallClass>(42);
+	void* aligned = EMMA.allocate_raw_ptr(8, 128);
+
+	assert(chr != NULL && large != NULL && small != NULL && aligned != NULL);
+	assert(reinterpret_cast<uintptr_t>(large) % alignof(LargeClass) == 0);
+	assert(reinterpret_cast<uintptr_t>(small) % alignof(SmallClass) == 0);
+	assert(reinterpret_cast<uintptr_t>(aligned) % 128 == 0);
+
+	EMMA.free_raw_ptr(aligned);
+	EMMA.free_class(small);
+	assert(EMMA.get_marker() == after_large);
+	EMMA.free_class(large);
+	EMMA.free_raw_ptr(chr);
+	assert(EMMA.get_marker() == start);
+	std::cout << "-  The top went back to the start" << std::endl;
+
+	std::cout << "2. Freeing an older allocation frees the newer ones too" << std::endl;
+	void* first = EMMA.allocate_raw_ptr(64);
+	EMMA.allocate_raw_ptr(64);
+	EMMA.allocate_raw_ptr(64);
+	EMMA.free_raw_ptr(first);
+	assert(EMMA.get_marker() == start);
+	assert(EMMA.allocate_raw_ptr(64) == first);
+	std::cout << "-  Got the same memory back" << std::endl;
+}
+
+static void stack_test_scopes()
+{
+	emma::allocators::Stack	EMMA(g_emmas_memory, 4096);
+
+	std::cout << "3. Filling up nested scopes" << std::endl;
+	EMMA.allocate_raw_ptr(100);
+	emma::allocators::Stack::Marker outer = EMMA.get_marker();
+	{
+		emma::allocators::Stack::Scope outer_scope(EMMA);
+		EMMA.allocate_class<LargeClass>(42);
+		emma::allocators::Stack::Marker inner = EMMA.get_marker();
+		{
+			emma::allocators::Stack::Scope inner_scope(EMMA);
+			while (EMMA.allocate_class<SmallClass>(42) != NULL) {}
+		}
+		assert(EMMA.get_marker() == inner);
+	}
+	assert(EMMA.get_marker() == outer);
+	std::cout << "-  Every scope freed exactly what was allocated inside of it" << std::endl;
+
+	std::cout << "4. Going back to a marker directly" << std::endl;
+	EMMA.free_to_marker(0);
+	assert(EMMA.get_marker() == 0);
+	assert(EMMA.allocate_raw_ptr(4000) != NULL);
+	std::cout << "-  All of the memory was available again" << std::endl;
+}
+
+void stack_tests()
+{
+	stack_test_lifo();
+	stack_test_scopes();
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - every free went back to exactly the right place\n" << C_END << std::endl;
+}
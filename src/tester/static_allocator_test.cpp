@@ -0,0 +1,110 @@
+/* [ TESTS OF THE STATIC FRONT-END ]
+ *
+ *   Tests that emma::Allocator<Policy> works the same as calling the policy
+ *   through a BaseAllocator&, without having a vtable of it's own.
+ *   Arenas should still register destructors, and arrays should still
+ *   be readable by the base allocator.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <type_traits>
+#include <stdint.h>
+
+#define STATIC_TEST_COUNT 1000
+
+// Nothing in it is virtual, the policy is a member and not a base
+static_assert(!std::is_polymorphic<emma::Allocator<emma::allocators::FreeList>>::value,
+	"Allocator<Policy> should not have a vtable");
+
+class StaticTestCounter // Counts it's destructions
+{
+	public:
+		StaticTestCounter(int i) : m_number(i) {}
+		~StaticTestCounter() { ++s_destroyed; }
+		int getNumber() const { return m_number; }
+
+		static int	s_destroyed;
+	private:
+		int		m_number;
+};
+int	StaticTestCounter::s_destroyed = 0;
+
+template <class Policy, typename... Args>
+static void static_test_same_as_virtual(const char* name, Args... A)
+{
+	std::cout << "- " << name << std::endl;
+
+	// Both start from the same state, so they should make the same choices
+	std::vector<void*> virtual_ptrs, static_ptrs;
+	{
+		Policy	policy(g_emmas_memory, MEMSIZE, A...);
+		emma::BaseAllocator&	EMMA = policy;
+		for (int i = 0; i < STATIC_TEST_COUNT; ++i)
+		{
+			virtual_ptrs.push_back(EMMA.allocate_raw_ptr(1 + i % 64));
+			if (i % 3 == 0)
+				EMMA.free_raw_ptr(virtual_ptrs[i / 2]);
+		}
+	}
+	{
+		emma::Allocator<Policy>	EMMA(g_emmas_memory, MEMSIZE, A...);
+		for (int i = 0; i < STATIC_TEST_COUNT; ++i)
+		{
+			static_ptrs.push_back(EMMA.allocate_raw_ptr(1 + i % 64));
+			if (i % 3 == 0)
+				EMMA.free_raw_ptr(static_ptrs[i / 2]);
+		}
+	}
+	assert(virtual_ptrs == static_ptrs);
+	std::cout << "  " << STATIC_TEST_COUNT << " allocations landed in the same places" << std::endl;
+}
+
+void static_allocator_tests()
+{
+	std::cout << "1. Same results as calling through a BaseAllocator&" << std::endl;
+	static_test_same_as_virtual<emma::allocators::FreeList>("FreeList");
+	static_test_same_as_virtual<emma::allocators::TLSF>("TLSF");
+	static_test_same_as_virtual<emma::allocators::Buddy>("Buddy");
+	static_test_same_as_virtual<emma::allocators::Pool>("Pool", 64);
+
+	std::cout << "2. Classes & arrays" << std::endl;
+	{
+		emma::Allocator<emma::allocators::FreeList>	EMMA(g_emmas_memory, MEMSIZE);
+		LargeClass* large = EMMA.allocate_class<LargeClass>(42);
+		assert(large != NULL && large->getNumber() == 42);
+		assert(reinterpret_cast<uintptr_t>(large) % alignof(LargeClass) == 0);
+		EMMA.free_class(large);
+
+		StaticTestCounter* array = EMMA.allocate_array<StaticTestCounter>(100, 7);
+		assert(array != NULL && array[99].getNumber() == 7);
+		assert(emma::BaseAllocator::get_array_size(array) == 100);
+		// The allocation starts at the count, in front of the array
+		void* allocation = reinterpret_cast<uint8_t*>(array) - sizeof(std::size_t);
+		assert(EMMA.usable_size(allocation) >= sizeof(std::size_t) + 100 * sizeof(StaticTestCounter));
+		EMMA.free_array(array);
+		assert(StaticTestCounter::s_destroyed == 100);
+
+		void* ptr = EMMA.allocate_raw_ptr(100);
+		ptr = EMMA.reallocate_raw_ptr(ptr, 5000);
+		assert(ptr != NULL && EMMA.usable_size(ptr) >= 5000);
+		EMMA.free_raw_ptr(ptr);
+		assert(EMMA.get_policy().allocate_raw_ptr(MEMSIZE / 2) != NULL);
+	}
+	std::cout << "-  Constructed, destroyed & reallocated like through the base allocator" << std::endl;
+
+	std::cout << "3. An arena still registers destructors" << std::endl;
+	{
+		emma::Allocator<emma::allocators::Arena>	EMMA(g_emmas_memory, MEMSIZE);
+		int destroyed_before = StaticTestCounter::s_destroyed;
+		assert(EMMA.allocate_class<StaticTestCounter>(1) != NULL);
+		assert(EMMA.allocate_array<StaticTestCounter>(9, 2) != NULL);
+		EMMA.get_policy().reset();
+		assert(StaticTestCounter::s_destroyed == destroyed_before + 10);
+	}
+	std::cout << "-  reset() destroyed every class" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - the static front-end behaved like the virtual one \n" << C_END << std::endl;
+}
@@ -0,0 +1,140 @@
+/* [ TESTS OF STATISTICS ]
+ *
+ *   Tests that get_stats() measures the free blocks correctly, and if
+ *   EMMA_ENABLE_STATS is enabled, that the counters add up after random
+ *   allocations, reallocations & bulk frees. 'make test_stats' enables them.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <random>
+#include <stdint.h>
+
+#define STATS_TEST_ROUNDS 20000
+
+static void stats_test_free_blocks(emma::BaseAllocator& EMMA, const char* name)
+{
+	std::cout << "- " << name << std::endl;
+
+	emma::Stats stats = EMMA.get_stats();
+	assert(stats.free_block_count == 1 && stats.largest_free_block == stats.free_bytes);
+	std::size_t all_free_bytes = stats.free_bytes;
+
+	// Every other one freed, and none of them next to each other
+	std::vector<void*> ptrs;
+	for (int i = 0; i < 100; ++i)
+		ptrs.push_back(EMMA.allocate_raw_ptr(64));
+	for (int i = 0; i < 100; i += 2)
+		EMMA.free_raw_ptr(ptrs[i]);
+	stats = EMMA.get_stats();
+	assert(stats.free_block_count == 51); // And the rest of the memory
+	assert(stats.largest_free_block < stats.free_bytes);
+	std::cout << "  " << stats.free_block_count << " free blocks, " << stats.free_bytes << " bytes free";
+	if (stats.tree_depth != 0)
+	{
+		assert(stats.tree_depth == 1); // The small blocks are in bins, only the rest is in the tree
+		std::cout << ", tree depth " << stats.tree_depth;
+	}
+	std::cout << std::endl;
+
+	for (int i = 1; i < 100; i += 2)
+		EMMA.free_raw_ptr(ptrs[i]);
+	stats = EMMA.get_stats();
+	assert(stats.free_block_count == 1 && stats.free_bytes == all_free_bytes);
+
+#if EMMA_ENABLE_STATS
+	assert(stats.allocations == 100 && stats.frees == 100 && stats.live_allocations == 0);
+	assert(stats.bytes_in_use == 0 && stats.peak_bytes_in_use >= 100 * 64);
+	assert(stats.merges >= 50);
+	assert(EMMA.allocate_raw_ptr(MEMSIZE) == NULL);
+	assert(EMMA.get_stats().failed_allocations == 1);
+	std::cout << "  " << stats.merges << " merges, peak of " << stats.peak_bytes_in_use << " bytes in use" << std::endl;
+#endif
+}
+
+#if EMMA_ENABLE_STATS
+static void stats_test_counters(emma::BaseAllocator& EMMA, const char* name)
+{
+	std::cout << "- " << name << std::endl;
+
+	std::mt19937 rng(42);
+	std::vector<void*> ptrs;
+	std::vector<void*> bulk(50);
+	for (int i = 0; i < STATS_TEST_ROUNDS; ++i)
+	{
+		unsigned int action = ptrs.empty() ? 0 : rng() % 5;
+		std::size_t size = 1 + rng() % 300;
+		if (action == 0)
+		{
+			void* ptr = EMMA.allocate_raw_ptr(size);
+			if (ptr != NULL)
+				ptrs.push_back(ptr);
+		}
+		else if (action == 1)
+		{
+			std::size_t made = EMMA.allocate_bulk(size, 1 + rng() % bulk.size(), bulk.data());
+			ptrs.insert(ptrs.end(), bulk.begin(), bulk.begin() + static_cast<long>(made));
+		}
+		else if (action == 2 && ptrs.size() > 20)
+		{
+			// The newest ones are next to each other, so they get joined
+			EMMA.free_bulk(ptrs.data() + ptrs.size() - 20, 20);
+			ptrs.resize(ptrs.size() - 20);
+		}
+		else
+		{
+			std::size_t index = rng() % ptrs.size();
+			void* ptr = EMMA.reallocate_raw_ptr(ptrs[index], action == 3 ? size : 0);
+			if (action == 3 && ptr != NULL)
+				ptrs[index] = ptr;
+			else if (action != 3)
+			{
+				ptrs[index] = ptrs.back();
+				ptrs.pop_back();
+			}
+		}
+
+		emma::Stats stats = EMMA.get_stats();
+		std::size_t bytes_in_use = 0;
+		for (void* ptr : ptrs)
+			bytes_in_use += EMMA.usable_size(ptr);
+		assert(stats.live_allocations == ptrs.size());
+		assert(stats.bytes_in_use == bytes_in_use);
+		assert(stats.allocations - stats.frees == stats.live_allocations);
+	}
+	EMMA.free_bulk(ptrs.data(), ptrs.size());
+	assert(EMMA.get_stats().bytes_in_use == 0 && EMMA.get_stats().free_block_count == 1);
+	std::cout << "  " << EMMA.get_stats().allocations << " allocations, counters matched every step" << std::endl;
+}
+#endif
+
+void stats_tests()
+{
+	std::cout << "1. Measuring free blocks" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		stats_test_free_blocks(EMMA, "FreeList");
+	}
+	{
+		emma::allocators::TLSF	EMMA(g_emmas_memory, MEMSIZE);
+		stats_test_free_blocks(EMMA, "TLSF");
+	}
+
+#if EMMA_ENABLE_STATS
+	std::cout << "2. Counters after random allocations, reallocations & bulk frees" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		stats_test_counters(EMMA, "FreeList");
+	}
+	{
+		emma::allocators::TLSF	EMMA(g_emmas_memory, MEMSIZE);
+		stats_test_counters(EMMA, "TLSF");
+	}
+#else
+	std::cout << "2. Counters are disabled, see EMMA_ENABLE_STATS" << std::endl;
+#endif
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - statistics matched the state of the heap \n" << C_END << std::endl;
+}
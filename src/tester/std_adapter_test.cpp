@@ -0,0 +1,105 @@
+/* [ TESTS OF THE STANDARD LIBRARY ADAPTERS ]
+ *
+ *   Tests that standard containers keep all of their memory inside of the
+ *   heap, through both emma::StdAllocator<T> & emma::MemoryResource.
+ *   Also tests that the requested alignment is honoured, and that running
+ *   out of memory throws like the containers expect it to.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <memory_resource>
+#include <stdint.h>
+
+#define STD_ADAPTER_TEST_COUNT 2000
+
+static bool std_adapter_test_in_heap(const void* ptr)
+{
+	const uint8_t* start = static_cast<const uint8_t*>(g_emmas_memory);
+	return (static_cast<const uint8_t*>(ptr) >= start && static_cast<const uint8_t*>(ptr) < start + MEMSIZE);
+}
+
+void std_adapter_tests()
+{
+	std::cout << "1. std::vector & std::basic_string with StdAllocator<T>" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		std::vector<int, emma::StdAllocator<int>> numbers(EMMA);
+		for (int i = 0; i < STD_ADAPTER_TEST_COUNT; ++i)
+			numbers.push_back(i);
+		assert(std_adapter_test_in_heap(numbers.data()));
+		assert(numbers[STD_ADAPTER_TEST_COUNT - 1] == STD_ADAPTER_TEST_COUNT - 1);
+
+		typedef std::basic_string<char, std::char_traits<char>, emma::StdAllocator<char>> HeapString;
+		HeapString text("A string long enough to not fit the small string buffer", EMMA);
+		assert(std_adapter_test_in_heap(text.data()));
+
+		// Rebound copies share the allocator
+		emma::StdAllocator<double> rebound(numbers.get_allocator());
+		assert(rebound == numbers.get_allocator());
+	}
+	std::cout << "-  Every element was inside of the heap" << std::endl;
+
+	std::cout << "2. std::pmr containers with MemoryResource" << std::endl;
+	{
+		emma::allocators::TLSF	EMMA(g_emmas_memory, MEMSIZE);
+		emma::MemoryResource	resource(EMMA);
+		std::pmr::unordered_map<int, std::pmr::string> names(&resource);
+		for (int i = 0; i < STD_ADAPTER_TEST_COUNT / 10; ++i)
+			names.emplace(i, std::pmr::string(static_cast<std::size_t>(40 + i % 20), 'a' + i % 26));
+		for (auto& pair : names)
+		{
+			assert(std_adapter_test_in_heap(&pair));
+			assert(std_adapter_test_in_heap(pair.second.data()));
+			assert(pair.second[0] == 'a' + pair.first % 26);
+		}
+
+		std::pmr::vector<std::pmr::string> copies(&resource);
+		copies.emplace_back(names[7]);
+		assert(copies[0] == names[7] && std_adapter_test_in_heap(copies[0].data()));
+	}
+	std::cout << "-  Every node & every string was inside of the heap" << std::endl;
+
+	std::cout << "3. Alignment asked for by the container" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE);
+		emma::MemoryResource	resource(EMMA);
+		for (std::size_t alignment = 1; alignment <= 4096; alignment *= 2)
+		{
+			void* ptr = resource.allocate(100, alignment);
+			assert(reinterpret_cast<uintptr_t>(ptr) % alignment == 0);
+			resource.deallocate(ptr, 100, alignment);
+		}
+
+		std::pmr::vector<OverAlignedClass> aligned(&resource);
+		for (int i = 0; i < 100; ++i)
+			aligned.emplace_back(i);
+		assert(reinterpret_cast<uintptr_t>(aligned.data()) % alignof(OverAlignedClass) == 0);
+	}
+	std::cout << "-  Every allocation was aligned to what was asked for" << std::endl;
+
+	std::cout << "4. Running out of memory & comparing resources" << std::endl;
+	{
+		emma::allocators::FreeList	EMMA(g_emmas_memory, MEMSIZE / 2);
+		emma::allocators::FreeList	other_heap(static_cast<uint8_t*>(g_emmas_memory) + MEMSIZE / 2, MEMSIZE / 2);
+		emma::MemoryResource	resource(EMMA), same_heap(EMMA), other(other_heap);
+		assert(resource == same_heap && resource != other);
+
+		bool threw = false;
+		try
+		{
+			void* ptr = resource.allocate(MEMSIZE);
+			resource.deallocate(ptr, MEMSIZE); // Never reached
+		}
+		catch (const std::exception&) // std::bad_alloc, or EMMA's own if enabled
+			{ threw = true; }
+		assert(threw);
+	}
+	std::cout << "-  Throws instead of returning NULL, resources on the same heap are equal" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - containers kept their memory inside of the heap \n" << C_END << std::endl;
+}
@@ -0,0 +1,119 @@
+/* [ MULTI-THREADED TESTS ]
+ *
+ *   Tests that many threads can share one heap, each through it's own cache.
+ *
+ *   Every thread fills it's allocations with it's own id, if two threads were
+ *   ever given the same memory the check before freeing would catch it.
+ *
+ *   Also measures the throughput with a growing amount of threads.
+ *   Threads using their own ThreadCache are compared to threads locking the
+ *   SharedFreeList on every call. The caches should scale with thread count,
+ *   as long as the machine actually has the cores for it.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <thread>
+#include <cstring>
+#include <stdint.h>
+
+#define THREAD_TEST_ITERATIONS 200000
+#define THREAD_TEST_SLOTS      32
+#define THREAD_TEST_MEMSIZE    (16 * 1024 * 1024) // Caches hold on to memory
+
+// Frees & allocates a mix of sizes, success is false if memory was corrupted
+static void thread_test_worker(emma::allocators::SharedFreeList* shared_heap,
+uint8_t thread_id, bool use_cache, bool* success)
+{
+	emma::allocators::ThreadCache	cache(*shared_heap);
+	emma::BaseAllocator&	EMMA = use_cache ?
+		static_cast<emma::BaseAllocator&>(cache) : *shared_heap;
+
+	uint8_t*	slots[THREAD_TEST_SLOTS] = {};
+	std::size_t	sizes[THREAD_TEST_SLOTS] = {};
+
+	*success = true;
+	for (int i = 0; i < THREAD_TEST_ITERATIONS; ++i)
+	{
+		int slot = i % THREAD_TEST_SLOTS;
+		if (slots[slot] != NULL)
+		{
+			if (slots[slot][0] != thread_id || slots[slot][sizes[slot] - 1] != thread_id)
+				*success = false;
+			EMMA.free_raw_ptr(slots[slot]);
+		}
+
+		sizes[slot] = 8 + (i * 37) % 500;
+		slots[slot] = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(sizes[slot]));
+		if (slots[slot] == NULL)
+		{
+			*success = false;
+			return;
+		}
+		memset(slots[slot], thread_id, sizes[slot]);
+	}
+
+	for (int i = 0; i < THREAD_TEST_SLOTS; ++i)
+		EMMA.free_raw_ptr(slots[i]);
+}
+
+// Returns operations per second of all threads combined
+static double run_threads(void* memory, unsigned int thread_count, bool use_cache)
+{
+	emma::allocators::SharedFreeList	shared_heap(memory, THREAD_TEST_MEMSIZE);
+	std::vector<std::thread>	threads;
+	bool	success[16];
+
+	auto begin = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < thread_count; ++i)
+		threads.emplace_back(thread_test_worker, &shared_heap,
+			static_cast<uint8_t>(i + 1), use_cache, &success[i]);
+	for (std::thread& thread : threads)
+		thread.join();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	for (unsigned int i = 0; i < thread_count; ++i)
+		{ assert(success[i]); }
+
+	// Every thread gave everything back, the whole heap should be free again
+	void* everything = shared_heap.allocate_raw_ptr(THREAD_TEST_MEMSIZE / 4);
+	assert(everything != NULL);
+	shared_heap.free_raw_ptr(everything);
+
+	std::chrono::duration<double> seconds = end - begin;
+	return (2.0 * THREAD_TEST_ITERATIONS * thread_count / seconds.count());
+}
+
+void thread_cache_tests()
+{
+	std::cout << "Hardware threads available: "
+	<< std::thread::hardware_concurrency() << "\n" << std::endl;
+
+	void*	memory = malloc(THREAD_TEST_MEMSIZE);
+	double	single_cached = 0;
+	double	single_locked = 0;
+
+	assert(memory != NULL);
+
+	for (unsigned int threads = 1; threads <= 8; threads *= 2)
+	{
+		double cached = run_threads(memory, threads, true);
+		double locked = run_threads(memory, threads, false);
+		if (threads == 1)
+		{
+			single_cached = cached;
+			single_locked = locked;
+		}
+
+		std::cout << " - " << threads << " thread(s) -" << std::endl;
+		std::cout << "ThreadCache   : " << static_cast<long>(cached) << " ops/sec"
+		<< " (x" << cached / single_cached << ")" << std::endl;
+		std::cout << "Locked shared : " << static_cast<long>(locked) << " ops/sec"
+		<< " (x" << locked / single_locked << ")" << std::endl;
+	}
+	free(memory);
+
+	std::cout << "\n" << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - no memory was shared between threads, and all of it was returned\n"
+	<< C_END << std::endl;
+}
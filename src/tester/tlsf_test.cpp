@@ -0,0 +1,123 @@
+/* [ TESTS OF THE TLSF ALLOCATOR ]
+ *
+ *   Allocates & frees random sizes, filling every allocation with a pattern
+ *   and checking it before freeing. Overlapping blocks would break the pattern.
+ *   In the end everything is freed, which should merge back into one block.
+ *   Then the same is done with over-aligned allocations, which split off
+ *   a free block in front of the data.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <stdint.h>
+#include <cstring>
+
+#define TLSF_TEST_ROUNDS 200000
+
+class TLSFTestAllocation
+{
+	public:
+		uint8_t*	ptr;
+		std::size_t	size;
+		uint8_t		pattern;
+};
+
+static std::size_t tlsf_test_largest_allocation(emma::allocators::TLSF& EMMA)
+{
+	std::size_t low = 1, high = MEMSIZE;
+	while (low < high)
+	{
+		std::size_t middle = (low + high + 1) / 2;
+		void* ptr = EMMA.allocate_raw_ptr(middle);
+		if (ptr != NULL)
+		{
+			EMMA.free_raw_ptr(ptr);
+			low = middle;
+		}
+		else
+			high = middle - 1;
+	}
+	return low;
+}
+
+void tlsf_tests()
+{
+	emma::allocators::TLSF	EMMA(g_emmas_memory, MEMSIZE);
+	std::size_t largest = tlsf_test_largest_allocation(EMMA);
+
+	std::cout << "1. " << TLSF_TEST_ROUNDS << " random allocations & frees" << std::endl;
+	std::mt19937 rng(42);
+	std::vector<TLSFTestAllocation> allocations;
+	for (int i = 0; i < TLSF_TEST_ROUNDS; ++i)
+	{
+		if (allocations.empty() || rng() % 3 != 0)
+		{
+			TLSFTestAllocation allocation;
+			allocation.size = (rng() % 8 == 0) ? 1 + rng() % 8000 : 1 + rng() % 200;
+			allocation.pattern = static_cast<uint8_t>(i);
+			allocation.ptr = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(allocation.size));
+			if (allocation.ptr == NULL)
+				continue;
+			assert(reinterpret_cast<uintptr_t>(allocation.ptr) % emma::allocators::TLSF::ALIGNMENT == 0);
+			std::memset(allocation.ptr, allocation.pattern, allocation.size);
+			allocations.push_back(allocation);
+		}
+		else
+		{
+			std::size_t index = rng() % allocations.size();
+			TLSFTestAllocation& allocation = allocations[index];
+			for (std::size_t j = 0; j < allocation.size; ++j)
+				{ assert(allocation.ptr[j] == allocation.pattern); }
+			EMMA.free_raw_ptr(allocation.ptr);
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+		}
+	}
+	std::cout << "-  No allocation was overwritten by another" << std::endl;
+
+	std::cout << "2. Freeing everything that is left" << std::endl;
+	for (TLSFTestAllocation& allocation : allocations)
+		EMMA.free_raw_ptr(allocation.ptr);
+	allocations.clear();
+	assert(tlsf_test_largest_allocation(EMMA) == largest);
+	std::cout << "-  Memory merged back into a single block of " << largest << " bytes" << std::endl;
+
+	std::cout << "3. " << TLSF_TEST_ROUNDS << " random allocations & frees, aligned to 16 - 512 bytes" << std::endl;
+	for (int i = 0; i < TLSF_TEST_ROUNDS; ++i)
+	{
+		if (allocations.empty() || rng() % 3 != 0)
+		{
+			TLSFTestAllocation allocation;
+			std::size_t alignment = std::size_t(16) << (rng() % 6);
+			allocation.size = 1 + rng() % 300;
+			allocation.pattern = static_cast<uint8_t>(i);
+			allocation.ptr = static_cast<uint8_t*>(EMMA.allocate_raw_ptr(allocation.size, alignment));
+			if (allocation.ptr == NULL)
+				continue;
+			assert(reinterpret_cast<uintptr_t>(allocation.ptr) % alignment == 0);
+			std::memset(allocation.ptr, allocation.pattern, allocation.size);
+			allocations.push_back(allocation);
+		}
+		else
+		{
+			std::size_t index = rng() % allocations.size();
+			TLSFTestAllocation& allocation = allocations[index];
+			for (std::size_t j = 0; j < allocation.size; ++j)
+				{ assert(allocation.ptr[j] == allocation.pattern); }
+			EMMA.free_raw_ptr(allocation.ptr);
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+		}
+	}
+	for (TLSFTestAllocation& allocation : allocations)
+		EMMA.free_raw_ptr(allocation.ptr);
+	allocations.clear();
+	assert(tlsf_test_largest_allocation(EMMA) == largest);
+	std::cout << "-  No allocation was overwritten, and everything merged back" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - blocks never overlapped, and all of them merged back\n" << C_END << std::endl;
+}
@@ -0,0 +1,124 @@
+/* [ TESTS OF THE TRACE RECORDER ]
+ *
+ *   Tests that TraceRecorder forwards every call to the allocator, and that
+ *   the trace it writes can be read back: every record is there, in order,
+ *   and every free belongs to an allocation which was live at the time.
+ *
+ *   This file is included directly in the main tester file.
+*/
+
+#include <vector>
+#include <random>
+#include <set>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#define TRACE_TEST_ROUNDS 5000
+
+static std::vector<emma::TraceRecord> trace_test_read(std::FILE* file)
+{
+	std::rewind(file);
+	char magic[sizeof(emma::TRACE_MAGIC)];
+	assert(std::fread(magic, sizeof(magic), 1, file) == 1);
+	assert(std::memcmp(magic, emma::TRACE_MAGIC, sizeof(magic)) == 0);
+
+	std::vector<emma::TraceRecord> records;
+	emma::TraceRecord record;
+	while (std::fread(&record, sizeof(record), 1, file) == 1)
+		records.push_back(record);
+	return records;
+}
+
+void trace_tests()
+{
+	std::cout << "1. Recording random allocations & frees" << std::endl;
+	{
+		std::FILE* file = std::tmpfile();
+		assert(file != NULL);
+
+		emma::allocators::FreeList	heap(g_emmas_memory, MEMSIZE);
+		std::vector<void*> ptrs;
+		std::vector<std::size_t> sizes;
+		std::size_t record_count = 0;
+		{
+			emma::TraceRecorder	EMMA(heap, file);
+			std::mt19937 rng(11);
+			for (int i = 0; i < TRACE_TEST_ROUNDS; ++i)
+			{
+				if (ptrs.empty() || rng() % 3 != 0)
+				{
+					std::size_t size = 1 + rng() % 1000;
+					void* ptr = EMMA.allocate_raw_ptr(size, std::size_t(1) << (rng() % 7));
+					if (ptr != NULL)
+						ptrs.push_back(ptr);
+					sizes.push_back(size);
+				}
+				else
+				{
+					std::size_t index = rng() % ptrs.size();
+					EMMA.free_raw_ptr(ptrs[index]);
+					ptrs[index] = ptrs.back();
+					ptrs.pop_back();
+				}
+			}
+			EMMA.free_raw_ptr(NULL); // Not recorded
+			assert(EMMA.get_stats().free_bytes == heap.get_stats().free_bytes);
+			record_count = EMMA.get_record_count();
+		}
+		assert(record_count == TRACE_TEST_ROUNDS);
+
+		// Flushed by the destructor
+		std::vector<emma::TraceRecord> records = trace_test_read(file);
+		assert(records.size() == record_count);
+
+		std::set<uint64_t> live;
+		std::size_t allocations = 0;
+		for (std::size_t i = 0; i < records.size(); ++i)
+		{
+			if (i > 0)
+				assert(records[i].time >= records[i - 1].time);
+			if (records[i].get_operation() == emma::TraceRecord::ALLOCATE)
+			{
+				assert(records[i].get_size() == sizes[allocations++]);
+				assert(records[i].get_alignment() <= 64);
+				if (records[i].id != 0)
+					assert(live.insert(records[i].id).second);
+			}
+			else
+				assert(live.erase(records[i].id) == 1);
+		}
+		assert(live.size() == ptrs.size());
+		for (void* ptr : ptrs)
+			heap.free_raw_ptr(ptr);
+		std::fclose(file);
+	}
+	std::cout << "-  Every call was recorded, & every free matched a live allocation" << std::endl;
+
+	std::cout << "2. Reallocations are recorded as allocations & frees" << std::endl;
+	{
+		std::FILE* file = std::tmpfile();
+		assert(file != NULL);
+
+		emma::allocators::TLSF	heap(g_emmas_memory, MEMSIZE);
+		{
+			emma::TraceRecorder	EMMA(heap, file);
+			void* ptr = EMMA.allocate_raw_ptr(100);
+			void* blocker = EMMA.allocate_raw_ptr(100);
+			ptr = EMMA.reallocate_raw_ptr(ptr, 5000);
+			assert(ptr != NULL);
+			EMMA.free_raw_ptr(ptr);
+			EMMA.free_raw_ptr(blocker);
+		}
+
+		std::vector<emma::TraceRecord> records = trace_test_read(file);
+		assert(records.size() == 6);
+		assert(records[2].get_operation() == emma::TraceRecord::ALLOCATE && records[2].get_size() == 5000);
+		assert(records[3].get_operation() == emma::TraceRecord::FREE && records[3].id == records[0].id);
+		std::fclose(file);
+	}
+	std::cout << "-  The trace had what the reallocation was made of" << std::endl;
+
+	std::cout << FG_BLACK << BG_GREEN << " SUCCESS " << C_END
+	<< C_GREEN << " - the trace matched every call made \n" << C_END << std::endl;
+}